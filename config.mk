@@ -12,6 +12,21 @@ INC=include
 
 USE_PORTAUDIO=1
 
+# Build without an audio device backend, the engine is driven by the null backend
+USE_NULL_AUDIO=0
+
+# Build the audio kernels with AVX2 instead of SSE
+USE_AVX=0
+
+# Report calls that may block or allocate on the audio thread
+RT_DEBUG=0
+
+# Arguments to the engine benchmark (make bench-engine)
+BENCH_ARGS=-o bench_engine.csv
+
+# Arguments to the fft benchmark and accuracy checks (make bench-fft)
+BENCH_FFT_ARGS=-o bench_fft.csv
+
 LIB=-lpthread -lm -lpng -ldl
 
 SRC=src/main.c
@@ -0,0 +1,53 @@
+// analyzer.h
+
+#ifndef _ANALYZER_H
+#define _ANALYZER_H
+
+#define TAP_SIZE 8192 // Frames kept in the ring of a tap, must be a power of two
+#define ANALYZER_FFT_SIZE 4096
+#define ANALYZER_BAND_COUNT 96
+#define ANALYZER_MIN_FREQ 20.0f
+#define ANALYZER_MIN_DB -90.0f  // Bottom of the spectrum plot, the top is 0 dB
+#define ANALYZER_RELEASE 0.25f  // Seconds it takes a band to fall by about two thirds, rising is immediate
+#define SCOPE_SIZE 1024 // Frames shown by the oscilloscope
+#define SCOPE_POINT_COUNT 256
+
+typedef enum tap_type {
+  TAP_MASTER,
+  TAP_FOCUS,  // The focused bus
+
+  MAX_TAP,
+} tap_type;
+
+// Ring of mono samples which the audio thread overwrites without waiting, readers take the latest window
+typedef struct audio_tap {
+  f32 Buffer[TAP_SIZE];
+  _Alignas(CACHE_LINE_SIZE) _Atomic u32 Written;  // Frames written so far, only written by the audio thread
+} audio_tap;
+
+// UI side of a tap, the spectrum and scope are normalized to 0-1 for drawing
+typedef struct analyzer {
+  fft_real_plan Plan;
+  f32* Window;
+  f32* Time;
+  f32* Re;
+  f32* Im;
+  f32 Bands[ANALYZER_BAND_COUNT];
+  f32 Scope[SCOPE_POINT_COUNT];
+  u8 Initialized;
+} analyzer;
+
+void TapInit(audio_tap* Tap);
+
+// Audio thread, writes the average of the left and right channel
+void TapWrite(audio_tap* Tap, const f32* Left, const f32* Right, i32 FrameCount);
+
+// Copies the latest Count frames to Out, returns zero if there aren't that many yet or if they were overwritten
+u8 TapRead(audio_tap* Tap, f32* Out, i32 Count);
+
+// Reads the latest window of the tap and updates the spectrum and the scope, DeltaTime is the time since the last update
+i32 AnalyzerUpdate(analyzer* Analyzer, audio_tap* Tap, i32 SampleRate, f32 DeltaTime);
+
+void AnalyzerFree(analyzer* Analyzer);
+
+#endif
@@ -3,6 +3,12 @@
 #ifndef _AUDIO_H
 #define _AUDIO_H
 
+// Bus buffers are planar, with every channel aligned to this many bytes
+#define AUDIO_BUFFER_ALIGNMENT 64
+
+// Number of samples between the channels of a planar buffer holding FrameCount frames
+#define PlanarStride(FrameCount) (((FrameCount) + 15) & ~15)
+
 typedef struct audio_source {
   float* Buffer;
   i32 SampleCount;
@@ -22,6 +28,18 @@ void CopyFloatBufferEliminateEven(float* DestBuffer, float* SourceBuffer, i32 Si
 
 void CopyFloatBufferEliminateOdd(float* DestBuffer, float* SourceBuffer, i32 Size);
 
+// Dest += Sources[0] * Gains[0] + Sources[1] * Gains[1] + ...
+void MixFloatBuffers(float* restrict Dest, float** Sources, float* Gains, i32 SourceCount, i32 SampleCount);
+
+// Largest absolute value and mean square of the buffer
+void MeasureFloatBuffer(float* Buffer, i32 SampleCount, float* Peak, float* Power);
+
+void ScaleFloatBuffer(float* Buffer, float Gain, i32 SampleCount);
+
+void InterleaveFloatBuffer(float* restrict Dest, float* restrict Left, float* restrict Right, i32 FrameCount);
+
+void DeinterleaveFloatBuffer(float* restrict Left, float* restrict Right, float* restrict Source, i32 FrameCount);
+
 i32 LoadAudioSource(const char* Path, audio_source* Source);
 
 i32 LoadAudioSourceFromDataPath(const char* Path, audio_source* Source);
@@ -7,8 +7,6 @@
 
 static i32 TempoBPM = 140;
 
-#define MAX_AUDIO_BUS 32
-
 struct instrument;
 struct bus;
 
@@ -26,26 +24,216 @@ typedef struct instrument {
   u8 Ready;
 } instrument;
 
+#define METER_HOLD_TIME 1.5f  // Seconds the peak is held before it starts to fall
+#define METER_DECAY_RATE 24.0f  // dB per second
+
+// NOTE(lucas): The sequence is odd while the audio thread writes, readers retry if it changed under them
+typedef struct bus_meter {
+  _Atomic u32 Sequence;
+  _Atomic f32 Peak[2];  // dB
+  _Atomic f32 Rms[2]; // dB
+} bus_meter;
+
+// NOTE(lucas): Ticks are summed by whichever thread runs the bus, and turned into a load once per DSP_LOAD_WINDOW
+typedef struct bus_profile {
+  u64 Ticks;  // Cycle counter ticks spent on the bus in the current window
+  u64 InstrumentTicks;
+  u64 MaxTicks; // Most ticks spent on a single block
+  _Atomic f32 Load;
+  _Atomic f32 InstrumentLoad;
+  _Atomic f32 Peak; // Load of the most expensive block of the last window, relative to the duration of a block
+  _Atomic f32 MaxPeak;
+} bus_profile;
+
+// UI side of the bus meter
+typedef struct meter_view {
+  v2 Level; // Falling peak level, in dB
+  v2 PeakHold;
+  v2 HoldTime;  // Seconds left before the held peak starts to fall
+} meter_view;
+
+// NOTE(lucas): Slots get a new generation when reused, so handles to removed buses never resolve
+typedef u32 bus_handle;
+
+#define BUS_HANDLE_NONE ((bus_handle)0xffffffff)
+#define BusHandleSlot(Handle) ((Handle) & 0xffff)
+#define BusHandleGeneration(Handle) ((Handle) >> 16)
+#define MakeBusHandle(Slot, Generation) ((bus_handle)(((u32)(Generation) << 16) | (Slot)))
+
+#define BUS_CHUNK_SIZE 64
+#define MAX_BUS_CHUNK (0x10000 / BUS_CHUNK_SIZE)
+#define MAX_AUDIO_BUS 0xffff  // The last slot is left out, its final generation would collide with BUS_HANDLE_NONE
+#define MAX_BUS_CHANNEL 2
+#define MAX_INSERT_SLOT 4
+
+// An effect in the insert chain of a bus
+typedef struct insert_slot {
+  effect* Effects[MAX_BUS_CHANNEL]; // One instance per channel, NULL when the slot is empty. Swapped by commands.
+  _Atomic u8 Bypass;  // Set by the UI thread, read with relaxed loads
+  f32 Wet;  // Audio thread only, how much of the effect output was let through at the end of the last block
+} insert_slot;
+
+// Bus buffers are planar, channel N starts at Buffer + N * Stride
 typedef struct bus {
   float* Buffer;
   i32 ChannelCount;
-  u32 ID;
+  i32 Stride;
+  _Atomic bus_handle Handle;  // BUS_HANDLE_NONE when the slot is not in use
   v2 Pan;
-  v2 Db;
+  bus_meter Meter;
+  bus_profile Profile;
   u8 Active;
   u8 Disabled;
   u8 InternalBuffer;
-  u8 ToRemove;
   u8 MidiInput;
   instrument* Ins;
+  insert_slot Inserts[MAX_INSERT_SLOT]; // Processed in order, in place, right after the instrument
+  struct bus* Sidechain;  // Bus feeding the sidechain input, only valid while the instrument is being processed
+  midi_frame_event* MidiEvents; // Sorted by frame, only valid while the instrument is being processed
+  i32 MidiEventCount;
 } bus;
 
+// NOTE(lucas): Chunks are never moved, so a bus stays where it is for as long as it exists
+typedef struct bus_store {
+  bus* Chunks[MAX_BUS_CHUNK];
+  i32 ChunkCount;
+  u16* Generations;
+  u32* FreeSlots;
+  i32 FreeCount;
+  i32 SlotCount;  // Slots handed out so far, including the ones that have been released
+} bus_store;
+
+#define MAX_BUS_SEND 4
+
+typedef struct bus_send {
+  bus_handle Target;
+  f32 Gain;
+} bus_send;
+
+// Routing of a single bus
+typedef struct mixer_node {
+  bus_handle Handle;
+  bus_handle Output;  // Bus that this bus is summed into
+  bus_handle Sidechain; // Bus feeding the sidechain input, BUS_HANDLE_NONE if none
+  u8 ExternalBuffer;
+  i32 SendCount;
+  bus_send Sends[MAX_BUS_SEND];
+  effect_type Inserts[MAX_INSERT_SLOT];  // Effect in every insert slot of the bus
+  effect* InsertEffects[MAX_INSERT_SLOT][MAX_BUS_CHANNEL];  // Instances last put in every slot, to set parameters on
+  meter_view Meter;
+} mixer_node;
+
+// The routing graph, which is owned by the UI thread. The first node is always the master bus.
+typedef struct mixer_graph {
+  mixer_node* Nodes;
+  i32 NodeCount;
+  i32 NodeCapacity;
+  i32* NodeOfSlot;  // Node of the bus in every slot, -1 if none
+  i32 SlotCapacity;
+  u8 Dirty;
+} mixer_graph;
+
+typedef struct plan_input {
+  i32 Node;
+  f32 Gain;
+} plan_input;
+
+typedef struct plan_node {
+  bus_handle Handle;
+  i32 Level;
+  i32 BufferIndex;  // Intermediate buffer of the node, -1 if the bus doesn't use an internal buffer
+  i32 Sidechain;  // Plan node feeding the sidechain input, -1 if none
+  i32 InputStart;
+  i32 InputCount;
+} plan_node;
+
+// The routing graph compiled into an execution plan. Nodes are sorted topologically and grouped into levels.
+// Nodes on the same level don't depend on each other, and can thus be processed in parallel. Plans are only ever
+// (re)allocated by the UI thread while the audio thread isn't using them.
+typedef struct mixer_plan {
+  plan_node* Nodes;
+  bus** Resolved; // Bus of each node, NULL if the bus does not exist (yet). Filled in by the audio thread.
+  i32* LevelStart;
+  i32 NodeCount;
+  i32 NodeCapacity;
+  plan_input* Inputs;
+  i32 InputCount;
+  i32 InputCapacity;
+  f32** Buffers;
+  i32 BufferCount;
+  i32 BufferCapacity;
+  i32 LevelCount;
+} mixer_plan;
+
+#define MIXER_QUEUE_SIZE 256
+
+// Bus which is recorded to a track of its own
+typedef struct record_target {
+  bus_handle Handle;
+  i32 Track;
+} record_target;
+
+typedef enum mixer_command_type {
+  MIXER_CMD_ADD_BUS,
+  MIXER_CMD_REMOVE_BUS,
+  MIXER_CMD_ATTACH_INSTRUMENT,
+  MIXER_CMD_SET_INSERT,
+} mixer_command_type;
+
+// Structural changes to the mixer, sent from the UI thread to the audio thread
+typedef struct mixer_command {
+  mixer_command_type Type;
+  bus_handle Handle;
+  bus Bus;  // The bus to add
+  instrument* Ins;  // The instrument to attach
+  i32 Slot; // The insert slot to put Effects in
+  effect* Effects[MAX_BUS_CHANNEL];
+} mixer_command;
+
+// Resources which the audio thread no longer refers to, sent back to the UI thread to be free'd
+typedef struct mixer_garbage {
+  instrument* Ins;
+  effect* Effects[MAX_INSERT_SLOT * MAX_BUS_CHANNEL];
+  bus_handle Bus; // Slot to release, BUS_HANDLE_NONE if none
+} mixer_garbage;
+
 typedef struct mixer {
-  bus Buses[MAX_AUDIO_BUS];
-  i32 BusCount;
+  bus_store Buses;
+  mixer_graph Graph;
+  mixer_plan Plans[2];
+  _Atomic i32 PlanIndex;  // Plan which is in use by the audio thread
+  _Atomic u8 PlanPending; // Set when the other plan is ready to be swapped in
+  u8 ResolveNeeded;
+  f32** BufferPool; // Intermediate buffers, handed out to the plans by the UI thread
+  i32 BufferPoolCount;
+  f32* MasterBuffer;  // Interleaved into the output buffer of the audio device at the end of every callback
+  i32 Stride;
+  i32 JobOffset;  // First plan node of the level that is being processed
+  f64 MeterTime;  // When the meters were last drawn
+  u64 ProfileTicks; // Cycle counter at the start of the profiling window
+  i64 ProfileTime;
+  i32 ProfileFrames;  // Frames processed in the profiling window
+  u8 Profile;
+  worker_pool Workers;
+  spsc_queue Commands;
+  spsc_queue Garbage;
+  mixer_garbage Pending[MIXER_QUEUE_SIZE];  // Garbage which can't be free'd yet (instruments that are still loading)
+  i32 PendingCount;
   i32 SampleRate;
-  i32 FramesPerBuffer;
-  bus* FocusedBus;
+  i32 BlockSize;  // Most frames processed at a time, buffers of the audio device are split into blocks of this size
+  i32 FrameCount; // Frames in the block that is being processed
+  midi_frame_event* MidiEvents; // MIDI events of the block that is being processed, handed to buses with MIDI input
+  i32 MidiEventCount;
+  memory_arena Scratch; // For memory which the audio thread needs temporarily, reset at the start of every callback
+  bus_handle FocusedBus;
+  audio_tap Taps[MAX_TAP];
+  _Atomic bus_handle TapHandle; // Bus which is written to the TAP_FOCUS tap, follows the focused bus
+  bus_handle BlockTapHandle;  // TapHandle as of the start of the block that is being processed
+  analyzer Analyzers[MAX_TAP];  // UI thread only
+  f64 AnalyzerTime; // When the analyzers were last updated
+  record_target* RecordTargets; // Stream track of the bus in every slot, fixed once recording has started
+  i32 RecordSlotCount;
+  u8 Recording; // Audio thread only, set when the buffer that is being processed is recorded
   u8 Active;
 } mixer;
 
@@ -65,6 +253,12 @@ typedef struct audio_engine {
   u8 Playing;
   u8 Recording;
   u8 Initialized;
+  u8 Offline; // Driven manually rather than by an audio device
+  u8 ThreadSetup; // The thread calling AudioEngineProcess has been configured
+  i32 InputTrack; // Stream track that the audio input is recorded to, -1 if none
+  midi_frame_event MidiEvents[MAX_MIDI_EVENT];  // MIDI events of the buffer that is being processed
+  i32 MidiEventCount;
+  dsp_load Load;
   mixer Mixer;
 } audio_engine;
 
@@ -74,12 +268,17 @@ typedef i32 (*callback)(audio_engine*);
 
 i32 AudioEngineStateInit(i32 SampleRate, i32 FramesPerBuffer);
 
+i32 AudioEngineOfflineInit(i32 SampleRate, i32 FramesPerBuffer);
+
 i32 AudioEngineStartRecording();
 
 i32 AudioEngineStopRecording();
 
 i32 AudioEngineProcess(const void* InBuffer, void* OutBuffer);
 
+// Like AudioEngineProcess, for a buffer that is shorter than the one the engine was set up with
+i32 AudioEngineProcessFrames(const void* InBuffer, void* OutBuffer, i32 FramesPerBuffer);
+
 i32 AudioEngineStart(callback Callback);
 
 void AudioEngineExit();
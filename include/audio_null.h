@@ -0,0 +1,34 @@
+// audio_null.h
+
+#ifndef _AUDIO_NULL_H
+#define _AUDIO_NULL_H
+
+// Built without an audio device backend
+#ifndef USE_NULL_AUDIO
+  #define USE_NULL_AUDIO 0
+#endif
+
+typedef enum null_audio_mode {
+  NullAudioRealTime = 1, // A buffer every buffer period, like an audio device would ask for them
+  NullAudioFreeRun, // Buffers back to back, as fast as the engine can process them
+} null_audio_mode;
+
+// Receives every buffer (FrameCount frames of interleaved stereo) which has been processed, on the audio thread
+typedef void (*null_audio_output)(const f32* Buffer, i32 FrameCount, void* UserData);
+
+i32 NullAudioInit(i32 SampleRate, i32 FramesPerBuffer, null_audio_mode Mode);
+
+i32 NullAudioStart();
+
+// Process BufferCount buffers on the calling thread, as fast as possible. Only when the backend hasn't been started.
+void NullAudioRun(u64 BufferCount);
+
+// Hand the output to Output rather than discarding it, set before the engine is started
+void NullAudioSetOutput(null_audio_output Output, void* UserData);
+
+// Buffers processed since the backend was started
+u64 NullAudioBufferCount();
+
+void NullAudioExit();
+
+#endif
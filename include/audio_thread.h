@@ -0,0 +1,43 @@
+// audio_thread.h
+
+#ifndef _AUDIO_THREAD_H
+#define _AUDIO_THREAD_H
+
+typedef enum setup_status {
+  SetupDisabled = 0,
+  SetupDone,
+  SetupFailed,
+  SetupUnsupported,
+} setup_status;
+
+typedef struct setup_result {
+  setup_status Status;
+  i32 Error;  // errno of the failed call
+} setup_result;
+
+// NOTE(lucas): Filled in by the threads themselves, the scheduling and floating point state are per thread
+typedef struct audio_thread_report {
+  setup_result Priority;
+  setup_result Affinity;
+  setup_result Denormals;
+  setup_result MemoryLock;
+  _Atomic i32 WorkersConfigured;
+  _Atomic i32 WorkersFailed;
+  _Atomic u8 Ready; // Set once the audio thread has configured itself
+} audio_thread_report;
+
+extern audio_thread_report AudioThreadReport;
+
+// Lock all current and future memory of the process into RAM, call before anything is loaded
+i32 AudioThreadLockMemory();
+
+// Configure the calling thread as the audio thread. Only flushes denormals when not RealTime (e.g. offline rendering).
+// Does not print, it's safe to call from within the audio callback.
+void AudioThreadSetup(u8 RealTime);
+
+// Configure the calling thread as one of the mixer workers, returns Error if anything that was asked for failed
+i32 AudioThreadSetupWorker(i32 WorkerIndex);
+
+void AudioThreadPrintReport(FILE* File);
+
+#endif
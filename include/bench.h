@@ -0,0 +1,8 @@
+// bench.h
+
+#ifndef _BENCH_H
+#define _BENCH_H
+
+i32 BenchEngine(i32 argc, char** argv);
+
+#endif
@@ -78,6 +78,7 @@ typedef struct string {
 #define Assert(VALUE) assert(VALUE)
 #define Clamp(Value, MinValue, MaxValue) (Value > MaxValue) ? (MaxValue) : ((Value < MinValue) ? (MinValue) : (Value))
 #define Min(A, B) (A < B ? A : B)
+#define Max(A, B) (A > B ? A : B)
 #define DB_MIN (-100.0f)  // Somewhat arbitrary
 #define Log10(Value) (Value <= 0 ? DB_MIN : log10(Value))
 #define MouseOver(M_X, M_Y, X, Y, W, H) (M_X >= X && M_X <= X + W && M_Y >= Y && M_Y <= Y + H)
@@ -14,15 +14,18 @@
 
 #define SAMPLE_RATE_DEFAULT 44100
 #define FRAMES_PER_BUFFER_DEFAULT 512
+#define PROCESS_QUANTUM_DEFAULT 64
 
 static i32 G_SampleRate = SAMPLE_RATE_DEFAULT;
 static i32 G_FramesPerBuffer = FRAMES_PER_BUFFER_DEFAULT;
+static i32 G_ProcessQuantum = PROCESS_QUANTUM_DEFAULT; // Frames rendered at a time, zero renders whole device buffers
 
 static i32 G_WindowWidth = 1280;
 static i32 G_WindowHeight = 720;
 static i32 G_FullScreen = 0;
 static i32 G_Vsync = 1;
 static i32 G_AudioInput = 0;
+static i32 G_AudioNull = 0; // Run without an audio device, 1 in real time and 2 as fast as possible (see null_audio_mode)
 
 static v3 UIColorBackground = V3(0.0f, 0.0f, 0.0f);
 static v3 UIColorAccept = V3(0.25f, 0.8f, 0.25f);
@@ -55,6 +58,27 @@ static i32 G_PaOutputDevice = -1;
 
 static i32 G_StreamBufferSizeMultiple = 32;
 static i32 G_StreamBufferDenom = 2;
+static i32 G_RecordBitDepth = 32;  // 16 or 24 bit integer, or 32 bit float
+static i32 G_RecordPreallocate = 64; // Megabytes of disk space reserved ahead of the recording at a time, zero disables
+static i32 G_RecordMultitrack = 0;  // Also record every bus (post instrument) and the audio input to files of their own
+
+static i32 G_AudioThreadPriority = 0;  // SCHED_FIFO priority of the audio thread and the mixer workers, zero leaves the scheduling alone
+static i32 G_AudioThreadCpu = -1; // Core that the audio thread is pinned to, less than zero doesn't pin it
+static i32 G_AudioWorkerCpu = -1; // Core that the first mixer worker is pinned to, the others get the cores after it
+static i32 G_AudioFlushDenormals = 1;
+static i32 G_AudioLockMemory = 0; // Lock all memory into RAM, requires an unlimited memlock limit
+
+static i32 G_MixerWorkerCount = -1;  // Zero processes all buses on the audio thread, less than zero uses every available core
+static i32 G_MixerParallelMinBuses = 4; // Fall back to serial processing when there are fewer buses than this to process
+static i32 G_MixerProfile = 1; // Measure the cpu time spent on every bus
+static i32 G_MixerScratchSize = 1 << 20;  // Bytes of scratch memory available to the audio thread per callback
+
+static char G_ReverbImpulse[MAX_PATH_SIZE] = ""; // Impulse response of the reverb effect, a synthetic one if empty
+static i32 G_ReverbTailThread = 1;  // Convolve the tail of the impulse response on a thread of its own
+
+static f32 G_EqGains[8] = {0}; // Gain in dB of every band of the eq effect, which its amount scales
+
+static i32 G_RtDebugTrap = 0; // Abort instead of only logging when something unsafe is called on the audio thread (RT_DEBUG builds)
 
 typedef enum variable_type {
   TypeUndefined = 0,
@@ -0,0 +1,65 @@
+// convolver.h
+
+#ifndef _CONVOLVER_H
+#define _CONVOLVER_H
+
+#define CONVOLVER_HEAD_SIZE 64  // Partition size of the head, which is also the latency of the convolver
+#define CONVOLVER_TAIL_SIZE 1024  // Partition size of the tail
+#define CONVOLVER_TAIL_OFFSET (2 * CONVOLVER_TAIL_SIZE) // Where the tail starts in the impulse response
+#define CONVOLVER_TAIL_QUEUE 4  // Blocks of the tail which can be in flight at a time
+
+// Uniformly partitioned overlap-save convolution of one part of the impulse response
+typedef struct convolver_stage {
+  fft_real_plan Plan;
+  i32 BlockSize;  // Size of the partitions, the transforms are twice as large
+  i32 BinCount; // Bins of the spectrum that are kept, the rest are mirrored from these
+  i32 PartitionCount;
+  f32* IrRe;  // Spectrum of every partition, with the scaling of the inverse transform folded in
+  f32* IrIm;
+  f32* InRe;  // Frequency domain delay line, spectra of the last PartitionCount blocks of input
+  f32* InIm;
+  i32 Position; // Partition of the delay line that holds the latest input
+  f32* History; // The last two blocks of input
+  f32* Re;  // Sum of the products of the spectra
+  f32* Im;
+  f32* Time;  // Inverse transform of the sum, the second half of which is the output
+} convolver_stage;
+
+// NOTE(lucas): The head runs on the audio thread, the tail starts late enough to run on the shared tail thread
+typedef struct convolver {
+  convolver_stage Head;
+  convolver_stage Tail; // No partitions if the impulse response fits in the head
+
+  // Audio thread only
+  f32 In[CONVOLVER_HEAD_SIZE];
+  f32 Out[CONVOLVER_HEAD_SIZE];
+  i32 FifoIndex;
+  i64 Step; // Head blocks processed so far
+  f32* TailFill;  // Input of the tail block that is being collected
+  i32 TailFillCount;
+  u32 TailBlock;  // Index of the tail block that is being collected
+  f32* TailPlay;  // Output of the tail block that is being played
+
+  f32* TailIn[CONVOLVER_TAIL_QUEUE];
+  u32 TailInBlock[CONVOLVER_TAIL_QUEUE];
+  f32* TailOut[CONVOLVER_TAIL_QUEUE];
+  u32 TailOutBlock[CONVOLVER_TAIL_QUEUE];
+  f32* TailZero;
+  _Atomic u32 Written; // Tail blocks handed over to the tail thread
+  _Atomic u32 Done; // Tail blocks processed by the tail thread
+  _Atomic u32 Misses; // Tail blocks that were dropped or not done in time
+  u32 ThreadBlock;  // Tail thread only, index of the next block in its delay line
+  u8 Threaded;  // Otherwise the tail is processed on the audio thread, as soon as a block is complete
+  struct convolver* Next; // In the list of the tail thread
+} convolver;
+
+i32 ConvolverInit(convolver* Convolver, const f32* Ir, i32 IrLength, u8 Threaded);
+
+// Out gets the convolved input, delayed by CONVOLVER_HEAD_SIZE frames. In and Out may be the same buffer.
+void ConvolverProcess(convolver* Convolver, const f32* In, f32* Out, i32 FrameCount);
+
+u32 ConvolverMisses(convolver* Convolver);
+
+void ConvolverFree(convolver* Convolver);
+
+#endif
@@ -5,6 +5,24 @@
 
 #define DEBUG_TIMER 1
 
+// Cheapest timestamp we can get, in ticks of unknown length. Calibrate against a real clock for time.
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define ReadCycleCounter() ((u64)__rdtsc())
+#elif defined(__aarch64__)
+static inline u64 ReadCycleCounter() {
+  u64 Ticks;
+  __asm__ __volatile__ ("mrs %0, cntvct_el0" : "=r"(Ticks));
+  return Ticks;
+}
+#else
+static inline u64 ReadCycleCounter() {
+  struct timespec Time;
+  clock_gettime(CLOCK_MONOTONIC, &Time);
+  return (u64)Time.tv_sec * 1000000000 + Time.tv_nsec;
+}
+#endif
+
 #if DEBUG_TIMER
 
 #include <time.h>
@@ -0,0 +1,68 @@
+// dsp_load.h
+
+#ifndef _DSP_LOAD_H
+#define _DSP_LOAD_H
+
+#define DSP_LOAD_BIN_COUNT 20 // 5% each, the last bin also holds every callback which took longer than the buffer period
+#define MAX_LATE_CALLBACK 16
+#define DSP_LOAD_WINDOW 0.5f  // Seconds of audio that the published min/avg/max cover
+
+typedef enum xrun_flag {
+  XrunInputUnderflow = 1 << 0,
+  XrunInputOverflow = 1 << 1,
+  XrunOutputUnderflow = 1 << 2,
+  XrunOutputOverflow = 1 << 3,
+} xrun_flag;
+
+// Load of the audio callback as a fraction of the buffer period
+typedef struct dsp_load_stats {
+  f32 Min;
+  f32 Avg;
+  f32 Max;
+  f32 Peak;  // Highest load since the start
+} dsp_load_stats;
+
+typedef struct late_callback {
+  _Atomic i64 Time; // Nanoseconds since the engine was started
+  _Atomic f32 Load;
+} late_callback;
+
+// NOTE(lucas): Written by the audio thread, the stats of the last window are published with a sequence lock
+typedef struct dsp_load {
+  _Atomic u32 Sequence;
+  _Atomic f32 Min;
+  _Atomic f32 Avg;
+  _Atomic f32 Max;
+  _Atomic f32 Peak;
+  _Atomic u32 Histogram[DSP_LOAD_BIN_COUNT];
+  _Atomic u32 Callbacks;
+  _Atomic u32 Underflows;
+  _Atomic u32 Overflows;
+  _Atomic u32 LateCount;  // Callbacks which took longer than the buffer period, only the last MAX_LATE_CALLBACK are kept
+  late_callback Late[MAX_LATE_CALLBACK];
+
+  // Audio thread only
+  i64 StartTime;
+  i64 Period; // Nanoseconds
+  f32 WindowMin;
+  f32 WindowMax;
+  f64 WindowSum;
+  i32 WindowCount;
+  i32 WindowSize; // Callbacks per window
+} dsp_load;
+
+i64 DspLoadTime();
+
+void DspLoadInit(dsp_load* Load, i32 SampleRate, i32 FramesPerBuffer);
+
+// Account for a callback which started at Start and is about to return
+void DspLoadUpdate(dsp_load* Load, i64 Start);
+
+// Account for the xruns which the audio backend reported, Flags is a combination of xrun_flag
+void DspLoadXrun(dsp_load* Load, u32 Flags);
+
+void DspLoadRead(dsp_load* Load, dsp_load_stats* Stats);
+
+void DspLoadPrint(dsp_load* Load, FILE* File);
+
+#endif
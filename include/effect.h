@@ -3,14 +3,62 @@
 #ifndef _EFFECT_H
 #define _EFFECT_H
 
-typedef void (*effect_func)(f32*, i32, i32, f32, f32);
+typedef enum effect_type {
+  EFFECT_NONE,
+  EFFECT_DISTORTION,
+  EFFECT_WEIRD_01,
+  EFFECT_WEIRD_02,
+  EFFECT_REVERB,
+  EFFECT_EQ,
 
-void StubEffect(f32* Buffer, i32 ChannelCount, i32 FramesPerBuffer, f32 Mix, f32 Amount);
+  MAX_EFFECT_TYPE,
+} effect_type;
 
-void Distortion(f32* Buffer, i32 ChannelCount, i32 FramesPerBuffer, f32 Mix, f32 Amount);
+struct effect;
 
-void WeirdEffect(f32* Buffer, i32 ChannelCount, i32 FramesPerBuffer, f32 Mix, f32 Amount);
+// Buffer holds FramesPerBuffer frames of ChannelCount interleaved channels
+typedef void (*effect_process_cb)(struct effect* Effect, f32* Buffer, i32 ChannelCount, i32 FramesPerBuffer);
 
-void WeirdEffect2(f32* Buffer, i32 ChannelCount, i32 FramesPerBuffer, f32 Mix, f32 Amount);
+// Channel is the channel of the bus that the instance processes
+typedef i32 (*effect_init_cb)(struct effect* Effect, i32 Channel);
+
+typedef void (*effect_destroy_cb)(struct effect* Effect);
+
+typedef struct effect_def {
+  const char* Name;
+  i32 StateSize;  // Size of the state that every instance gets, zeroed on creation
+  effect_process_cb Process;
+  f32 DefaultMix; // Settings of the effect when it is inserted on a bus
+  f32 DefaultAmount;
+  effect_init_cb Init;  // Optional, sets up the state outside of the audio thread
+  effect_destroy_cb Destroy;  // Optional, releases what Init set up
+} effect_def;
+
+// NOTE(lucas): Instances own all of their state, so that they can run on different threads at the same time
+typedef struct effect {
+  effect_type Type;
+  f32 Mix;
+  f32 Amount;
+  void* State;
+  effect_process_cb Process;
+} effect;
+
+extern const effect_def EffectDefs[MAX_EFFECT_TYPE];
+
+// Returns the effect type which has the given name, or -1 if there is no such effect
+i32 EffectFindDef(const char* Name, u32 Length);
+
+effect* EffectCreate(effect_type Type, i32 Channel, f32 Mix, f32 Amount);
+
+void EffectProcess(effect* Effect, f32* Buffer, i32 ChannelCount, i32 FramesPerBuffer);
+
+void EffectDestroy(effect* Effect);
+
+// Set the gain (in dB) of a band of an eq instance, which glides there. Only one thread at a time may set the gains of
+// an instance.
+i32 EffectSetEqGain(effect* Effect, i32 Band, f32 Gain);
+
+// Settings of a band of an eq instance as they were last set, NULL if the effect is not an eq
+const eq_band* EffectEqBand(effect* Effect, i32 Band);
 
 #endif
@@ -3,15 +3,23 @@
 #ifndef _ENGINE_H
 #define _ENGINE_H
 
+#include "wait_word.h"
 #include "stream.h"
-#include "audio_engine.h"
-#include "mixer.h"
-#include "instrument.h"
-#include "effect.h"
-
+#include "audio_thread.h"
+#include "audio_null.h"
+#include "worker_pool.h"
 #include "midi.h"
 #include "midi_serial.h"
 #include "midi_apple.h"
+#include "dsp_load.h"
+#include "convolver.h"
+#include "eq.h"
+#include "analyzer.h"
+#include "effect.h"
+#include "audio_engine.h"
+#include "mixer.h"
+#include "mixer_graph.h"
+#include "instrument.h"
 
 #include "osc_test.h"
 #include "sampler.h"
@@ -19,8 +27,8 @@
 #include "draw.h"
 #include "ui.h"
 #include "window.h"
-
-extern float NoteTable[];
+#include "render.h"
+#include "bench.h"
 
 i32 EngineInit();
 
@@ -0,0 +1,70 @@
+// eq.h
+
+#ifndef _EQ_H
+#define _EQ_H
+
+#define EQ_BAND_COUNT 8
+#define EQ_LANE_COUNT 4 // Bands processed at a time
+#define EQ_VECTOR_COUNT (EQ_BAND_COUNT / EQ_LANE_COUNT)
+#define EQ_CHUNK_SIZE 64  // Frames processed with the same coefficients
+#define EQ_SMOOTH_TIME 0.02f  // Seconds it takes the coefficients to get about two thirds of the way to new settings
+
+typedef enum eq_band_type {
+  EQ_OFF,
+  EQ_BELL,
+  EQ_LOW_SHELF,
+  EQ_HIGH_SHELF,
+  EQ_LOW_CUT,
+  EQ_HIGH_CUT,
+
+  MAX_EQ_BAND_TYPE,
+} eq_band_type;
+
+typedef struct eq_band {
+  eq_band_type Type;
+  f32 Frequency;
+  f32 Gain; // In dB, unused by the cuts
+  f32 Q;
+} eq_band;
+
+// Per band coefficients of the state variable filters, in structure of arrays form so that a vector holds the
+// coefficients of EQ_LANE_COUNT bands
+typedef struct eq_coefs {
+  f32 G[EQ_BAND_COUNT]; // Prewarped cutoff
+  f32 K[EQ_BAND_COUNT]; // Damping
+  f32 M0[EQ_BAND_COUNT];  // Mix of the input, band pass and low pass outputs
+  f32 M1[EQ_BAND_COUNT];
+  f32 M2[EQ_BAND_COUNT];
+} eq_coefs;
+
+// NOTE(lucas): TPT state variable filters stay well behaved when their coefficients move, settings use a seqlock
+typedef struct eq_bank {
+  eq_band Bands[EQ_BAND_COUNT];
+  _Atomic u32 Sequence; // Odd while the bands are being written
+
+  // Processing thread only
+  u32 Applied;  // Sequence of the settings that the target coefficients were computed from
+  i32 SampleRate;
+  u8 Smoothing;
+  eq_coefs Target;
+  eq_coefs Current;
+  f32 Gx[EQ_BAND_COUNT]; // Coefficients of the filter in state space form, derived from the current coefficients
+  f32 G1[EQ_BAND_COUNT];
+  f32 G2[EQ_BAND_COUNT];
+  f32 U1[EQ_BAND_COUNT];
+  f32 U2[EQ_BAND_COUNT];
+  f32 D1[EQ_BAND_COUNT];
+  f32 D2[EQ_BAND_COUNT];
+  f32 Ic1[EQ_BAND_COUNT];  // Integrator states
+  f32 Ic2[EQ_BAND_COUNT];
+} eq_bank;
+
+// Starts out at the given settings, without smoothing towards them
+void EqInit(eq_bank* Eq, const eq_band* Bands, i32 SampleRate);
+
+void EqSetBand(eq_bank* Eq, i32 Index, const eq_band* Band);
+
+// Has no latency, In and Out may be the same buffer
+void EqProcess(eq_bank* Eq, const f32* In, f32* Out, i32 FrameCount);
+
+#endif
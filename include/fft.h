@@ -0,0 +1,56 @@
+// fft.h
+
+#ifndef _FFT_H
+#define _FFT_H
+
+#define FFT_MIN_SIZE 2
+#define FFT_MAX_SIZE 65536
+#define FFT_ALIGNMENT 64
+
+// NOTE(lucas): Twiddles are computed once per size so that transforms never allocate. Data is planar for SIMD.
+typedef struct fft_plan {
+  i32 Size;
+  i32 Log2Size;
+  f32* Twiddles;  // Twiddles of every radix-4 stage, laid out one stage after the other
+  i32 TwiddleCount;
+  u32* Reverse;  // Bit reversed index of every element
+} fft_plan;
+
+// Transform of Size real samples, computed with a complex transform of half the size
+typedef struct fft_real_plan {
+  i32 Size;
+  fft_plan Half;
+  f32* Cos;  // Size / 4 + 1 twiddles, for splitting the spectrum of the half size transform
+  f32* Sin;
+} fft_real_plan;
+
+i32 FftPlanInit(fft_plan* Plan, i32 Size);
+
+// In place, unscaled
+void FftForward(fft_plan* Plan, f32* Re, f32* Im);
+
+// In place, unscaled (the result is Size times the input of the forward transform)
+void FftInverse(fft_plan* Plan, f32* Re, f32* Im);
+
+void FftPlanFree(fft_plan* Plan);
+
+i32 FftRealPlanInit(fft_real_plan* Plan, i32 Size);
+
+// Size samples of In to Size / 2 + 1 bins in Re and Im, unscaled. In must not overlap Re or Im.
+void FftRealForward(fft_real_plan* Plan, const f32* In, f32* Re, f32* Im);
+
+// Size / 2 + 1 bins of Re and Im to Size samples of Out, unscaled (Size times the input of the forward transform).
+// Re and Im are overwritten, and must not overlap Out.
+void FftRealInverse(fft_real_plan* Plan, f32* Re, f32* Im, f32* Out);
+
+void FftRealPlanFree(fft_real_plan* Plan);
+
+// Acc += A * B for Count complex numbers
+void FftMultiplyAccumulate(f32* restrict AccRe, f32* restrict AccIm, const f32* ARe, const f32* AIm, const f32* BRe, const f32* BIm, i32 Count);
+
+// Allocate a buffer for Count floats which is suitably aligned for the transforms
+f32* FftAlloc(i32 Count);
+
+void FftFree(f32* Buffer, i32 Count);
+
+#endif
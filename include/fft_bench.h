@@ -0,0 +1,10 @@
+// fft_bench.h
+
+#ifndef _FFT_BENCH_H
+#define _FFT_BENCH_H
+
+// Measures the speed of the transforms against a naive DFT, and checks that they are accurate. Returns an error
+// if any of the transforms is off by more than the tolerance.
+i32 BenchFft(i32 argc, char** argv);
+
+#endif
@@ -22,12 +22,16 @@ typedef enum instrument_def_type {
 typedef struct instrument_handler {
   instrument_def* Instruments;
   u32 InstrumentCount;
+  _Atomic i32 UnloadCount;  // Number of instruments that are being unloaded
+  wait_word Loaded; // Bumped every time an instrument is done loading
 } instrument_handler;
 
 extern instrument_handler InsHandler;
 
 instrument* InstrumentCreate(instrument_def_type Type);
 
+i32 InstrumentFindDef(const char* Name, u32 Length);
+
 i32 InstrumentAllocUserData(instrument* Ins, i32 Size);
 
 i32 InstrumentDestroy(instrument* Ins);
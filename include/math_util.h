@@ -9,12 +9,49 @@
 #define USE_SSE 1
 #endif
 
+#if __AVX__
+#define USE_AVX 1
+#endif
+
 #endif
 
 #if USE_SSE
 #include <xmmintrin.h>
 #endif
 
+#if USE_AVX
+#include <immintrin.h>
+#endif
+
+// Thin layer over the widest vector unit we have been compiled for
+#if USE_AVX
+#define SIMD_WIDTH 8
+typedef __m256 simd_f32;
+#define SimdLoad(Pointer) _mm256_loadu_ps(Pointer)
+#define SimdStore(Pointer, Value) _mm256_storeu_ps(Pointer, Value)
+#define SimdSet1(Value) _mm256_set1_ps(Value)
+#define SimdAdd(A, B) _mm256_add_ps(A, B)
+#define SimdSub(A, B) _mm256_sub_ps(A, B)
+#define SimdMul(A, B) _mm256_mul_ps(A, B)
+#define SimdMax(A, B) _mm256_max_ps(A, B)
+#define SimdAbs(A) _mm256_andnot_ps(_mm256_set1_ps(-0.0f), A)
+#define SimdAnd(A, B) _mm256_and_ps(A, B)
+#define SimdCmpGe(A, B) _mm256_cmp_ps(A, B, _CMP_GE_OQ)  // All bits set where A >= B
+#elif USE_SSE
+#define SIMD_WIDTH 4
+typedef __m128 simd_f32;
+#define SimdLoad(Pointer) _mm_loadu_ps(Pointer)
+#define SimdStore(Pointer, Value) _mm_storeu_ps(Pointer, Value)
+#define SimdSet1(Value) _mm_set1_ps(Value)
+#define SimdAdd(A, B) _mm_add_ps(A, B)
+#define SimdSub(A, B) _mm_sub_ps(A, B)
+#define SimdMul(A, B) _mm_mul_ps(A, B)
+#define SimdMax(A, B) _mm_max_ps(A, B)
+#define SimdAbs(A) _mm_andnot_ps(_mm_set1_ps(-0.0f), A)
+#define SimdAnd(A, B) _mm_and_ps(A, B)
+#define SimdCmpGe(A, B) _mm_cmpge_ps(A, B)
+#endif
+
 #define Translate2D(MODEL, X, Y) MultiplyMat4(MODEL, Translate(V3(X, Y, 0)))
 
 #define Rotate2D(MODEL, ANGLE) MultiplyMat4(MODEL, Rotate(ANGLE, V3(0, 0, 1)))
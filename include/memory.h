@@ -3,6 +3,17 @@
 #ifndef _MEMORY_H
 #define _MEMORY_H
 
+#include <stdatomic.h>
+
+#define ARENA_ALIGNMENT 64
+
+// Linear allocator over a fixed block of memory, reset all at once. Pushing is lock-free.
+typedef struct memory_arena {
+  u8* Data;
+  i32 Size;
+  _Atomic i32 Used;
+} memory_arena;
+
 i64 MemoryTotal();
 
 i64 MemoryNumBlocks();
@@ -13,8 +24,20 @@ void* M_Malloc(const i32 Size);
 
 void* M_Calloc(const i32 Size, const i32 Count);
 
+// Zeroed memory aligned to Alignment bytes (a power of two), which is free'd with M_Free as usual
+void* M_AlignedCalloc(const i32 Alignment, const i32 Size, const i32 Count);
+
 void* M_Realloc(void* Data, const i32 OldSize, const i32 NewSize);
 
 void M_Free(void* Data, const i32 Size);
 
+i32 ArenaInit(memory_arena* Arena, const i32 Size);
+
+// Returns NULL when the arena is full
+void* ArenaPush(memory_arena* Arena, const i32 Size);
+
+void ArenaReset(memory_arena* Arena);
+
+void ArenaFree(memory_arena* Arena);
+
 #endif
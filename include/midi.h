@@ -4,6 +4,8 @@
 #define _MIDI_H
 
 #define MAX_MIDI_EVENT 512
+#define MAX_MIDI_NOTE 128
+#define MIDI_QUEUE_SIZE 1024
 
 typedef union midi_event {
   struct {
@@ -17,6 +19,18 @@ typedef union midi_event {
   };
 } midi_event;
 
+// An event stamped with the time it arrived at, in nanoseconds (see MidiTime)
+typedef struct midi_timed_event {
+  midi_event Event;
+  i64 Time;
+} midi_timed_event;
+
+// An event as it is handed to instruments, Frame is the offset into the block that is being processed
+typedef struct midi_frame_event {
+  midi_event Event;
+  i32 Frame;
+} midi_frame_event;
+
 enum midi_message_event {
   MIDI_NOTE_ON = 0x90,
   MIDI_NOTE_ON_HIGH = 0x9,
@@ -27,7 +41,6 @@ enum midi_message_event {
 typedef struct midi_handle {
   const char* Handle;
   i32 (*Init)();
-  u32 (*FetchEvents)(midi_event* Dest);
   i32 (*OpenDevices)();
   void (*CloseDevices)();
 } midi_handle;
@@ -48,10 +61,16 @@ i32 MidiInitHandle(midi_handle_type HandleType);
 
 i32 MidiInit();
 
-u32 MidiFetchEvents(midi_event* Dest);
+i64 MidiTime();
+
+void MidiPushEvent(midi_event Event);
+
+u32 MidiFetchEvents(midi_timed_event* Dest, u32 MaxCount);
 
 i32 MidiOpenDevices();
 
 void MidiCloseDevices();
 
+void MidiFree();
+
 #endif
@@ -7,8 +7,6 @@
 
 i32 MidiAppleInit();
 
-u32 MidiAppleFetchEvents(midi_event* Dest);
-
 i32 MidiAppleOpenDevices();
 
 void MidiAppleCloseDevices();
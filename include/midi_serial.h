@@ -5,14 +5,10 @@
 
 i32 MidiSerialInit();
 
-u32 MidiSerialFetchEvents(midi_event* Dest);
-
 i32 MidiSerialOpenDevices();
 
 i32 OpenSerial(const char* Device);
 
-u32 FetchMidiEvents(midi_event* Dest);  // Fetch midi events. Returns the number of events recieved.
-
 void CloseSerial();
 
 void MidiSerialCloseDevices();
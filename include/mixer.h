@@ -5,28 +5,65 @@
 
 i32 MixerInit(mixer* Mixer, i32 SampleRate, i32 FramesPerBuffer);
 
+bus* MixerFindBus(mixer* Mixer, bus_handle Handle);
+
+i32 MixerBusCount(mixer* Mixer);
+
+u8 MixerInstrumentsReady(mixer* Mixer);
+
+void MixerWaitInstruments(mixer* Mixer);
+
+bus_handle MixerGetBusHandle(mixer* Mixer, i32 BusIndex);
+
 bus* MixerGetBus(mixer* Mixer, i32 BusIndex);
 
 bus* MixerGetFocusedBus(mixer* Mixer);
 
-i32 MixerAddBus(mixer* Mixer, i32 ChannelCount, float* Buffer);
+i32 MixerAddBus(mixer* Mixer, i32 ChannelCount, float* Buffer, instrument* Ins, bus_handle* Handle);
 
-bus* MixerAddBus0(mixer* Mixer, i32 ChannelCount, float* Buffer, i32* BusIndex);
+i32 MixerRemoveBus(mixer* Mixer, bus_handle Handle);
 
-i32 MixerRemoveBus(mixer* Mixer, i32 BusIndex);
+i32 MixerAttachInstrument(mixer* Mixer, bus_handle Handle, instrument* Ins);
 
-i32 MixerAttachInstrumentToBus(mixer* Mixer, i32 BusIndex, instrument* Ins);
+// Put a new instance of the effect in an insert slot of the bus, EFFECT_NONE empties the slot
+i32 MixerSetInsert(mixer* Mixer, bus_handle Handle, i32 SlotIndex, effect_type Type);
 
-i32 MixerAttachInstrumentToBus0(mixer* Mixer, bus* Bus, instrument* Ins);
+// Set the gain (in dB) of a band of the eq in an insert slot of the bus, on every channel
+i32 MixerSetEqGain(mixer* Mixer, bus_handle Handle, i32 SlotIndex, i32 Band, f32 Gain);
 
-i32 MixerToggleActiveBus(mixer* Mixer, i32 BusIndex);
+i32 MixerSetOutput(mixer* Mixer, bus_handle Handle, bus_handle Output);
+
+i32 MixerSetSend(mixer* Mixer, bus_handle Handle, bus_handle Target, f32 Gain);
+
+i32 MixerRemoveSend(mixer* Mixer, bus_handle Handle, bus_handle Target);
+
+i32 MixerSetSidechain(mixer* Mixer, bus_handle Handle, bus_handle Source);
 
-i32 MixerClearBuffers(mixer* Mixer);
+i32 MixerClearSidechain(mixer* Mixer, bus_handle Handle);
 
-i32 MixerSumBuses(mixer* Mixer, u8 Playing, float* OutBuffer, float* InBuffer);
+void MixerProcessCommands(mixer* Mixer);
+
+void MixerUpdate(mixer* Mixer);
+
+void MixerReadMeter(bus* Bus, v2* Peak, v2* Rms);
+
+void MixerPrintProfile(mixer* Mixer, FILE* File);
+
+// Add a record track for every bus (except the master bus) to the stream, the files are named after Prefix and the
+// index of the bus. A track gets the output of its bus, after the inputs and inserts.
+i32 MixerAddRecordTracks(mixer* Mixer, const char* Prefix);
+
+i32 MixerToggleActiveBus(mixer* Mixer, i32 BusIndex);
+
+i32 MixerSumBuses(mixer* Mixer, u8 Playing, float* OutBuffer, float* InBuffer, i32 FrameCount);
 
 i32 MixerRender(mixer* Mixer);
 
+i32 MixerDrawInserts(mixer* Mixer, bus_handle Handle);
+
+// Spectrum and scope of the master bus, and of the focused bus if there is one
+i32 MixerDrawAnalyzer(mixer* Mixer);
+
 void MixerFree(mixer* Mixer);
 
 #endif
@@ -0,0 +1,20 @@
+// mixer_graph.h
+
+#ifndef _MIXER_GRAPH_H
+#define _MIXER_GRAPH_H
+
+void MixerGraphInit(mixer_graph* Graph);
+
+mixer_node* MixerGraphFindNode(mixer_graph* Graph, bus_handle Handle);
+
+i32 MixerGraphAddNode(mixer_graph* Graph, bus_handle Handle, u8 ExternalBuffer);
+
+void MixerGraphRemoveNode(mixer_graph* Graph, bus_handle Handle);
+
+void MixerGraphFree(mixer_graph* Graph);
+
+i32 MixerGraphCompile(mixer_graph* Graph, mixer_plan* Plan);
+
+void MixerPlanFree(mixer_plan* Plan);
+
+#endif
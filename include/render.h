@@ -0,0 +1,8 @@
+// render.h
+
+#ifndef _RENDER_H
+#define _RENDER_H
+
+i32 Render(i32 argc, char** argv);
+
+#endif
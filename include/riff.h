@@ -28,9 +28,51 @@ typedef struct wave_chunk {
 #define WaveMinSize ((i32)(sizeof(wave_header) + sizeof(wave_format) + sizeof(wave_chunk)))
 
 #define FORMAT_PCM 0x1
+#define FORMAT_IEEE_FLOAT 0x3
+#define FORMAT_EXTENSIBLE 0xfffe
+
+// NOTE(lucas): A JUNK chunk reserves room for a ds64 chunk, so that files can become RF64 in place past 4 GB
+#define WAVE_DS64_SIZE 28
+
+typedef enum wave_sample_format {
+  WaveInt16,
+  WaveInt24,
+  WaveFloat32,
+} wave_sample_format;
+
+typedef struct wave_writer {
+  FILE* File;
+  i32 SampleRate;
+  i32 ChannelCount;
+  i64 SampleCount;
+  wave_sample_format Format;
+  i32 DataSizeOffset; // Where the size of the data chunk is stored in the file
+  i32 DataOffset;
+  i64 Allocated;  // Bytes of sample data which disk space has been reserved for
+  u8 Rf64;
+} wave_writer;
 
 i32 StoreWAVE(const char* Path, audio_source* Source);
 
+// Streaming writer, for when the whole audio source doesn't fit (or shouldn't be kept) in memory
+i32 WaveWriterOpen(wave_writer* Writer, const char* Path, i32 SampleRate, i32 ChannelCount, wave_sample_format Format);
+
+i32 WaveWriterWrite(wave_writer* Writer, float* Buffer, u32 SampleCount);
+
+// Write several buffers of samples at once, bypassing the buffering of stdio
+i32 WaveWriterWriteV(wave_writer* Writer, float** Buffers, u32* SampleCounts, i32 BufferCount);
+
+// Write the sizes of what has been written so far to the header, so that the file is valid even if it never gets closed
+i32 WaveWriterUpdateHeader(wave_writer* Writer);
+
+// Reserve disk space for the next Size bytes of sample data, without changing the size of the file. Nothing is done as
+// long as at least half of that is still left from last time.
+i32 WaveWriterPreallocate(wave_writer* Writer, i64 Size);
+
+i32 WaveWriterClose(wave_writer* Writer);
+
 i32 LoadWAVE(const char* Path, audio_source* Source);
 
+i32 WaveSampleSize(wave_sample_format Format);
+
 #endif
@@ -0,0 +1,60 @@
+// rt_debug.h
+// catches calls that may block or allocate (memory allocation, locks, thread management, stdio) on the audio thread
+
+#ifndef _RT_DEBUG_H
+#define _RT_DEBUG_H
+
+#ifndef RT_DEBUG
+  #define RT_DEBUG 0
+#endif
+
+#if RT_DEBUG
+
+#include <pthread.h>
+#include <execinfo.h>
+
+// Set on the threads that run audio processing, for as long as they are doing so
+static _Thread_local u8 RtAudioThread = 0;
+
+void RtDebugInit();
+
+void RtViolation(const char* Name, const char* File, i32 Line);
+
+#define RtEnterAudioThread() (RtAudioThread = 1)
+#define RtLeaveAudioThread() (RtAudioThread = 0)
+#define RtCheck(NAME) (RtAudioThread ? RtViolation(NAME, __FILE__, __LINE__) : (void)0)
+
+// NOTE(lucas): Calls made from within libraries (e.g. the audio backend) are not caught
+#define pthread_create(...) (RtCheck("pthread_create"), pthread_create(__VA_ARGS__))
+#define pthread_join(...) (RtCheck("pthread_join"), pthread_join(__VA_ARGS__))
+#define pthread_detach(...) (RtCheck("pthread_detach"), pthread_detach(__VA_ARGS__))
+#define pthread_mutex_lock(...) (RtCheck("pthread_mutex_lock"), pthread_mutex_lock(__VA_ARGS__))
+#define pthread_mutex_init(...) (RtCheck("pthread_mutex_init"), pthread_mutex_init(__VA_ARGS__))
+#define pthread_mutex_destroy(...) (RtCheck("pthread_mutex_destroy"), pthread_mutex_destroy(__VA_ARGS__))
+#define pthread_cond_wait(...) (RtCheck("pthread_cond_wait"), pthread_cond_wait(__VA_ARGS__))
+#define pthread_cond_timedwait(...) (RtCheck("pthread_cond_timedwait"), pthread_cond_timedwait(__VA_ARGS__))
+#define pthread_rwlock_rdlock(...) (RtCheck("pthread_rwlock_rdlock"), pthread_rwlock_rdlock(__VA_ARGS__))
+#define pthread_rwlock_wrlock(...) (RtCheck("pthread_rwlock_wrlock"), pthread_rwlock_wrlock(__VA_ARGS__))
+
+#define printf(...) (RtCheck("printf"), printf(__VA_ARGS__))
+#define fprintf(...) (RtCheck("fprintf"), fprintf(__VA_ARGS__))
+#define vfprintf(...) (RtCheck("vfprintf"), vfprintf(__VA_ARGS__))
+#define puts(...) (RtCheck("puts"), puts(__VA_ARGS__))
+#define fputs(...) (RtCheck("fputs"), fputs(__VA_ARGS__))
+#define fputc(...) (RtCheck("fputc"), fputc(__VA_ARGS__))
+#define fopen(...) (RtCheck("fopen"), fopen(__VA_ARGS__))
+#define fclose(...) (RtCheck("fclose"), fclose(__VA_ARGS__))
+#define fread(...) (RtCheck("fread"), fread(__VA_ARGS__))
+#define fwrite(...) (RtCheck("fwrite"), fwrite(__VA_ARGS__))
+#define fflush(...) (RtCheck("fflush"), fflush(__VA_ARGS__))
+
+#else
+
+#define RtDebugInit()
+#define RtEnterAudioThread()
+#define RtLeaveAudioThread()
+#define RtCheck(NAME) ((void)0)
+
+#endif
+
+#endif
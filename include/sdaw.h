@@ -10,9 +10,12 @@
 #include "config.h"
 #include "lut.h"
 #include "debug.h"
+#include "rt_debug.h"
 #include "list.h"
+#include "spsc_queue.h"
 #include "str.h"
 #include "math_util.h"
+#include "fft.h"
 #include "arg_parser.h"
 #include "image.h"
 #include "audio.h"
@@ -23,6 +26,7 @@
 #include "image_interp.h"
 #include "audio_effect.h"
 #include "audio_convert.h"
+#include "fft_bench.h"
 
 #ifndef NO_ENGINE
   #include "engine.h"
@@ -0,0 +1,47 @@
+// spsc_queue.h
+// wait-free single producer, single consumer queue
+
+#ifndef _SPSC_QUEUE_H
+#define _SPSC_QUEUE_H
+
+#include <stdatomic.h>
+
+#define CACHE_LINE_SIZE 64
+
+typedef struct spsc_queue {
+  u8* Data;
+  u32 ElementSize;
+  u32 Capacity; // Number of elements, must be a power of two
+  _Alignas(CACHE_LINE_SIZE) _Atomic u32 Head; // Only written by the consumer
+  _Alignas(CACHE_LINE_SIZE) _Atomic u32 Tail; // Only written by the producer
+} spsc_queue;
+
+i32 SpscQueueInit(spsc_queue* Queue, u32 ElementSize, u32 Capacity);
+
+// Returns zero if the queue is full
+u8 SpscQueuePush(spsc_queue* Queue, const void* Element);
+
+// Returns zero if the queue is empty
+u8 SpscQueuePop(spsc_queue* Queue, void* Element);
+
+// Push all Count elements at once, returns zero (and pushes nothing) if they don't fit
+u8 SpscQueuePushMany(spsc_queue* Queue, const void* Elements, u32 Count);
+
+// Consumer side, points Elements to the elements at the front of the queue which are stored contiguously and returns
+// how many there are. They stay in the queue until they are released.
+u32 SpscQueuePeek(spsc_queue* Queue, void** Elements);
+
+// Consumer side, like SpscQueuePeek but also covers the elements which have wrapped around to the start of the
+// storage. Returns how many elements there are in total, the second region is empty if nothing has wrapped around.
+u32 SpscQueuePeekAll(spsc_queue* Queue, void* Regions[2], u32 Counts[2]);
+
+void SpscQueueRelease(spsc_queue* Queue, u32 Count);
+
+// Number of elements in the queue. From the producer's point of view this is an upper bound, and from the consumer's point of view a lower bound.
+u32 SpscQueueCount(spsc_queue* Queue);
+
+u32 SpscQueueSpace(spsc_queue* Queue);
+
+void SpscQueueFree(spsc_queue* Queue);
+
+#endif
@@ -1,6 +1,17 @@
 // stream.h
 
-i32 StreamInit(i32 FramesPerBuffer, i32 ChannelCount, const char* Path);
+#define MAX_STREAM_TRACK 256
+#define STREAM_MASTER_TRACK 0
+#define MAX_STREAM_CHANNEL 2
+
+// Opens the stream with the master track, which records to Path
+i32 StreamInit(i32 SampleRate, i32 FramesPerBuffer, i32 ChannelCount, const char* Path);
+
+// Add a track which is recorded alongside the master track, only possible until recording is started for the first
+// time. Returns the index of the track, or -1 if it couldn't be added.
+i32 StreamAddTrack(i32 ChannelCount, const char* Path);
+
+i32 StreamTrackCount();
 
 i32 StreamStartRecording();
 
@@ -8,6 +19,21 @@ i32 StreamStopRecording();
 
 u8 StreamIsRecording();
 
-i32 StreamWriteBuffer(float* Buffer, u32 BufferSize);
+// Frames which have been dropped because the writer didn't keep up
+u64 StreamDroppedFrames();
+
+// Audio thread side, called at the start of every buffer. Returns whether the buffer is recorded.
+u8 StreamBeginBuffer(i32 FrameCount);
+
+// Write interleaved frames to a track
+void StreamWriteTrack(i32 Track, f32* Buffer, i32 FrameCount);
+
+// Write planar frames to a track, channel N starts at Buffer + N * Stride
+void StreamWritePlanar(i32 Track, f32* Buffer, i32 ChannelCount, i32 Stride, i32 FrameCount);
+
+// Called after every block, Frames is where the block ends within the buffer
+void StreamEndBlock(i32 Frames);
+
+void StreamEndBuffer();
 
 void StreamFree();
@@ -14,6 +14,7 @@ enum element_type {
   ELEMENT_TEXT_BUTTON,
   ELEMENT_CONTAINER,
   ELEMENT_TOGGLE,
+  ELEMENT_PLOT,
 };
 
 typedef enum element_placement_mode {
@@ -33,6 +34,12 @@ typedef union element_data {
   struct {
     u8 ToggleValue;
   };
+  struct {
+    const f32* PlotValues; // 0-1, from the bottom to the top of the element. Must stay around until UI_Render.
+    i32 PlotCount;
+    v3 PlotColor;
+    u8 PlotFill;  // Bars that are filled from the bottom, otherwise a line
+  };
 } element_data;
 
 typedef struct ui_element {
@@ -104,6 +111,8 @@ i32 UI_DoBox(u32 ID, v2 Size, v3 Color);
 
 i32 UI_DoTextToggle(u32 ID, const char* Text, u8* Value);
 
+i32 UI_DoPlot(u32 ID, v2 Size, const f32* Values, i32 Count, v3 Color, u8 Fill);
+
 void UI_SetPlacement(element_placement_mode Mode);
 
 void UI_WindowResizeCallback(i32 Width, i32 Height);
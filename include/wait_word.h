@@ -0,0 +1,29 @@
+// wait_word.h
+// a 32-bit word which threads can sleep on until it changes, a futex on Linux and a condition variable elsewhere
+
+#ifndef _WAIT_WORD_H
+#define _WAIT_WORD_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+typedef struct wait_word {
+  _Atomic u32 Value;
+  _Atomic i32 Sleepers;
+#if !__linux__
+  pthread_mutex_t Lock;
+  pthread_cond_t Changed;
+#endif
+} wait_word;
+
+void WaitWordInit(wait_word* Word, u32 Value);
+
+// Sleep while the value is Expected, for at most TimeoutMs milliseconds unless it is zero. May return early.
+void WaitWordSleep(wait_word* Word, u32 Expected, i32 TimeoutMs);
+
+// Wake up at most Count sleepers, to be called after the value has been changed
+void WaitWordWake(wait_word* Word, i32 Count);
+
+void WaitWordFree(wait_word* Word);
+
+#endif
@@ -0,0 +1,34 @@
+// worker_pool.h
+
+#ifndef _WORKER_POOL_H
+#define _WORKER_POOL_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define MAX_WORKER_THREAD 64
+
+typedef void (*worker_job_cb)(void* Data, i32 JobIndex);
+
+typedef struct worker_pool {
+  pthread_t Threads[MAX_WORKER_THREAD];
+  i32 WorkerCount;
+  worker_job_cb Job;
+  void* Data;
+  _Atomic i32 JobCount;
+  _Atomic i32 JobsDone;
+  _Atomic u64 Work;  // Generation in the high 32 bits, index of the next job to claim in the low 32 bits
+  wait_word Signal; // Generation that the workers wait on
+  _Atomic i32 Started;  // Workers that have started running, used to give every worker an index
+  _Atomic u8 ShouldExit;
+} worker_pool;
+
+// A worker count less than zero will use one worker per available core (minus the calling thread)
+i32 WorkerPoolInit(worker_pool* Pool, i32 WorkerCount);
+
+// Run JobCount jobs on the pool, the calling thread takes part in processing the jobs. Returns when all jobs are done.
+void WorkerPoolRun(worker_pool* Pool, worker_job_cb Job, void* Data, i32 JobCount);
+
+void WorkerPoolFree(worker_pool* Pool);
+
+#endif
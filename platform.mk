@@ -17,13 +17,23 @@ ifndef PLATFORM
 	endif
 endif
 
-ifeq (${USE_PORTAUDIO}, 1)
+ifeq (${USE_NULL_AUDIO}, 1)
+	FLAGS+=-D USE_NULL_AUDIO
+else ifeq (${USE_PORTAUDIO}, 1)
 	LIB+=-lportaudio
 else ifeq (${USE_SDL}, 1)
 	LIB+=-lSDL2
 	FLAGS+=-D USE_SDL
 endif
 
+ifeq (${USE_AVX}, 1)
+	FLAGS+=-mavx2 -mfma
+endif
+
+ifeq (${RT_DEBUG}, 1)
+	FLAGS+=-D RT_DEBUG=1 -rdynamic
+endif
+
 ifeq (${PLATFORM}, LINUX)
 	LIB+=-lglfw -lGLEW -lGL -lGLU
 	DEBUG_PROG=gdb
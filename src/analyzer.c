@@ -0,0 +1,138 @@
+// analyzer.c
+// spectrum analyzer and oscilloscope, fed by taps which the audio thread writes to
+
+#define TAP_GUARD (TAP_SIZE / 4)  // Frames the audio thread may be writing ahead of what it has published, longer blocks are published in pieces
+
+static i32 AnalyzerInit(analyzer* Analyzer);
+static void UpdateSpectrum(analyzer* Analyzer, i32 SampleRate, f32 DeltaTime);
+static void UpdateScope(analyzer* Analyzer);
+
+void TapInit(audio_tap* Tap) {
+  memset(Tap->Buffer, 0, sizeof(Tap->Buffer));
+  atomic_init(&Tap->Written, 0);
+}
+
+void TapWrite(audio_tap* Tap, const f32* Left, const f32* Right, i32 FrameCount) {
+  u32 Written = atomic_load_explicit(&Tap->Written, memory_order_relaxed);
+  for (i32 Offset = 0; Offset < FrameCount;) {
+    i32 Count = Min(FrameCount - Offset, TAP_GUARD);
+    for (i32 FrameIndex = Offset; FrameIndex < Offset + Count; ++FrameIndex) {
+      Tap->Buffer[(Written + FrameIndex) & (TAP_SIZE - 1)] = 0.5f * (Left[FrameIndex] + Right[FrameIndex]);
+    }
+    Offset += Count;
+    atomic_store_explicit(&Tap->Written, Written + Offset, memory_order_release);
+  }
+}
+
+// NOTE(lucas): Copied first and checked afterwards, a copy that the audio thread could have lapped is thrown away
+u8 TapRead(audio_tap* Tap, f32* Out, i32 Count) {
+  Assert(Count <= TAP_SIZE - TAP_GUARD);
+  u32 End = atomic_load_explicit(&Tap->Written, memory_order_acquire);
+  if (End < (u32)Count) {
+    return 0;
+  }
+  u32 Start = End - Count;
+  i32 Offset = Start & (TAP_SIZE - 1);
+  i32 First = Min(Count, TAP_SIZE - Offset);
+  memcpy(Out, &Tap->Buffer[Offset], sizeof(f32) * First);
+  memcpy(&Out[First], Tap->Buffer, sizeof(f32) * (Count - First));
+  atomic_thread_fence(memory_order_acquire);
+  u32 Now = atomic_load_explicit(&Tap->Written, memory_order_relaxed);
+  return Now - Start <= TAP_SIZE - TAP_GUARD;
+}
+
+i32 AnalyzerInit(analyzer* Analyzer) {
+  memset(Analyzer, 0, sizeof(analyzer));
+  if (FftRealPlanInit(&Analyzer->Plan, ANALYZER_FFT_SIZE) != NoError) {
+    return Error;
+  }
+  Analyzer->Window = FftAlloc(ANALYZER_FFT_SIZE);
+  Analyzer->Time = FftAlloc(ANALYZER_FFT_SIZE);
+  Analyzer->Re = FftAlloc(ANALYZER_FFT_SIZE / 2 + 1);
+  Analyzer->Im = FftAlloc(ANALYZER_FFT_SIZE / 2 + 1);
+  Analyzer->Initialized = 1;
+  if (!Analyzer->Window || !Analyzer->Time || !Analyzer->Re || !Analyzer->Im) {
+    AnalyzerFree(Analyzer);
+    return Error;
+  }
+  for (i32 Index = 0; Index < ANALYZER_FFT_SIZE; ++Index) {
+    Analyzer->Window[Index] = 0.5f - 0.5f * cosf(2.0f * PI32 * Index / ANALYZER_FFT_SIZE);
+  }
+  for (i32 Index = 0; Index < SCOPE_POINT_COUNT; ++Index) {
+    Analyzer->Scope[Index] = 0.5f;
+  }
+  return NoError;
+}
+
+// Bands are spread logarithmically and show their loudest bin, a full scale sine ends up at 0 dB
+void UpdateSpectrum(analyzer* Analyzer, i32 SampleRate, f32 DeltaTime) {
+  i32 BinCount = ANALYZER_FFT_SIZE / 2 + 1;
+  f32 Scale = 4.0f / ANALYZER_FFT_SIZE; // Two over the sum of the window
+  f32 Nyquist = 0.5f * SampleRate;
+  f32 Release = 1.0f - expf(-DeltaTime / ANALYZER_RELEASE);
+  for (i32 Index = 0; Index < ANALYZER_FFT_SIZE; ++Index) {
+    Analyzer->Time[Index] *= Analyzer->Window[Index];
+  }
+  FftRealForward(&Analyzer->Plan, Analyzer->Time, Analyzer->Re, Analyzer->Im);
+
+  for (i32 Band = 0; Band < ANALYZER_BAND_COUNT; ++Band) {
+    f32 Low = ANALYZER_MIN_FREQ * powf(Nyquist / ANALYZER_MIN_FREQ, (f32)Band / ANALYZER_BAND_COUNT);
+    f32 High = ANALYZER_MIN_FREQ * powf(Nyquist / ANALYZER_MIN_FREQ, (f32)(Band + 1) / ANALYZER_BAND_COUNT);
+    i32 FirstBin = (i32)ceilf(Low * ANALYZER_FFT_SIZE / SampleRate);
+    i32 LastBin = Min((i32)(High * ANALYZER_FFT_SIZE / SampleRate), BinCount - 1);
+    if (FirstBin > LastBin) {
+      FirstBin = LastBin = Min((i32)(0.5f * (Low + High) * ANALYZER_FFT_SIZE / SampleRate + 0.5f), BinCount - 1);
+    }
+    f32 Power = 0;
+    for (i32 Bin = FirstBin; Bin <= LastBin; ++Bin) {
+      Power = Max(Power, Analyzer->Re[Bin] * Analyzer->Re[Bin] + Analyzer->Im[Bin] * Analyzer->Im[Bin]);
+    }
+    f32 Db = 10.0f * log10f(Scale * Scale * Power + 1e-20f);
+    f32 Level = Clamp((Db - ANALYZER_MIN_DB) / -ANALYZER_MIN_DB, 0.0f, 1.0f);
+    f32* Current = &Analyzer->Bands[Band];
+    *Current = Level > *Current ? Level : *Current + (Level - *Current) * Release;
+  }
+}
+
+// NOTE(lucas): Triggers on the last rising zero crossing with a whole window after it, so periodic signals stand still
+void UpdateScope(analyzer* Analyzer) {
+  f32* Samples = Analyzer->Time;
+  i32 Trigger = SCOPE_SIZE;
+  for (i32 Index = SCOPE_SIZE; Index > 0; --Index) {
+    if (Samples[Index - 1] < 0.0f && Samples[Index] >= 0.0f) {
+      Trigger = Index;
+      break;
+    }
+  }
+  for (i32 Point = 0; Point < SCOPE_POINT_COUNT; ++Point) {
+    f32 Sample = Samples[Trigger + Point * SCOPE_SIZE / SCOPE_POINT_COUNT];
+    Analyzer->Scope[Point] = 0.5f + 0.5f * (Clamp(Sample, -1.0f, 1.0f));
+  }
+}
+
+i32 AnalyzerUpdate(analyzer* Analyzer, audio_tap* Tap, i32 SampleRate, f32 DeltaTime) {
+  if (!Analyzer->Initialized) {
+    if (AnalyzerInit(Analyzer) != NoError) {
+      return Error;
+    }
+  }
+  if (TapRead(Tap, Analyzer->Time, ANALYZER_FFT_SIZE)) {
+    UpdateSpectrum(Analyzer, SampleRate, DeltaTime);
+  }
+  if (TapRead(Tap, Analyzer->Time, 2 * SCOPE_SIZE)) {
+    UpdateScope(Analyzer);
+  }
+  return NoError;
+}
+
+void AnalyzerFree(analyzer* Analyzer) {
+  if (!Analyzer->Initialized) {
+    return;
+  }
+  FftRealPlanFree(&Analyzer->Plan);
+  FftFree(Analyzer->Window, ANALYZER_FFT_SIZE);
+  FftFree(Analyzer->Time, ANALYZER_FFT_SIZE);
+  FftFree(Analyzer->Re, ANALYZER_FFT_SIZE / 2 + 1);
+  FftFree(Analyzer->Im, ANALYZER_FFT_SIZE / 2 + 1);
+  memset(Analyzer, 0, sizeof(analyzer));
+}
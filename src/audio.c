@@ -85,8 +85,140 @@ void CopyFloatBufferEliminateOdd(float* DestBuffer, float* SourceBuffer, i32 Siz
   }
 }
 
+static void MixFloatBuffer1(float* restrict Dest, float* restrict Source, float Gain, i32 SampleCount);
+static void MixFloatBuffer4(float* restrict Dest, float** Sources, float* Gains, i32 SampleCount);
+
+void MixFloatBuffer1(float* restrict Dest, float* restrict Source, float Gain, i32 SampleCount) {
+  i32 SampleIndex = 0;
+#if defined(SIMD_WIDTH)
+  simd_f32 G = SimdSet1(Gain);
+  for (; SampleIndex + SIMD_WIDTH <= SampleCount; SampleIndex += SIMD_WIDTH) {
+    simd_f32 Sum = SimdAdd(SimdLoad(&Dest[SampleIndex]), SimdMul(SimdLoad(&Source[SampleIndex]), G));
+    SimdStore(&Dest[SampleIndex], Sum);
+  }
+#endif
+  for (; SampleIndex < SampleCount; ++SampleIndex) {
+    Dest[SampleIndex] += Source[SampleIndex] * Gain;
+  }
+}
+
+// NOTE(lucas): Four sources per pass, so that the destination is only loaded and stored once for every four buses
+void MixFloatBuffer4(float* restrict Dest, float** Sources, float* Gains, i32 SampleCount) {
+  float* restrict S0 = Sources[0];
+  float* restrict S1 = Sources[1];
+  float* restrict S2 = Sources[2];
+  float* restrict S3 = Sources[3];
+  i32 SampleIndex = 0;
+#if defined(SIMD_WIDTH)
+  simd_f32 G0 = SimdSet1(Gains[0]);
+  simd_f32 G1 = SimdSet1(Gains[1]);
+  simd_f32 G2 = SimdSet1(Gains[2]);
+  simd_f32 G3 = SimdSet1(Gains[3]);
+  for (; SampleIndex + SIMD_WIDTH <= SampleCount; SampleIndex += SIMD_WIDTH) {
+    simd_f32 Sum = SimdLoad(&Dest[SampleIndex]);
+    Sum = SimdAdd(Sum, SimdMul(SimdLoad(&S0[SampleIndex]), G0));
+    Sum = SimdAdd(Sum, SimdMul(SimdLoad(&S1[SampleIndex]), G1));
+    Sum = SimdAdd(Sum, SimdMul(SimdLoad(&S2[SampleIndex]), G2));
+    Sum = SimdAdd(Sum, SimdMul(SimdLoad(&S3[SampleIndex]), G3));
+    SimdStore(&Dest[SampleIndex], Sum);
+  }
+#endif
+  for (; SampleIndex < SampleCount; ++SampleIndex) {
+    Dest[SampleIndex] += S0[SampleIndex] * Gains[0] + S1[SampleIndex] * Gains[1] + S2[SampleIndex] * Gains[2] + S3[SampleIndex] * Gains[3];
+  }
+}
+
+void MixFloatBuffers(float* restrict Dest, float** Sources, float* Gains, i32 SourceCount, i32 SampleCount) {
+  i32 SourceIndex = 0;
+  for (; SourceIndex + 4 <= SourceCount; SourceIndex += 4) {
+    MixFloatBuffer4(Dest, &Sources[SourceIndex], &Gains[SourceIndex], SampleCount);
+  }
+  for (; SourceIndex < SourceCount; ++SourceIndex) {
+    MixFloatBuffer1(Dest, Sources[SourceIndex], Gains[SourceIndex], SampleCount);
+  }
+}
+
+void MeasureFloatBuffer(float* Buffer, i32 SampleCount, float* Peak, float* Power) {
+  float Max = 0.0f;
+  float Sum = 0.0f;
+  i32 SampleIndex = 0;
+#if defined(SIMD_WIDTH)
+  simd_f32 MaxV = SimdSet1(0.0f);
+  simd_f32 SumV = SimdSet1(0.0f);
+  for (; SampleIndex + SIMD_WIDTH <= SampleCount; SampleIndex += SIMD_WIDTH) {
+    simd_f32 Sample = SimdLoad(&Buffer[SampleIndex]);
+    MaxV = SimdMax(MaxV, SimdAbs(Sample));
+    SumV = SimdAdd(SumV, SimdMul(Sample, Sample));
+  }
+  float Lanes[2][SIMD_WIDTH];
+  SimdStore(Lanes[0], MaxV);
+  SimdStore(Lanes[1], SumV);
+  for (i32 Lane = 0; Lane < SIMD_WIDTH; ++Lane) {
+    Max = Lanes[0][Lane] > Max ? Lanes[0][Lane] : Max;
+    Sum += Lanes[1][Lane];
+  }
+#endif
+  for (; SampleIndex < SampleCount; ++SampleIndex) {
+    float Sample = Abs(Buffer[SampleIndex]);
+    Max = Sample > Max ? Sample : Max;
+    Sum += Sample * Sample;
+  }
+  *Peak = Max;
+  *Power = SampleCount > 0 ? Sum / SampleCount : 0.0f;
+}
+
+void ScaleFloatBuffer(float* Buffer, float Gain, i32 SampleCount) {
+  i32 SampleIndex = 0;
+#if defined(SIMD_WIDTH)
+  simd_f32 G = SimdSet1(Gain);
+  for (; SampleIndex + SIMD_WIDTH <= SampleCount; SampleIndex += SIMD_WIDTH) {
+    SimdStore(&Buffer[SampleIndex], SimdMul(SimdLoad(&Buffer[SampleIndex]), G));
+  }
+#endif
+  for (; SampleIndex < SampleCount; ++SampleIndex) {
+    Buffer[SampleIndex] *= Gain;
+  }
+}
+
+// NOTE(lucas): Going between planar and interleaved is purely a matter of memory bandwidth, so SSE is plenty here
+void InterleaveFloatBuffer(float* restrict Dest, float* restrict Left, float* restrict Right, i32 FrameCount) {
+  i32 FrameIndex = 0;
+#if USE_SSE
+  for (; FrameIndex + 4 <= FrameCount; FrameIndex += 4) {
+    __m128 L = _mm_loadu_ps(&Left[FrameIndex]);
+    __m128 R = _mm_loadu_ps(&Right[FrameIndex]);
+    _mm_storeu_ps(&Dest[2 * FrameIndex], _mm_unpacklo_ps(L, R));
+    _mm_storeu_ps(&Dest[2 * FrameIndex + 4], _mm_unpackhi_ps(L, R));
+  }
+#endif
+  for (; FrameIndex < FrameCount; ++FrameIndex) {
+    Dest[2 * FrameIndex] = Left[FrameIndex];
+    Dest[2 * FrameIndex + 1] = Right[FrameIndex];
+  }
+}
+
+void DeinterleaveFloatBuffer(float* restrict Left, float* restrict Right, float* restrict Source, i32 FrameCount) {
+  i32 FrameIndex = 0;
+#if USE_SSE
+  for (; FrameIndex + 4 <= FrameCount; FrameIndex += 4) {
+    __m128 A = _mm_loadu_ps(&Source[2 * FrameIndex]);
+    __m128 B = _mm_loadu_ps(&Source[2 * FrameIndex + 4]);
+    _mm_storeu_ps(&Left[FrameIndex], _mm_shuffle_ps(A, B, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(&Right[FrameIndex], _mm_shuffle_ps(A, B, _MM_SHUFFLE(3, 1, 3, 1)));
+  }
+#endif
+  for (; FrameIndex < FrameCount; ++FrameIndex) {
+    Left[FrameIndex] = Source[2 * FrameIndex];
+    Right[FrameIndex] = Source[2 * FrameIndex + 1];
+  }
+}
+
 i32 LoadAudioSource(const char* Path, audio_source* Source) {
   char* Ext = FetchExtension(Path);
+  if (!Ext) {
+    fprintf(stderr, "%s: File '%s' has no extension\n", __FUNCTION__, Path);
+    return Error;
+  }
   if (!strncmp(Ext, ".wav", MAX_PATH_SIZE)) {
     return LoadWAVE(Path, Source);
   }
@@ -107,6 +239,10 @@ i32 LoadAudioSourceFromDataPath(const char* Path, audio_source* Source) {
 
 i32 StoreAudioSource(const char* Path, audio_source* Source) {
   char* Ext = FetchExtension(Path);
+  if (!Ext) {
+    fprintf(stderr, "%s: File '%s' has no extension\n", __FUNCTION__, Path);
+    return Error;
+  }
   if (!strncmp(Ext, ".wav", MAX_PATH_SIZE)) {
     return StoreWAVE(Path, Source);
   }
@@ -1,28 +1,5 @@
 // audio_effect.c
 
-enum effect_type {
-  EFFECT_NONE,
-  EFFECT_DISTORTION,
-  EFFECT_WEIRD_01,
-  EFFECT_WEIRD_02,
-
-  MAX_EFFECT_TYPE,
-};
-
-const char* EffectTypeDesc[MAX_EFFECT_TYPE] = {
-  "none",
-  "distortion",
-  "weird",
-  "weird 2",
-};
-
-effect_func EffectFuncs[MAX_EFFECT_TYPE] = {
-  StubEffect,
-  Distortion,
-  WeirdEffect,
-  WeirdEffect2,
-};
-
 typedef struct audio_effect_args {
   char* Input;
   char* Output;
@@ -34,29 +11,51 @@ typedef struct audio_effect_args {
 
 static i32 AudioEffectPrintHelp(FILE* File);
 static i32 AudioEffectRun(audio_effect_args* Args);
+static void ApplyEffect(i32 EffectType, audio_source* Audio, f32 Mix, f32 Value);
 
 i32 AudioEffectPrintHelp(FILE* File) {
   i32 Result = NoError;
 
   fprintf(File, "EFFECTS:\n");
   for (u32 EffectType = 0; EffectType < MAX_EFFECT_TYPE; ++EffectType) {
-    fprintf(File, "   %i: %s\n", EffectType, EffectTypeDesc[EffectType]);
+    fprintf(File, "   %i: %s\n", EffectType, EffectDefs[EffectType].Name);
   }
 
   return Result;
 }
 
+// NOTE(lucas): Every channel gets an instance of its own and is processed on its own, the same way as on a bus
+void ApplyEffect(i32 EffectType, audio_source* Audio, f32 Mix, f32 Value) {
+  i32 ChannelCount = Max(Audio->ChannelCount, 1);
+  i32 FrameCount = Audio->SampleCount / ChannelCount;
+  f32* Channel = M_Malloc(sizeof(f32) * FrameCount);
+  if (!Channel) {
+    return;
+  }
+  for (i32 ChannelIndex = 0; ChannelIndex < ChannelCount; ++ChannelIndex) {
+    effect* Effect = EffectCreate(EffectType, ChannelIndex, Mix, Value);
+    if (!Effect) {
+      break;
+    }
+    for (i32 FrameIndex = 0; FrameIndex < FrameCount; ++FrameIndex) {
+      Channel[FrameIndex] = Audio->Buffer[FrameIndex * ChannelCount + ChannelIndex];
+    }
+    EffectProcess(Effect, Channel, 1, FrameCount);
+    for (i32 FrameIndex = 0; FrameIndex < FrameCount; ++FrameIndex) {
+      Audio->Buffer[FrameIndex * ChannelCount + ChannelIndex] = Channel[FrameIndex];
+    }
+    EffectDestroy(Effect);
+  }
+  M_Free(Channel, sizeof(f32) * FrameCount);
+}
+
 i32 AudioEffectRun(audio_effect_args* Args) {
   i32 Result = NoError;
 
   audio_source Audio;
   if ((Result = LoadAudioSource(Args->Input, &Audio)) == NoError) {
-    if (Args->EffectType >= 0 && Args->EffectType < MAX_EFFECT_TYPE) {
-      EffectFuncs[Args->EffectType](Audio.Buffer, 1, Audio.SampleCount, Args->Mix, Args->Value);
-    }
-    if (Args->SecondaryEffectType >= 0 && Args->SecondaryEffectType < MAX_EFFECT_TYPE) {
-      EffectFuncs[Args->SecondaryEffectType](Audio.Buffer, 1, Audio.SampleCount, Args->Mix, Args->Value);
-    }
+    ApplyEffect(Args->EffectType, &Audio, Args->Mix, Args->Value);
+    ApplyEffect(Args->SecondaryEffectType, &Audio, Args->Mix, Args->Value);
     StoreAudioSource(Args->Output, &Audio);
     UnloadAudioSource(&Audio);
   }
@@ -2,17 +2,33 @@
 
 audio_engine AudioEngine;
 
-i32 AudioEngineInit(audio_engine* Engine, i32 SampleRate, i32 FramesPerBuffer);
-
-#if USE_SDL
+// NOTE(lucas): The device backend is picked at build time, the null backend is always there
+#if USE_NULL_AUDIO
+  #include "audio_none.c"
+#elif USE_SDL
   #include "audio_sdl.c"
 #else
   #include "audio_pa.c"
 #endif
+#include "audio_null.c"
 
-i32 AudioEngineStateInit(i32 SampleRate, i32 FramesPerBuffer) {
-  audio_engine* Engine = &AudioEngine;
+#define RECORD_PATH "record"
+
+static u8 UseNullAudio = 0;
+
+static i32 AudioEngineInit(audio_engine* Engine, i32 SampleRate, i32 FramesPerBuffer);
+static i32 AudioEngineInit(audio_engine* Engine, i32 SampleRate, i32 FramesPerBuffer) {
+  UseNullAudio = USE_NULL_AUDIO || G_AudioNull != 0;
+  if (!UseNullAudio) {
+    return AudioDeviceInit(Engine, SampleRate, FramesPerBuffer);
+  }
+  return NullAudioInit(SampleRate, FramesPerBuffer, G_AudioNull == NullAudioFreeRun ? NullAudioFreeRun : NullAudioRealTime);
+}
+
+void AudioEngineResetState(audio_engine* Engine, i32 SampleRate, i32 FramesPerBuffer);
+static void ReceiveMidiEvents(audio_engine* Engine);
 
+void AudioEngineResetState(audio_engine* Engine, i32 SampleRate, i32 FramesPerBuffer) {
   Engine->SampleRate = SampleRate;
   Engine->FramesPerBuffer = FramesPerBuffer;
   Engine->Tick = 0;
@@ -23,8 +39,38 @@ i32 AudioEngineStateInit(i32 SampleRate, i32 FramesPerBuffer) {
   Engine->Playing = 1;
   Engine->Recording = 0;
   Engine->Initialized = 1;
+  Engine->Offline = 0;
+  Engine->ThreadSetup = 0;
+  Engine->InputTrack = -1;
+  Engine->MidiEventCount = 0;
+  DspLoadInit(&Engine->Load, SampleRate, FramesPerBuffer);
+}
+
+// NOTE(lucas): Events are played a buffer late at the same position, which keeps the timing between them intact
+void ReceiveMidiEvents(audio_engine* Engine) {
+  midi_timed_event* Events = ArenaPush(&Engine->Mixer.Scratch, sizeof(midi_timed_event) * MAX_MIDI_EVENT);
+  if (!Events) {
+    return;
+  }
+  i64 Now = MidiTime();
+  f64 FramesPerNanosecond = Engine->SampleRate / 1000000000.0;
+  u32 EventCount = MidiFetchEvents(Events, MAX_MIDI_EVENT);
+  for (u32 EventIndex = 0; EventIndex < EventCount; ++EventIndex) {
+    i64 Age = (i64)((Now - Events[EventIndex].Time) * FramesPerNanosecond);
+    i32 Frame = Engine->FramesPerBuffer - (i32)Min(Age, (i64)Engine->FramesPerBuffer);
+    Engine->MidiEvents[EventIndex] = (midi_frame_event) {
+      .Event = Events[EventIndex].Event,
+      .Frame = Min(Frame, Engine->FramesPerBuffer - 1),
+    };
+  }
+  Engine->MidiEventCount = EventCount;
+}
+
+i32 AudioEngineStateInit(i32 SampleRate, i32 FramesPerBuffer) {
+  audio_engine* Engine = &AudioEngine;
+  AudioEngineResetState(Engine, SampleRate, FramesPerBuffer);
 
-  StreamInit(FramesPerBuffer, 2, "record.data");
+  StreamInit(SampleRate, FramesPerBuffer, 2, RECORD_PATH ".wav");
 
   i32 Result = NoError;
   if ((Result = AudioEngineInit(Engine, SampleRate, FramesPerBuffer) != NoError)) {
@@ -33,11 +79,26 @@ i32 AudioEngineStateInit(i32 SampleRate, i32 FramesPerBuffer) {
   return Result;
 }
 
+// Sets up the engine state without an audio device or record stream, for driving AudioEngineProcess by hand
+i32 AudioEngineOfflineInit(i32 SampleRate, i32 FramesPerBuffer) {
+  AudioEngineResetState(&AudioEngine, SampleRate, FramesPerBuffer);
+  AudioEngine.Offline = 1;
+  return NoError;
+}
+
+// NOTE(lucas): Tracks are added when recording first starts, and cover the same frames as the master recording
 i32 AudioEngineStartRecording() {
-  if (!StreamIsRecording()) {
-    StreamStartRecording();
+  audio_engine* Engine = &AudioEngine;
+  if (StreamIsRecording()) {
+    return NoError;
   }
-  return NoError;
+  if (G_RecordMultitrack && StreamTrackCount() == 1) {
+    if (G_AudioInput) {
+      Engine->InputTrack = StreamAddTrack(2, RECORD_PATH "_input.wav");
+    }
+    MixerAddRecordTracks(&Engine->Mixer, RECORD_PATH);
+  }
+  return StreamStartRecording();
 }
 
 i32 AudioEngineStopRecording() {
@@ -48,36 +109,105 @@ i32 AudioEngineStopRecording() {
 }
 
 i32 AudioEngineProcess(const void* InBuffer, void* OutBuffer) {
-  TIMER_START();
+  return AudioEngineProcessFrames(InBuffer, OutBuffer, AudioEngine.FramesPerBuffer);
+}
+
+i32 AudioEngineProcessFrames(const void* InBuffer, void* OutBuffer, i32 FramesPerBuffer) {
+  Assert(FramesPerBuffer <= AudioEngine.FramesPerBuffer);
+  RtEnterAudioThread();
+  i64 Start = DspLoadTime();
 
   audio_engine* Engine = &AudioEngine;
   mixer* Mixer = &Engine->Mixer;
 
-  Engine->In = (float*)InBuffer;
-  Engine->Out = (float*)OutBuffer;
+  float* In = (float*)InBuffer;
+  float* Out = (float*)OutBuffer;
+
+  if (!Engine->ThreadSetup) {
+    AudioThreadSetup(!Engine->Offline);
+    Engine->ThreadSetup = 1;
+  }
+  ArenaReset(&Mixer->Scratch);
+  MixerProcessCommands(Mixer);
+  Mixer->Recording = StreamBeginBuffer(FramesPerBuffer);
+
+  // NOTE(lucas): Events stay queued while we aren't playing, so that instruments still get the note offs
+  Engine->MidiEventCount = 0;
+  if (Mixer->Active && Engine->Playing) {
+    ReceiveMidiEvents(Engine);
+  }
 
-  if (Mixer->Active) {
-    MixerClearBuffers(Mixer);
-    MixerSumBuses(Mixer, Engine->Playing, Engine->Out, Engine->In);
-    if (Engine->Recording) {
-      StreamWriteBuffer(Engine->Out, sizeof(float) * MASTER_CHANNEL_COUNT * Engine->FramesPerBuffer);
+  // NOTE(lucas): One block at a time, so that instruments see the clock at the start of every block
+  i32 EventIndex = 0;
+  for (i32 Offset = 0; Offset < FramesPerBuffer; Offset += Mixer->BlockSize) {
+    i32 FrameCount = Min(Mixer->BlockSize, FramesPerBuffer - Offset);
+    Engine->In = In ? &In[2 * Offset] : NULL;
+    Engine->Out = &Out[MASTER_CHANNEL_COUNT * Offset];
+    Mixer->MidiEvents = &Engine->MidiEvents[EventIndex];
+    Mixer->MidiEventCount = 0;
+    for (; EventIndex < Engine->MidiEventCount && Engine->MidiEvents[EventIndex].Frame < Offset + FrameCount; ++EventIndex) {
+      Engine->MidiEvents[EventIndex].Frame -= Offset;
+      ++Mixer->MidiEventCount;
+    }
+    if (Mixer->Active) {
+      MixerSumBuses(Mixer, Engine->Playing, Engine->Out, Engine->In, FrameCount);
+    }
+    else {
+      ClearFloatBuffer(Engine->Out, sizeof(float) * MASTER_CHANNEL_COUNT * FrameCount);
+    }
+    if (Mixer->Recording) {
+      StreamWriteTrack(STREAM_MASTER_TRACK, Engine->Out, FrameCount);
+      if (Engine->In) {
+        StreamWriteTrack(Engine->InputTrack, Engine->In, FrameCount);
+      }
+      StreamEndBlock(Offset + FrameCount);
+    }
+    if (Engine->Playing) {
+      Engine->DeltaTime = (float)FrameCount / Engine->SampleRate;
+      Engine->Tick += FrameCount;
+      Engine->Time = (float)((f64)Engine->Tick / Engine->SampleRate);
     }
   }
-  else {
-    ClearFloatBuffer(Engine->Out, sizeof(float) * MASTER_CHANNEL_COUNT * Engine->FramesPerBuffer);
+  Engine->In = In;
+  Engine->Out = Out;
+  Mixer->MidiEvents = NULL;
+  Mixer->MidiEventCount = 0;
+
+  if (Mixer->Recording) {
+    StreamEndBuffer();
+    Mixer->Recording = 0;
   }
-  if (AudioEngine.Playing) {
-    const float DeltaTime = (1.0f / Engine->SampleRate) * Engine->FramesPerBuffer;
-    Engine->DeltaTime = DeltaTime;
-    Engine->Time += DeltaTime;
-    Engine->Tick += Engine->FramesPerBuffer;
+  DspLoadUpdate(&Engine->Load, Start);
+  RtLeaveAudioThread();
+  return NoError;
+}
+
+i32 AudioEngineStart(callback Callback) {
+  i32 Result = UseNullAudio ? NullAudioStart() : AudioDeviceStart();
+  if (Result != NoError) {
+    return Result;
+  }
+  if (!AudioEngine.Initialized) {
+    return Error;
+  }
+  if (Callback) {
+    Callback(&AudioEngine);
   }
-  TIMER_END();
   return NoError;
 }
 
+void AudioEngineExit() {
+  if (UseNullAudio) {
+    NullAudioExit();
+  }
+  else {
+    AudioDeviceExit();
+  }
+}
+
+// NOTE(lucas): The audio thread is stopped before the record stream goes away
 void AudioEngineTerminate() {
   AudioEngineStopRecording();
-  StreamFree();
   AudioEngineExit();
+  StreamFree();
 }
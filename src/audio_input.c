@@ -4,8 +4,6 @@
 typedef struct audio_input_data {
   u8 MonoL;
   u8 MonoR;
-  u8 Distort;
-  u8 Weird;
 } audio_input_data;
 
 i32 AudioInputInit(instrument* Ins) {
@@ -14,8 +12,6 @@ i32 AudioInputInit(instrument* Ins) {
     audio_input_data* Data = (audio_input_data*)Ins->UserData.Data;
     Data->MonoL = 0;
     Data->MonoR = 0;
-    Data->Distort = 0;
-    Data->Weird = 0;
   }
   return Result;
 }
@@ -32,20 +28,16 @@ i32 AudioInputProcess(instrument* Ins, bus* Bus, i32 FramesPerBuffer, i32 Sample
   }
 
   if (Bus->Buffer && Input) {
-    if (Data->MonoL) {
-      CopyFloatBufferEliminateEven(Bus->Buffer, Input, sizeof(float) * Bus->ChannelCount * FramesPerBuffer);
-    }
-    else if (Data->MonoR) {
-      CopyFloatBufferEliminateOdd(Bus->Buffer, Input, sizeof(float) * Bus->ChannelCount * FramesPerBuffer);
+    float* Left = &Bus->Buffer[0];
+    float* Right = &Bus->Buffer[(Bus->ChannelCount - 1) * Bus->Stride];
+    if (Data->MonoL || Data->MonoR || Bus->ChannelCount == 1) {
+      i32 InputChannel = Data->MonoR ? 1 : 0;
+      for (i32 FrameIndex = 0; FrameIndex < FramesPerBuffer; ++FrameIndex) {
+        Left[FrameIndex] = Right[FrameIndex] = Input[2 * FrameIndex + InputChannel];
+      }
     }
     else {
-      CopyFloatBuffer(Bus->Buffer, Input, sizeof(float) * Bus->ChannelCount * FramesPerBuffer);
-    }
-    if (Data->Weird) {
-      WeirdEffect(Bus->Buffer, Bus->ChannelCount, FramesPerBuffer, 0.25f, 2000.0f);
-    }
-    if (Data->Distort) {
-      Distortion(Bus->Buffer, Bus->ChannelCount, FramesPerBuffer, 0.25f, 80.0f);
+      DeinterleaveFloatBuffer(Left, Right, Input, FramesPerBuffer);
     }
   }
   return NoError;
@@ -55,8 +47,6 @@ i32 AudioInputDraw(instrument* Ins) {
   audio_input_data* Data = (audio_input_data*)Ins->UserData.Data;
   UI_DoTextToggle(UI_ID, "Stereo -> Mono (L)", &Data->MonoL);
   UI_DoTextToggle(UI_ID, "Stereo -> Mono (R)", &Data->MonoR);
-  UI_DoTextToggle(UI_ID, "Distort", &Data->Distort);
-  UI_DoTextToggle(UI_ID, "Weird", &Data->Weird);
   return NoError;
 }
 
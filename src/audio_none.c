@@ -0,0 +1,14 @@
+// audio_none.c
+// stand-in for the audio device backend when the program is built without one, see audio_null.c
+
+i32 AudioDeviceInit(audio_engine* Engine, i32 SampleRate, i32 FramesPerBuffer) {
+  fprintf(stderr, "No audio device backend, built with USE_NULL_AUDIO\n");
+  return Error;
+}
+
+i32 AudioDeviceStart() {
+  return Error;
+}
+
+void AudioDeviceExit() {
+}
@@ -0,0 +1,134 @@
+// audio_null.c
+// audio backend without an audio device, the engine is driven by a thread of our own either in (simulated) real time
+// or as fast as possible
+
+typedef struct null_audio {
+  pthread_t Thread;
+  u8 ThreadRunning;
+  _Atomic u8 ShouldExit;
+  _Atomic u64 BufferCount;
+  null_audio_mode Mode;
+  i32 SampleRate;
+  i32 FramesPerBuffer;
+  f32* In;  // Test tone, NULL when audio input is disabled
+  f32* Out;
+  null_audio_output Output;
+  void* UserData;
+} null_audio;
+
+static null_audio NullAudio = {0};
+
+static void SleepUntil(i64 Time);
+static void ProcessBuffer(null_audio* Null);
+static void* NullAudioThread(void* Data);
+
+void SleepUntil(i64 Time) {
+#if __linux__
+  struct timespec Deadline = { .tv_sec = Time / 1000000000, .tv_nsec = Time % 1000000000 };
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &Deadline, NULL) == EINTR);
+#else
+  i64 Now = DspLoadTime();
+  if (Time > Now) {
+    usleep((Time - Now) / 1000);
+  }
+#endif
+}
+
+void ProcessBuffer(null_audio* Null) {
+  AudioEngineProcess(Null->In, Null->Out);
+  if (Null->Output) {
+    Null->Output(Null->Out, Null->FramesPerBuffer, Null->UserData);
+  }
+  atomic_fetch_add_explicit(&Null->BufferCount, 1, memory_order_relaxed);
+}
+
+// NOTE(lucas): A buffer done past the next deadline is an underflow, and the clock starts over instead of catching up
+void* NullAudioThread(void* Data) {
+  null_audio* Null = (null_audio*)Data;
+  i64 Period = (i64)Null->FramesPerBuffer * 1000000000 / Null->SampleRate;
+  i64 Due = DspLoadTime();
+  while (!atomic_load_explicit(&Null->ShouldExit, memory_order_relaxed)) {
+    ProcessBuffer(Null);
+    if (Null->Mode == NullAudioRealTime) {
+      Due += Period;
+      i64 Now = DspLoadTime();
+      if (Now > Due) {
+        DspLoadXrun(&AudioEngine.Load, XrunOutputUnderflow);
+        Due = Now;
+      }
+      else {
+        SleepUntil(Due);
+      }
+    }
+  }
+  return NULL;
+}
+
+i32 NullAudioInit(i32 SampleRate, i32 FramesPerBuffer, null_audio_mode Mode) {
+  null_audio* Null = &NullAudio;
+  Null->ThreadRunning = 0;
+  atomic_init(&Null->ShouldExit, 0);
+  atomic_init(&Null->BufferCount, 0);
+  Null->Mode = Mode;
+  Null->SampleRate = SampleRate;
+  Null->FramesPerBuffer = FramesPerBuffer;
+  Null->In = G_AudioInput ? M_Calloc(sizeof(f32), 2 * FramesPerBuffer) : NULL;
+  Null->Out = M_Calloc(sizeof(f32), 2 * FramesPerBuffer);
+  if (!Null->Out) {
+    return Error;
+  }
+  for (i32 FrameIndex = 0; Null->In && FrameIndex < FramesPerBuffer; ++FrameIndex) {
+    Null->In[2 * FrameIndex] = Null->In[2 * FrameIndex + 1] = 0.25f * sinf(2 * PI32 * 440.0f * FrameIndex / SampleRate);
+  }
+  fprintf(stdout, "Using null audio backend (%s)\n", Mode == NullAudioFreeRun ? "as fast as possible" : "real time");
+  return NoError;
+}
+
+i32 NullAudioStart() {
+  null_audio* Null = &NullAudio;
+  if (Null->ThreadRunning) {
+    return NoError;
+  }
+  if (pthread_create(&Null->Thread, NULL, NullAudioThread, (void*)Null) != 0) {
+    fprintf(stderr, "Failed to create null audio thread\n");
+    return Error;
+  }
+  Null->ThreadRunning = 1;
+  return NoError;
+}
+
+void NullAudioRun(u64 BufferCount) {
+  null_audio* Null = &NullAudio;
+  Assert(!Null->ThreadRunning);
+  for (u64 BufferIndex = 0; BufferIndex < BufferCount; ++BufferIndex) {
+    ProcessBuffer(Null);
+  }
+}
+
+void NullAudioSetOutput(null_audio_output Output, void* UserData) {
+  NullAudio.Output = Output;
+  NullAudio.UserData = UserData;
+}
+
+u64 NullAudioBufferCount() {
+  return atomic_load_explicit(&NullAudio.BufferCount, memory_order_relaxed);
+}
+
+void NullAudioExit() {
+  null_audio* Null = &NullAudio;
+  if (Null->ThreadRunning) {
+    atomic_store(&Null->ShouldExit, 1);
+    pthread_join(Null->Thread, NULL);
+    Null->ThreadRunning = 0;
+  }
+  if (Null->In) {
+    M_Free(Null->In, sizeof(f32) * 2 * Null->FramesPerBuffer);
+    Null->In = NULL;
+  }
+  if (Null->Out) {
+    M_Free(Null->Out, sizeof(f32) * 2 * Null->FramesPerBuffer);
+    Null->Out = NULL;
+  }
+  Null->Output = NULL;
+  Null->UserData = NULL;
+}
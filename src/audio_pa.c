@@ -7,8 +7,16 @@ static PaStreamParameters OutPort;
 static PaStreamParameters InPort;
 
 static i32 StereoCallback(const void* InBuffer, void* OutBuffer, unsigned long FramesPerBuffer, const PaStreamCallbackTimeInfo* TimeInfo, PaStreamCallbackFlags Flags, void* UserData) {
-  (void)InBuffer; (void)TimeInfo; (void)Flags; (void)UserData;
-
+  (void)InBuffer; (void)TimeInfo; (void)UserData;
+
+  u32 Xruns = 0;
+  if (Flags & paInputUnderflow) { Xruns |= XrunInputUnderflow; }
+  if (Flags & paInputOverflow) { Xruns |= XrunInputOverflow; }
+  if (Flags & paOutputUnderflow) { Xruns |= XrunOutputUnderflow; }
+  if (Flags & paOutputOverflow) { Xruns |= XrunOutputOverflow; }
+  if (Xruns) {
+    DspLoadXrun(&AudioEngine.Load, Xruns);
+  }
   AudioEngineProcess(InBuffer, OutBuffer);
 
   return paContinue;
@@ -41,7 +49,7 @@ static i32 OpenStream() {
   return NoError;
 }
 
-i32 AudioEngineInit(audio_engine* Engine, i32 SampleRate, i32 FramesPerBuffer) {
+i32 AudioDeviceInit(audio_engine* Engine, i32 SampleRate, i32 FramesPerBuffer) {
   PaError Err = Pa_Initialize();
   if (Err != paNoError) {
     Pa_Terminate();
@@ -86,23 +94,11 @@ i32 AudioEngineInit(audio_engine* Engine, i32 SampleRate, i32 FramesPerBuffer) {
   return NoError;
 }
 
-i32 AudioEngineStart(callback Callback) {
-  i32 Result = OpenStream();
-  if (Result != NoError) {
-    return Result;
-  }
-
-  if (!AudioEngine.Initialized) {
-    return Error;
-  }
-  if (Callback) {
-    Callback(&AudioEngine);
-  }
-
-  return NoError;
+i32 AudioDeviceStart() {
+  return OpenStream();
 }
 
-void AudioEngineExit() {
+void AudioDeviceExit() {
   Pa_CloseStream(Stream);
   Pa_Terminate();
 }
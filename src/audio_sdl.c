@@ -10,6 +10,7 @@ static i32 OutputDevice = 0;
 
 static void* StereoThreadCallback(void* UserData);
 
+// NOTE(lucas): SDL doesn't tell us about xruns, so only the callbacks that run late are accounted for
 void StereoCallback(void* UserData, u8* Stream, i32 Length) {
   if (Length <= 0) {
     return;
@@ -17,7 +18,7 @@ void StereoCallback(void* UserData, u8* Stream, i32 Length) {
   AudioEngineProcess(NULL, (void*)Stream);
 }
 
-i32 AudioEngineInit(audio_engine* Engine, i32 SampleRate, i32 FramesPerBuffer) {
+i32 AudioDeviceInit(audio_engine* Engine, i32 SampleRate, i32 FramesPerBuffer) {
   if (SDL_Init(SDL_INIT_AUDIO) != 0) {
     fprintf(stderr, "Failed to initialize SDL audio subsystem\n");
     return Error;
@@ -94,20 +95,13 @@ i32 AudioEngineInit(audio_engine* Engine, i32 SampleRate, i32 FramesPerBuffer) {
   return NoError;
 }
 
-i32 AudioEngineStart(callback Callback) {
+i32 AudioDeviceStart() {
   SDL_PauseAudioDevice(OutputDevice, 0);
   SDL_PauseAudioDevice(InputDevice, 0);
-  if (!AudioEngine.Initialized) {
-    return Error;
-  }
-
-  if (Callback) {
-    Callback(&AudioEngine);
-  }
   return NoError;
 }
 
-void AudioEngineExit() {
+void AudioDeviceExit() {
   SDL_CloseAudioDevice(InputDevice);
   SDL_CloseAudioDevice(OutputDevice);
   SDL_AudioQuit();
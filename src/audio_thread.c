@@ -0,0 +1,162 @@
+// audio_thread.c
+// scheduling, cpu affinity, floating point and memory setup of the threads which do audio processing
+
+#include <errno.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+#if __linux__
+#include <sys/syscall.h>
+#endif
+
+#define MAX_CPU 1024
+
+audio_thread_report AudioThreadReport = {0};
+
+static setup_result SetPriority(i32 Priority);
+static setup_result SetAffinity(i32 Cpu);
+static setup_result FlushDenormals();
+static void PrintResult(FILE* File, const char* Name, setup_result* Result, const char* Detail, const char* Hint);
+
+setup_result SetPriority(i32 Priority) {
+  if (Priority <= 0) {
+    return (setup_result) { .Status = SetupDisabled };
+  }
+  struct sched_param Param = {
+    .sched_priority = Clamp(Priority, sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO)),
+  };
+  i32 Err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &Param);
+  return (setup_result) { .Status = Err ? SetupFailed : SetupDone, .Error = Err };
+}
+
+// NOTE(lucas): Goes through the system call so that we don't depend on the GNU extensions of pthread
+setup_result SetAffinity(i32 Cpu) {
+  if (Cpu < 0) {
+    return (setup_result) { .Status = SetupDisabled };
+  }
+#if __linux__
+  if (Cpu >= MAX_CPU) {
+    return (setup_result) { .Status = SetupFailed, .Error = EINVAL };
+  }
+  unsigned long Mask[MAX_CPU / (8 * sizeof(unsigned long))] = {0};
+  Mask[Cpu / (8 * sizeof(unsigned long))] = 1ul << (Cpu % (8 * sizeof(unsigned long)));
+  if (syscall(SYS_sched_setaffinity, 0, sizeof(Mask), Mask) != 0) {
+    return (setup_result) { .Status = SetupFailed, .Error = errno };
+  }
+  return (setup_result) { .Status = SetupDone };
+#else
+  return (setup_result) { .Status = SetupUnsupported };
+#endif
+}
+
+// NOTE(lucas): -ffast-math doesn't make the cpu flush denormals, and decaying signals end up in them all the time
+setup_result FlushDenormals() {
+  if (!G_AudioFlushDenormals) {
+    return (setup_result) { .Status = SetupDisabled };
+  }
+#if USE_SSE
+  _mm_setcsr(_mm_getcsr() | 0x8040); // Flush to zero (bit 15) and denormals are zero (bit 6)
+  return (setup_result) { .Status = SetupDone };
+#elif __aarch64__
+  u64 Fpcr = 0;
+  __asm__ __volatile__ ("mrs %0, fpcr" : "=r"(Fpcr));
+  __asm__ __volatile__ ("msr fpcr, %0" :: "r"(Fpcr | (1 << 24)));
+  return (setup_result) { .Status = SetupDone };
+#else
+  return (setup_result) { .Status = SetupUnsupported };
+#endif
+}
+
+// NOTE(lucas): MCL_FUTURE makes allocations past the memlock limit fail, so we only do it when there is no limit
+i32 AudioThreadLockMemory() {
+  audio_thread_report* Report = &AudioThreadReport;
+  if (!G_AudioLockMemory) {
+    Report->MemoryLock = (setup_result) { .Status = SetupDisabled };
+    return NoError;
+  }
+  struct rlimit Limit;
+  if (getrlimit(RLIMIT_MEMLOCK, &Limit) == 0 && Limit.rlim_cur != RLIM_INFINITY && geteuid() != 0) {
+    Report->MemoryLock = (setup_result) { .Status = SetupFailed, .Error = ENOMEM };
+    return Error;
+  }
+  if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+    Report->MemoryLock = (setup_result) { .Status = SetupFailed, .Error = errno };
+    return Error;
+  }
+  Report->MemoryLock = (setup_result) { .Status = SetupDone };
+  return NoError;
+}
+
+void AudioThreadSetup(u8 RealTime) {
+  audio_thread_report* Report = &AudioThreadReport;
+  if (RealTime) {
+    Report->Priority = SetPriority(G_AudioThreadPriority);
+    Report->Affinity = SetAffinity(G_AudioThreadCpu);
+  }
+  Report->Denormals = FlushDenormals();
+  atomic_store(&Report->Ready, 1);
+}
+
+// NOTE(lucas): The audio thread waits for the workers, so they run at its priority
+i32 AudioThreadSetupWorker(i32 WorkerIndex) {
+  audio_thread_report* Report = &AudioThreadReport;
+  setup_result Results[] = {
+    SetPriority(G_AudioThreadPriority),
+    SetAffinity(G_AudioWorkerCpu >= 0 ? G_AudioWorkerCpu + WorkerIndex : -1),
+    FlushDenormals(),
+  };
+  for (i32 Index = 0; Index < (i32)ArraySize(Results); ++Index) {
+    if (Results[Index].Status == SetupFailed) {
+      atomic_fetch_add(&Report->WorkersFailed, 1);
+      return Error;
+    }
+  }
+  atomic_fetch_add(&Report->WorkersConfigured, 1);
+  return NoError;
+}
+
+void PrintResult(FILE* File, const char* Name, setup_result* Result, const char* Detail, const char* Hint) {
+  fprintf(File, "  %-20s", Name);
+  switch (Result->Status) {
+    case SetupDisabled:
+      fprintf(File, "off\n");
+      break;
+    case SetupDone:
+      fprintf(File, Detail ? "ok (%s)\n" : "ok\n", Detail);
+      break;
+    case SetupFailed:
+      fprintf(File, "failed: %s%s%s\n", strerror(Result->Error), Hint ? ", " : "", Hint ? Hint : "");
+      break;
+    case SetupUnsupported:
+      fprintf(File, "not supported on this platform\n");
+      break;
+  }
+}
+
+void AudioThreadPrintReport(FILE* File) {
+  audio_thread_report* Report = &AudioThreadReport;
+  if (!atomic_load(&Report->Ready)) {
+    fprintf(File, "Audio thread has not started yet\n");
+    return;
+  }
+  char Priority[64];
+  char Affinity[64];
+  char MemoryLimit[96];
+  snprintf(Priority, sizeof(Priority), "SCHED_FIFO %i", G_AudioThreadPriority);
+  snprintf(Affinity, sizeof(Affinity), "core %i", G_AudioThreadCpu);
+  struct rlimit Limit = {0};
+  getrlimit(RLIMIT_MEMLOCK, &Limit);
+  snprintf(MemoryLimit, sizeof(MemoryLimit), "memlock limit is %lu KB and has to be unlimited", (unsigned long)(Limit.rlim_cur / 1024));
+
+  fprintf(File, "Audio thread setup:\n");
+  PrintResult(File, "Real-time priority:", &Report->Priority, Priority, Report->Priority.Error == EPERM ? "raise rtprio for this user (e.g. in /etc/security/limits.conf)" : NULL);
+  PrintResult(File, "CPU affinity:", &Report->Affinity, Affinity, NULL);
+  PrintResult(File, "Flush denormals:", &Report->Denormals, NULL, NULL);
+  PrintResult(File, "Memory lock:", &Report->MemoryLock, NULL, Report->MemoryLock.Error == ENOMEM ? MemoryLimit : NULL);
+  i32 WorkersConfigured = atomic_load(&Report->WorkersConfigured);
+  i32 WorkerCount = WorkersConfigured + atomic_load(&Report->WorkersFailed);
+  if (WorkerCount > 0) {
+    fprintf(File, "  %-20s%i of %i configured\n", "Mixer workers:", WorkersConfigured, WorkerCount);
+  }
+}
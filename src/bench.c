@@ -0,0 +1,247 @@
+// bench.c
+// throughput benchmark of the audio engine, finds out how many buses of every instrument can be processed within the
+// buffer period, driving the engine through the null audio backend
+
+#define BENCH_WARMUP_BUFFERS 8
+#define BENCH_PERCENTILE 0.99 // Fraction of the buffers which have to be done within the buffer period
+#define BENCH_CONFIRM_COUNT 3 // Measurements of a bus count which seems to miss the deadline, the median decides
+
+typedef struct bench_args {
+  char* OutputPath;
+  char* FrameSizes;
+  i32 MaxBuses;
+  f32 Duration;
+} bench_args;
+
+typedef struct bench_result {
+  i32 BusCount;
+  f64 NsPerFrameBus;
+  f64 RealTimeFactor;
+  f32 Load; // Load of the buffer at BENCH_PERCENTILE, relative to the buffer period
+  f32 MaxLoad;
+} bench_result;
+
+static i32 CompareTime(const void* A, const void* B);
+static i32 SetBusCount(mixer* Mixer, i32 Type, i32 BusCount);
+static i32 Measure(bench_args* Args, mixer* Mixer, i32 Type, i32 BusCount, bench_result* Result);
+static i32 MeasureConfirmed(bench_args* Args, mixer* Mixer, i32 Type, i32 BusCount, bench_result* Result);
+static i32 BenchInstrument(bench_args* Args, i32 Type, i32 FramesPerBuffer, FILE* File);
+
+i32 CompareTime(const void* A, const void* B) {
+  i64 TimeA = *(i64*)A;
+  i64 TimeB = *(i64*)B;
+  return (TimeA > TimeB) - (TimeA < TimeB);
+}
+
+// NOTE(lucas): Commands are applied by processing a buffer whenever the command queue is full
+i32 SetBusCount(mixer* Mixer, i32 Type, i32 BusCount) {
+  while (MixerBusCount(Mixer) - 1 != BusCount) {
+    if (SpscQueueSpace(&Mixer->Commands) == 0) {
+      NullAudioRun(1);
+      MixerUpdate(Mixer);
+    }
+    if (MixerBusCount(Mixer) - 1 < BusCount) {
+      if (MixerAddBus(Mixer, 2, NULL, InstrumentCreate(Type), NULL) != NoError) {
+        return Error;
+      }
+    }
+    else {
+      MixerRemoveBus(Mixer, MixerGetBusHandle(Mixer, MixerBusCount(Mixer) - 1));
+    }
+  }
+  NullAudioRun(1);
+  MixerUpdate(Mixer);
+  MixerWaitInstruments(Mixer);
+  u8 Chord[] = {48, 55, 60, 64};
+  for (i32 Index = 0; Index < (i32)ArraySize(Chord); ++Index) {
+    MidiPushEvent((midi_event) { .Message = MIDI_NOTE_ON, .A = Chord[Index], .B = 100 });
+  }
+  return NoError;
+}
+
+// Every buffer is timed on its own, the buffers are processed back to back
+i32 Measure(bench_args* Args, mixer* Mixer, i32 Type, i32 BusCount, bench_result* Result) {
+  audio_engine* Engine = &AudioEngine;
+  if (SetBusCount(Mixer, Type, BusCount) != NoError) {
+    return Error;
+  }
+  i64 Period = (i64)Engine->FramesPerBuffer * 1000000000 / Engine->SampleRate;
+  i32 BufferCount = Max((i32)(Args->Duration * Engine->SampleRate / Engine->FramesPerBuffer), 16);
+  i64* Times = M_Malloc(sizeof(i64) * BufferCount);
+  if (!Times) {
+    return Error;
+  }
+  NullAudioRun(BENCH_WARMUP_BUFFERS);
+  i64 Total = 0;
+  for (i32 BufferIndex = 0; BufferIndex < BufferCount; ++BufferIndex) {
+    i64 Start = DspLoadTime();
+    NullAudioRun(1);
+    Times[BufferIndex] = DspLoadTime() - Start;
+    Total += Times[BufferIndex];
+  }
+  qsort(Times, BufferCount, sizeof(i64), CompareTime);
+  i32 Percentile = Min((i32)(BENCH_PERCENTILE * BufferCount), BufferCount - 1);
+  *Result = (bench_result) {
+    .BusCount = BusCount,
+    .NsPerFrameBus = (f64)Total / ((f64)BufferCount * Engine->FramesPerBuffer * BusCount),
+    .RealTimeFactor = (f64)BufferCount * Period / Max(Total, 1),
+    .Load = (f32)Times[Percentile] / Period,
+    .MaxLoad = (f32)Times[BufferCount - 1] / Period,
+  };
+  M_Free(Times, sizeof(i64) * BufferCount);
+  return NoError;
+}
+
+// NOTE(lucas): A single scheduler hiccup can miss the deadline, so a miss is measured again and the median counts
+i32 MeasureConfirmed(bench_args* Args, mixer* Mixer, i32 Type, i32 BusCount, bench_result* Result) {
+  bench_result Results[BENCH_CONFIRM_COUNT];
+  if (Measure(Args, Mixer, Type, BusCount, &Results[0]) != NoError) {
+    return Error;
+  }
+  if (Results[0].Load <= 1.0f) {
+    *Result = Results[0];
+    return NoError;
+  }
+  for (i32 Index = 1; Index < BENCH_CONFIRM_COUNT; ++Index) {
+    if (Measure(Args, Mixer, Type, BusCount, &Results[Index]) != NoError) {
+      return Error;
+    }
+    // Insertion sort by load
+    for (i32 Sorted = Index; Sorted > 0 && Results[Sorted].Load < Results[Sorted - 1].Load; --Sorted) {
+      bench_result Temp = Results[Sorted];
+      Results[Sorted] = Results[Sorted - 1];
+      Results[Sorted - 1] = Temp;
+    }
+  }
+  *Result = Results[BENCH_CONFIRM_COUNT / 2];
+  return NoError;
+}
+
+// Doubles the bus count until the deadline is missed, then bisects to within a few percent
+i32 BenchInstrument(bench_args* Args, i32 Type, i32 FramesPerBuffer, FILE* File) {
+  audio_engine* Engine = &AudioEngine;
+  mixer* Mixer = &Engine->Mixer;
+  i32 Result = NoError;
+  i32 SampleRate = G_SampleRate;
+
+  MixerInit(Mixer, SampleRate, FramesPerBuffer);
+  if ((Result = AudioEngineStateInit(SampleRate, FramesPerBuffer)) == NoError) {
+    Mixer->Active = 1;
+    bench_result Best = {0};
+    bench_result Probe = {0};
+    i32 Low = 0;  // Most buses that made the deadline
+    i32 High = 0; // Fewest buses that didn't, zero if not found yet
+    for (i32 BusCount = 1; Result == NoError && !High; BusCount = Min(2 * BusCount, Args->MaxBuses)) {
+      if ((Result = MeasureConfirmed(Args, Mixer, Type, BusCount, &Probe)) != NoError) {
+        break;
+      }
+      if (Probe.Load <= 1.0f) {
+        Low = BusCount;
+        Best = Probe;
+      }
+      else {
+        High = BusCount;
+      }
+      if (BusCount == Args->MaxBuses) {
+        break;
+      }
+    }
+    while (Result == NoError && High && High - Low > Max(1, Low / 32)) {
+      i32 BusCount = (Low + High) / 2;
+      if ((Result = MeasureConfirmed(Args, Mixer, Type, BusCount, &Probe)) != NoError) {
+        break;
+      }
+      if (Probe.Load <= 1.0f) {
+        Low = BusCount;
+        Best = Probe;
+      }
+      else {
+        High = BusCount;
+      }
+    }
+    // Not even a single bus made it, report how far off it was
+    if (Result == NoError && Low == 0) {
+      Result = Measure(Args, Mixer, Type, 1, &Best);
+    }
+    if (Result == NoError) {
+      const char* Name = InsHandler.Instruments[Type].Name;
+      fprintf(File, "\"%s\",%i,%i,%i,%i,%i,%.3f,%.3f,%.3f,%.3f\n", Name, SampleRate, FramesPerBuffer, Mixer->Workers.WorkerCount, Low, Low == Args->MaxBuses, Best.NsPerFrameBus, Best.RealTimeFactor, Best.Load, Best.MaxLoad);
+      fflush(File);
+      fprintf(stdout, "%-16s | %6i | %9i%s | %10.2f | %9.2fx | %5.1f%%\n", Name, FramesPerBuffer, Low, Low == Args->MaxBuses ? "+" : " ", Best.NsPerFrameBus, Best.RealTimeFactor, 100 * Best.Load);
+    }
+    Mixer->Active = 0;
+    SetBusCount(Mixer, Type, 0);
+  }
+  AudioEngineTerminate();
+  MixerFree(Mixer);
+  return Result;
+}
+
+i32 BenchEngine(i32 argc, char** argv) {
+  i32 Result = NoError;
+
+  bench_args Args = {
+    .OutputPath = "bench_engine.csv",
+    .FrameSizes = "64,128,256,512,1024",
+    .MaxBuses = 4096,
+    .Duration = 0.25f,
+  };
+
+  parse_arg Arguments[] = {
+    {'o', "output-path", "path to the CSV file to write the results to (default: bench_engine.csv)", ArgString, 1, &Args.OutputPath},
+    {'f', "frames-per-buffer", "comma separated list of buffer sizes to run at (default: 64,128,256,512,1024)", ArgString, 1, &Args.FrameSizes},
+    {'m', "max-buses", "largest number of buses to try (default: 4096)", ArgInt, 1, &Args.MaxBuses},
+    {'t', "time", "seconds of audio to process for every measurement (default: 0.25)", ArgFloat, 1, &Args.Duration},
+  };
+  Result = ParseArgs(Arguments, ArraySize(Arguments), argc, argv);
+  if (Result == Error) {
+    return Result;
+  }
+  else if (Result == HelpStatus) {
+    return NoError;
+  }
+  if (Args.MaxBuses <= 0 || Args.MaxBuses > MAX_AUDIO_BUS - 1 || Args.Duration <= 0) {
+    fprintf(stderr, "Invalid benchmark arguments\n");
+    return Error;
+  }
+  FILE* File = fopen(Args.OutputPath, "w");
+  if (!File) {
+    fprintf(stderr, "Failed to open '%s'\n", Args.OutputPath);
+    return Error;
+  }
+
+  // NOTE(lucas): The engine is driven as fast as possible through the null backend, with a test tone as its input
+  i32 AudioNull = G_AudioNull;
+  i32 AudioInput = G_AudioInput;
+  G_AudioNull = NullAudioFreeRun;
+  G_AudioInput = 1;
+  AudioThreadSetup(0); // This thread is the audio thread from here on
+  InstrumentHandlerInit();
+  MidiInitHandle(MIDI_HANDLE_NULL);
+  MidiInit();
+
+  fprintf(File, "instrument,sample_rate,frames_per_buffer,workers,max_buses,limit_reached,ns_per_frame_bus,realtime_factor,load_p99,load_max\n");
+  fprintf(stdout, "%-16s | %6s | %10s | %10s | %10s | %6s\n", "INSTRUMENT", "FRAMES", "MAX BUSES", "NS/FRAME", "REAL TIME", "LOAD");
+  for (i32 Type = 0; Result == NoError && Type < (i32)InsHandler.InstrumentCount; ++Type) {
+    char* FrameSize = Args.FrameSizes;
+    while (Result == NoError && *FrameSize) {
+      char* End = NULL;
+      i32 FramesPerBuffer = (i32)strtol(FrameSize, &End, 10);
+      if (End == FrameSize || FramesPerBuffer <= 0) {
+        fprintf(stderr, "Invalid buffer size in '%s'\n", Args.FrameSizes);
+        Result = Error;
+        break;
+      }
+      Result = BenchInstrument(&Args, Type, FramesPerBuffer, File);
+      FrameSize = *End == ',' ? End + 1 : End;
+    }
+  }
+  fprintf(stdout, "Wrote results to '%s'\n", Args.OutputPath);
+
+  MidiFree();
+  InstrumentHandlerFree();
+  G_AudioNull = AudioNull;
+  G_AudioInput = AudioInput;
+  fclose(File);
+  return Result;
+}
@@ -4,6 +4,7 @@ config_parser_state Parser;
 
 typedef enum config_token_type {
   TOK_IDENT,
+  TOK_STRING,
   TOK_INT,
   TOK_FLOAT,
   TOK_NEWLINE,
@@ -26,8 +27,10 @@ static config_token CurrentToken = { .At = NULL, .Length = 0, .Type = TOK_EOF, }
 
 static u8 IsNumber(char Ch);
 static u8 IsAlpha(char Ch);
+static u8 IsPathChar(char Ch);
 static config_token ParseNumber(config_parser_state* P);
 static config_token ParseIdent(config_parser_state* P);
+static config_token ParseString(config_parser_state* P);
 static config_token NextToken(config_parser_state* P);
 static void Next(config_parser_state* P);
 static i32 Parse(config_parser_state* P);
@@ -44,6 +47,11 @@ u8 IsAlpha(char Ch) {
   return (Ch >= 'a' && Ch <= 'z') || (Ch >= 'A' && Ch <= 'Z');
 }
 
+// Characters that unquoted identifiers (and paths) may contain after their first character
+u8 IsPathChar(char Ch) {
+  return IsAlpha(Ch) || IsNumber(Ch) || Ch == '/' || Ch == '.' || Ch == '-' || Ch == '_' || Ch == '~';
+}
+
 config_token ParseNumber(config_parser_state* P) {
   u8 ShouldParseNumber = 1;
   u8 Dot = 0;
@@ -92,7 +100,7 @@ config_token ParseNumber(config_parser_state* P) {
 }
 
 config_token ParseIdent(config_parser_state* P) {
-  while (IsAlpha(*P->Index) || *P->Index == '/' || *P->Index == '.' || *P->Index == '-' || *P->Index == '_') {
+  while (IsPathChar(*P->Index)) {
     P->Index++;
   }
   CurrentToken.Length = P->Index - CurrentToken.At;
@@ -100,6 +108,20 @@ config_token ParseIdent(config_parser_state* P) {
   return CurrentToken;
 }
 
+// NOTE(lucas): Strings are quoted so that empty strings, and strings with spaces, survive a round trip
+config_token ParseString(config_parser_state* P) {
+  CurrentToken.At = P->Index;
+  while (*P->Index != '"' && *P->Index != '\n' && *P->Index != '\r' && *P->Index != '\0') {
+    P->Index++;
+  }
+  CurrentToken.Length = P->Index - CurrentToken.At;
+  CurrentToken.Type = TOK_STRING;
+  if (*P->Index == '"') {
+    P->Index++;
+  }
+  return CurrentToken;
+}
+
 config_token NextToken(config_parser_state* P) {
   for (;;) {
     char Ch = *P->Index;
@@ -124,9 +146,12 @@ config_token NextToken(config_parser_state* P) {
         if (IsNumber(Ch) || Ch == '-') {
           return ParseNumber(P);
         }
-        else if (IsAlpha(Ch) || Ch == '_') {
+        else if (IsAlpha(Ch) || Ch == '_' || Ch == '/' || Ch == '.' || Ch == '~') {
           return ParseIdent(P);
         }
+        else if (Ch == '"') {
+          return ParseString(P);
+        }
         else {
           CurrentToken.Type = TOK_EOF;
           return CurrentToken;
@@ -154,6 +179,10 @@ i32 Parse(config_parser_state* P) {
         if (Variable) {
           for (u32 FieldIndex = 0; FieldIndex < Variable->NumFields; ++FieldIndex) {
             Token = NextToken(P);
+            // NOTE(lucas): Missing values leave the remaining fields untouched rather than reading into the next line
+            if (Token.Type == TOK_NEWLINE || Token.Type == TOK_EOF) {
+              break;
+            }
             switch (Variable->Type) {
               case TypeInt32: {
                 *((i32*)Variable->Data + FieldIndex) = (i32)Token.Number;
@@ -164,15 +193,20 @@ i32 Parse(config_parser_state* P) {
                 break;
               }
               case TypeString: {
+                // NOTE(lucas): All string variables are MAX_PATH_SIZE in size
                 char* String = (char*)(char**)(Variable->Data + FieldIndex);
-                strncpy(String, Token.At, Token.Length);
-                String[Token.Length] = '\0';
+                u32 Length = Min(Token.Length, MAX_PATH_SIZE - 1);
+                strncpy(String, Token.At, Length);
+                String[Length] = '\0';
                 break;
               }
               default:
                 break;
             }
           }
+          if (Token.Type == TOK_EOF) {
+            ShouldParse = 0;
+          }
         }
         break;
       }
@@ -219,12 +253,14 @@ i32 ConfigParserInit() {
 
   DefineVariable("sample_rate", &G_SampleRate, 1, TypeInt32);
   DefineVariable("frames_per_buffer", &G_FramesPerBuffer, 1, TypeInt32);
+  DefineVariable("process_quantum", &G_ProcessQuantum, 1, TypeInt32);
 
   DefineVariable("window_width", &G_WindowWidth, 1, TypeInt32);
   DefineVariable("window_height", &G_WindowHeight, 1, TypeInt32);
   DefineVariable("fullscreen", &G_FullScreen, 1, TypeInt32);
   DefineVariable("vsync", &G_Vsync, 1, TypeInt32);
   DefineVariable("audio_input", &G_AudioInput, 1, TypeInt32);
+  DefineVariable("audio_null", &G_AudioNull, 1, TypeInt32);
 
   DefineVariable("ui_color_background", &UIColorBackground, 3, TypeFloat32);
   DefineVariable("ui_color_accept", &UIColorAccept, 3, TypeFloat32);
@@ -256,6 +292,27 @@ i32 ConfigParserInit() {
 
   DefineVariable("stream_buffer_size_multiple", &G_StreamBufferSizeMultiple, 1, TypeInt32);
   DefineVariable("stream_buffer_denom", &G_StreamBufferDenom, 1, TypeInt32);
+  DefineVariable("record_bit_depth", &G_RecordBitDepth, 1, TypeInt32);
+  DefineVariable("record_preallocate", &G_RecordPreallocate, 1, TypeInt32);
+  DefineVariable("record_multitrack", &G_RecordMultitrack, 1, TypeInt32);
+
+  DefineVariable("audio_thread_priority", &G_AudioThreadPriority, 1, TypeInt32);
+  DefineVariable("audio_thread_cpu", &G_AudioThreadCpu, 1, TypeInt32);
+  DefineVariable("audio_worker_cpu", &G_AudioWorkerCpu, 1, TypeInt32);
+  DefineVariable("audio_flush_denormals", &G_AudioFlushDenormals, 1, TypeInt32);
+  DefineVariable("audio_lock_memory", &G_AudioLockMemory, 1, TypeInt32);
+
+  DefineVariable("mixer_worker_count", &G_MixerWorkerCount, 1, TypeInt32);
+  DefineVariable("mixer_parallel_min_buses", &G_MixerParallelMinBuses, 1, TypeInt32);
+  DefineVariable("mixer_profile", &G_MixerProfile, 1, TypeInt32);
+  DefineVariable("mixer_scratch_size", &G_MixerScratchSize, 1, TypeInt32);
+
+  DefineVariable("reverb_impulse", &G_ReverbImpulse, 1, TypeString);
+  DefineVariable("reverb_tail_thread", &G_ReverbTailThread, 1, TypeInt32);
+
+  DefineVariable("eq_gains", &G_EqGains, 8, TypeFloat32);
+
+  DefineVariable("rt_debug_trap", &G_RtDebugTrap, 1, TypeInt32);
 
   return Result;
 }
@@ -310,7 +367,7 @@ i32 ConfigWrite(const char* Path) {
             break;
           }
           case TypeString: {
-            fprintf(File, " %s", (char*)(char**)(Variable->Data + FieldIndex));
+            fprintf(File, " \"%s\"", (char*)(char**)(Variable->Data + FieldIndex));
             break;
           }
           default:
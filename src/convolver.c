@@ -0,0 +1,315 @@
+// convolver.c
+// partitioned fft convolution, for long impulse responses (reverbs) as well as short ones (cabinets)
+
+typedef struct tail_thread {
+  pthread_t Thread;
+  pthread_mutex_t Control; // Held while a convolver is attached or detached, which starts and stops the thread
+  pthread_mutex_t Lock; // Guards the list against the tail thread
+  convolver* List;
+  i32 Count;
+  wait_word Signal; // Bumped by the audio thread when a tail block has been handed over
+  _Atomic u8 ShouldExit;
+} tail_thread;
+
+static tail_thread TailState = { .Control = PTHREAD_MUTEX_INITIALIZER, .Lock = PTHREAD_MUTEX_INITIALIZER, };
+
+static i32 StageInit(convolver_stage* Stage, i32 BlockSize, const f32* Ir, i32 IrLength);
+static void StageStep(convolver_stage* Stage, const f32* Input, f32* Output);
+static void StageFree(convolver_stage* Stage);
+static void TailRun(convolver* Convolver);
+static void TailPost(convolver* Convolver);
+static void TailFetch(convolver* Convolver, u32 Block);
+static void TailWake(void);
+static void* TailThread(void* Data);
+static i32 TailAttach(convolver* Convolver);
+static void TailDetach(convolver* Convolver);
+static void ConvolverStep(convolver* Convolver);
+
+i32 StageInit(convolver_stage* Stage, i32 BlockSize, const f32* Ir, i32 IrLength) {
+  i32 Size = 2 * BlockSize;
+  Stage->BlockSize = BlockSize;
+  Stage->BinCount = BlockSize + 1;
+  Stage->PartitionCount = (IrLength + BlockSize - 1) / BlockSize;
+  Stage->Position = 0;
+  if (Stage->PartitionCount == 0) {
+    return NoError;
+  }
+  i32 SpectrumSize = Stage->PartitionCount * Stage->BinCount;
+  if (FftRealPlanInit(&Stage->Plan, Size) != NoError) {
+    return Error;
+  }
+  Stage->IrRe = FftAlloc(SpectrumSize);
+  Stage->IrIm = FftAlloc(SpectrumSize);
+  Stage->InRe = FftAlloc(SpectrumSize);
+  Stage->InIm = FftAlloc(SpectrumSize);
+  Stage->History = FftAlloc(Size);
+  Stage->Re = FftAlloc(Stage->BinCount);
+  Stage->Im = FftAlloc(Stage->BinCount);
+  Stage->Time = FftAlloc(Size);
+  if (!Stage->IrRe || !Stage->IrIm || !Stage->InRe || !Stage->InIm || !Stage->History || !Stage->Re || !Stage->Im || !Stage->Time) {
+    return Error;
+  }
+  f32 Scale = 1.0f / Size;
+  for (i32 Partition = 0; Partition < Stage->PartitionCount; ++Partition) {
+    i32 Offset = Partition * BlockSize;
+    i32 Count = Min(BlockSize, IrLength - Offset);
+    memset(Stage->Time, 0, sizeof(f32) * Size);
+    for (i32 Index = 0; Index < Count; ++Index) {
+      Stage->Time[Index] = Scale * Ir[Offset + Index];
+    }
+    FftRealForward(&Stage->Plan, Stage->Time, &Stage->IrRe[Partition * Stage->BinCount], &Stage->IrIm[Partition * Stage->BinCount]);
+  }
+  return NoError;
+}
+
+// NOTE(lucas): Partition N pairs up with the input of N blocks ago, the second half of the inverse is the output
+void StageStep(convolver_stage* Stage, const f32* Input, f32* Output) {
+  i32 BlockSize = Stage->BlockSize;
+  i32 BinCount = Stage->BinCount;
+  memcpy(Stage->History, &Stage->History[BlockSize], sizeof(f32) * BlockSize);
+  memcpy(&Stage->History[BlockSize], Input, sizeof(f32) * BlockSize);
+  FftRealForward(&Stage->Plan, Stage->History, &Stage->InRe[Stage->Position * BinCount], &Stage->InIm[Stage->Position * BinCount]);
+
+  memset(Stage->Re, 0, sizeof(f32) * BinCount);
+  memset(Stage->Im, 0, sizeof(f32) * BinCount);
+  for (i32 Partition = 0; Partition < Stage->PartitionCount; ++Partition) {
+    i32 Slot = Stage->Position - Partition;
+    if (Slot < 0) {
+      Slot += Stage->PartitionCount;
+    }
+    FftMultiplyAccumulate(Stage->Re, Stage->Im, &Stage->InRe[Slot * BinCount], &Stage->InIm[Slot * BinCount], &Stage->IrRe[Partition * BinCount], &Stage->IrIm[Partition * BinCount], BinCount);
+  }
+  FftRealInverse(&Stage->Plan, Stage->Re, Stage->Im, Stage->Time);
+  memcpy(Output, &Stage->Time[BlockSize], sizeof(f32) * BlockSize);
+  Stage->Position = (Stage->Position + 1) % Stage->PartitionCount;
+}
+
+void StageFree(convolver_stage* Stage) {
+  i32 SpectrumSize = Stage->PartitionCount * Stage->BinCount;
+  i32 Size = 2 * Stage->BlockSize;
+  FftFree(Stage->IrRe, SpectrumSize);
+  FftFree(Stage->IrIm, SpectrumSize);
+  FftFree(Stage->InRe, SpectrumSize);
+  FftFree(Stage->InIm, SpectrumSize);
+  FftFree(Stage->History, Size);
+  FftFree(Stage->Re, Stage->BinCount);
+  FftFree(Stage->Im, Stage->BinCount);
+  FftFree(Stage->Time, Size);
+  FftRealPlanFree(&Stage->Plan);
+  memset(Stage, 0, sizeof(convolver_stage));
+}
+
+// NOTE(lucas): Dropped blocks go into the delay line as silence, so that later blocks stay lined up
+void TailRun(convolver* Convolver) {
+  u32 Done = atomic_load_explicit(&Convolver->Done, memory_order_relaxed);
+  u32 Written = atomic_load_explicit(&Convolver->Written, memory_order_acquire);
+  for (; Done != Written; ++Done) {
+    i32 Slot = Done % CONVOLVER_TAIL_QUEUE;
+    u32 Block = Convolver->TailInBlock[Slot];
+    while (Convolver->ThreadBlock != Block) {
+      StageStep(&Convolver->Tail, Convolver->TailZero, Convolver->TailOut[Slot]);
+      ++Convolver->ThreadBlock;
+    }
+    StageStep(&Convolver->Tail, Convolver->TailIn[Slot], Convolver->TailOut[Slot]);
+    Convolver->TailOutBlock[Slot] = Block;
+    ++Convolver->ThreadBlock;
+    atomic_store_explicit(&Convolver->Done, Done + 1, memory_order_release);
+  }
+}
+
+void TailPost(convolver* Convolver) {
+  u32 Written = atomic_load_explicit(&Convolver->Written, memory_order_relaxed);
+  u32 Done = atomic_load_explicit(&Convolver->Done, memory_order_acquire);
+  if (Written - Done < CONVOLVER_TAIL_QUEUE) {
+    i32 Slot = Written % CONVOLVER_TAIL_QUEUE;
+    memcpy(Convolver->TailIn[Slot], Convolver->TailFill, sizeof(f32) * CONVOLVER_TAIL_SIZE);
+    Convolver->TailInBlock[Slot] = Convolver->TailBlock;
+    atomic_store(&Convolver->Written, Written + 1);
+    if (Convolver->Threaded) {
+      TailWake();
+    }
+    else {
+      TailRun(Convolver);
+    }
+  }
+  else {
+    atomic_fetch_add_explicit(&Convolver->Misses, 1, memory_order_relaxed);
+  }
+  ++Convolver->TailBlock;
+}
+
+// NOTE(lucas): The oldest slot is left alone, since the tail thread may be writing into it
+void TailFetch(convolver* Convolver, u32 Block) {
+  u32 Done = atomic_load_explicit(&Convolver->Done, memory_order_acquire);
+  for (u32 Count = 1; Count < CONVOLVER_TAIL_QUEUE && Count <= Done; ++Count) {
+    i32 Slot = (Done - Count) % CONVOLVER_TAIL_QUEUE;
+    if (Convolver->TailOutBlock[Slot] == Block) {
+      memcpy(Convolver->TailPlay, Convolver->TailOut[Slot], sizeof(f32) * CONVOLVER_TAIL_SIZE);
+      return;
+    }
+  }
+  memset(Convolver->TailPlay, 0, sizeof(f32) * CONVOLVER_TAIL_SIZE);
+  atomic_fetch_add_explicit(&Convolver->Misses, 1, memory_order_relaxed);
+}
+
+void TailWake(void) {
+  atomic_fetch_add(&TailState.Signal.Value, 1);
+  WaitWordWake(&TailState.Signal, 1);
+}
+
+void* TailThread(void* Data) {
+  (void)Data;
+  while (!atomic_load(&TailState.ShouldExit)) {
+    u32 Signal = atomic_load(&TailState.Signal.Value);
+    pthread_mutex_lock(&TailState.Lock);
+    for (convolver* Convolver = TailState.List; Convolver; Convolver = Convolver->Next) {
+      TailRun(Convolver);
+    }
+    pthread_mutex_unlock(&TailState.Lock);
+    WaitWordSleep(&TailState.Signal, Signal, 0);
+  }
+  return NULL;
+}
+
+// NOTE(lucas): The thread is started with the first threaded convolver, and stopped with the last one
+i32 TailAttach(convolver* Convolver) {
+  i32 Result = NoError;
+  pthread_mutex_lock(&TailState.Control);
+  if (TailState.Count == 0) {
+    WaitWordInit(&TailState.Signal, 0);
+    atomic_init(&TailState.ShouldExit, 0);
+    if (pthread_create(&TailState.Thread, NULL, TailThread, NULL) != 0) {
+      WaitWordFree(&TailState.Signal);
+      Result = Error;
+    }
+  }
+  if (Result == NoError) {
+    pthread_mutex_lock(&TailState.Lock);
+    Convolver->Next = TailState.List;
+    TailState.List = Convolver;
+    pthread_mutex_unlock(&TailState.Lock);
+    ++TailState.Count;
+  }
+  pthread_mutex_unlock(&TailState.Control);
+  return Result;
+}
+
+void TailDetach(convolver* Convolver) {
+  pthread_mutex_lock(&TailState.Control);
+  pthread_mutex_lock(&TailState.Lock);
+  for (convolver** Iter = &TailState.List; *Iter; Iter = &(*Iter)->Next) {
+    if (*Iter == Convolver) {
+      *Iter = Convolver->Next;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&TailState.Lock);
+  if (--TailState.Count == 0) {
+    atomic_store(&TailState.ShouldExit, 1);
+    TailWake();
+    pthread_join(TailState.Thread, NULL);
+    WaitWordFree(&TailState.Signal);
+  }
+  pthread_mutex_unlock(&TailState.Control);
+}
+
+// NOTE(lucas): The tail block posted now is due two tail blocks later, once the head has caught up with it
+void ConvolverStep(convolver* Convolver) {
+  StageStep(&Convolver->Head, Convolver->In, Convolver->Out);
+  if (Convolver->Tail.PartitionCount == 0) {
+    ++Convolver->Step;
+    return;
+  }
+  memcpy(&Convolver->TailFill[Convolver->TailFillCount], Convolver->In, sizeof(f32) * CONVOLVER_HEAD_SIZE);
+  Convolver->TailFillCount += CONVOLVER_HEAD_SIZE;
+  if (Convolver->TailFillCount == CONVOLVER_TAIL_SIZE) {
+    TailPost(Convolver);
+    Convolver->TailFillCount = 0;
+  }
+  i64 Frame = Convolver->Step * CONVOLVER_HEAD_SIZE;
+  i32 Offset = Frame % CONVOLVER_TAIL_SIZE;
+  if (Offset == 0) {
+    i64 Block = Frame / CONVOLVER_TAIL_SIZE - CONVOLVER_TAIL_OFFSET / CONVOLVER_TAIL_SIZE;
+    if (Block >= 0) {
+      TailFetch(Convolver, (u32)Block);
+    }
+  }
+  for (i32 Index = 0; Index < CONVOLVER_HEAD_SIZE; ++Index) {
+    Convolver->Out[Index] += Convolver->TailPlay[Offset + Index];
+  }
+  ++Convolver->Step;
+}
+
+i32 ConvolverInit(convolver* Convolver, const f32* Ir, i32 IrLength, u8 Threaded) {
+  memset(Convolver, 0, sizeof(convolver));
+  i32 HeadLength = Min(IrLength, CONVOLVER_TAIL_OFFSET);
+  i32 TailLength = Max(IrLength - CONVOLVER_TAIL_OFFSET, 0);
+  if (IrLength <= 0) {
+    return Error;
+  }
+  if (StageInit(&Convolver->Head, CONVOLVER_HEAD_SIZE, Ir, HeadLength) != NoError) {
+    ConvolverFree(Convolver);
+    return Error;
+  }
+  if (TailLength == 0) {
+    return NoError;
+  }
+  if (StageInit(&Convolver->Tail, CONVOLVER_TAIL_SIZE, &Ir[CONVOLVER_TAIL_OFFSET], TailLength) != NoError) {
+    ConvolverFree(Convolver);
+    return Error;
+  }
+  u8 Allocated = (Convolver->TailFill = FftAlloc(CONVOLVER_TAIL_SIZE)) && (Convolver->TailPlay = FftAlloc(CONVOLVER_TAIL_SIZE)) && (Convolver->TailZero = FftAlloc(CONVOLVER_TAIL_SIZE));
+  for (i32 Slot = 0; Slot < CONVOLVER_TAIL_QUEUE && Allocated; ++Slot) {
+    Allocated = (Convolver->TailIn[Slot] = FftAlloc(CONVOLVER_TAIL_SIZE)) && (Convolver->TailOut[Slot] = FftAlloc(CONVOLVER_TAIL_SIZE));
+    Convolver->TailOutBlock[Slot] = UINT32_MAX;
+  }
+  if (!Allocated) {
+    ConvolverFree(Convolver);
+    return Error;
+  }
+  atomic_init(&Convolver->Written, 0);
+  atomic_init(&Convolver->Done, 0);
+  atomic_init(&Convolver->Misses, 0);
+  if (Threaded) {
+    Convolver->Threaded = TailAttach(Convolver) == NoError;
+    if (!Convolver->Threaded) {
+      fprintf(stderr, "Failed to create convolver thread, processing the tail on the audio thread instead\n");
+    }
+  }
+  return NoError;
+}
+
+void ConvolverProcess(convolver* Convolver, const f32* In, f32* Out, i32 FrameCount) {
+  for (i32 Offset = 0; Offset < FrameCount;) {
+    i32 Count = Min(FrameCount - Offset, CONVOLVER_HEAD_SIZE - Convolver->FifoIndex);
+    memcpy(&Convolver->In[Convolver->FifoIndex], &In[Offset], sizeof(f32) * Count);
+    memcpy(&Out[Offset], &Convolver->Out[Convolver->FifoIndex], sizeof(f32) * Count);
+    Convolver->FifoIndex += Count;
+    Offset += Count;
+    if (Convolver->FifoIndex == CONVOLVER_HEAD_SIZE) {
+      ConvolverStep(Convolver);
+      Convolver->FifoIndex = 0;
+    }
+  }
+}
+
+u32 ConvolverMisses(convolver* Convolver) {
+  return atomic_load_explicit(&Convolver->Misses, memory_order_relaxed);
+}
+
+void ConvolverFree(convolver* Convolver) {
+  if (Convolver->Threaded) {
+    TailDetach(Convolver);
+    Convolver->Threaded = 0;
+  }
+  StageFree(&Convolver->Head);
+  StageFree(&Convolver->Tail);
+  FftFree(Convolver->TailFill, CONVOLVER_TAIL_SIZE);
+  FftFree(Convolver->TailPlay, CONVOLVER_TAIL_SIZE);
+  FftFree(Convolver->TailZero, CONVOLVER_TAIL_SIZE);
+  for (i32 Slot = 0; Slot < CONVOLVER_TAIL_QUEUE; ++Slot) {
+    FftFree(Convolver->TailIn[Slot], CONVOLVER_TAIL_SIZE);
+    FftFree(Convolver->TailOut[Slot], CONVOLVER_TAIL_SIZE);
+  }
+  memset(Convolver, 0, sizeof(convolver));
+}
@@ -0,0 +1,125 @@
+// dsp_load.c
+// measures how much of the buffer period the audio callback uses, and keeps count of xruns
+
+static void PublishWindow(dsp_load* Load);
+
+void PublishWindow(dsp_load* Load) {
+  atomic_fetch_add_explicit(&Load->Sequence, 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  atomic_store_explicit(&Load->Min, Load->WindowMin, memory_order_relaxed);
+  atomic_store_explicit(&Load->Avg, (f32)(Load->WindowSum / Load->WindowCount), memory_order_relaxed);
+  atomic_store_explicit(&Load->Max, Load->WindowMax, memory_order_relaxed);
+  if (Load->WindowMax > atomic_load_explicit(&Load->Peak, memory_order_relaxed)) {
+    atomic_store_explicit(&Load->Peak, Load->WindowMax, memory_order_relaxed);
+  }
+  atomic_fetch_add_explicit(&Load->Sequence, 1, memory_order_release);
+
+  Load->WindowMin = INFINITY;
+  Load->WindowMax = 0;
+  Load->WindowSum = 0;
+  Load->WindowCount = 0;
+}
+
+i64 DspLoadTime() {
+  struct timespec Time;
+  clock_gettime(CLOCK_MONOTONIC, &Time);
+  return (i64)Time.tv_sec * 1000000000 + Time.tv_nsec;
+}
+
+void DspLoadInit(dsp_load* Load, i32 SampleRate, i32 FramesPerBuffer) {
+  atomic_init(&Load->Sequence, 0);
+  atomic_init(&Load->Min, 0);
+  atomic_init(&Load->Avg, 0);
+  atomic_init(&Load->Max, 0);
+  atomic_init(&Load->Peak, 0);
+  for (i32 Bin = 0; Bin < DSP_LOAD_BIN_COUNT; ++Bin) {
+    atomic_init(&Load->Histogram[Bin], 0);
+  }
+  atomic_init(&Load->Callbacks, 0);
+  atomic_init(&Load->Underflows, 0);
+  atomic_init(&Load->Overflows, 0);
+  atomic_init(&Load->LateCount, 0);
+  for (i32 Index = 0; Index < MAX_LATE_CALLBACK; ++Index) {
+    atomic_init(&Load->Late[Index].Time, 0);
+    atomic_init(&Load->Late[Index].Load, 0);
+  }
+  Load->StartTime = DspLoadTime();
+  Load->Period = (i64)FramesPerBuffer * 1000000000 / SampleRate;
+  Load->WindowMin = INFINITY;
+  Load->WindowMax = 0;
+  Load->WindowSum = 0;
+  Load->WindowCount = 0;
+  Load->WindowSize = Max(1, (i32)(DSP_LOAD_WINDOW * SampleRate / FramesPerBuffer));
+}
+
+void DspLoadUpdate(dsp_load* Load, i64 Start) {
+  i64 End = DspLoadTime();
+  f32 Value = (f32)(End - Start) / Load->Period;
+
+  i32 Bin = Min((i32)(Value * DSP_LOAD_BIN_COUNT), DSP_LOAD_BIN_COUNT - 1);
+  atomic_fetch_add_explicit(&Load->Histogram[Bin], 1, memory_order_relaxed);
+  atomic_fetch_add_explicit(&Load->Callbacks, 1, memory_order_relaxed);
+  if (Value > 1.0f) {
+    u32 LateIndex = atomic_load_explicit(&Load->LateCount, memory_order_relaxed);
+    late_callback* Late = &Load->Late[LateIndex % MAX_LATE_CALLBACK];
+    atomic_store_explicit(&Late->Time, Start - Load->StartTime, memory_order_relaxed);
+    atomic_store_explicit(&Late->Load, Value, memory_order_relaxed);
+    atomic_store_explicit(&Load->LateCount, LateIndex + 1, memory_order_release);
+  }
+
+  Load->WindowMin = Min(Load->WindowMin, Value);
+  Load->WindowMax = Max(Load->WindowMax, Value);
+  Load->WindowSum += Value;
+  if (++Load->WindowCount >= Load->WindowSize) {
+    PublishWindow(Load);
+  }
+}
+
+void DspLoadXrun(dsp_load* Load, u32 Flags) {
+  if (Flags & (XrunInputUnderflow | XrunOutputUnderflow)) {
+    atomic_fetch_add_explicit(&Load->Underflows, 1, memory_order_relaxed);
+  }
+  if (Flags & (XrunInputOverflow | XrunOutputOverflow)) {
+    atomic_fetch_add_explicit(&Load->Overflows, 1, memory_order_relaxed);
+  }
+}
+
+void DspLoadRead(dsp_load* Load, dsp_load_stats* Stats) {
+  u32 Sequence = 0;
+  do {
+    Sequence = atomic_load_explicit(&Load->Sequence, memory_order_acquire);
+    Stats->Min = atomic_load_explicit(&Load->Min, memory_order_relaxed);
+    Stats->Avg = atomic_load_explicit(&Load->Avg, memory_order_relaxed);
+    Stats->Max = atomic_load_explicit(&Load->Max, memory_order_relaxed);
+    Stats->Peak = atomic_load_explicit(&Load->Peak, memory_order_relaxed);
+    atomic_thread_fence(memory_order_acquire);
+  } while ((Sequence & 1) || Sequence != atomic_load_explicit(&Load->Sequence, memory_order_relaxed));
+}
+
+void DspLoadPrint(dsp_load* Load, FILE* File) {
+  dsp_load_stats Stats;
+  DspLoadRead(Load, &Stats);
+  u32 Callbacks = atomic_load(&Load->Callbacks);
+  fprintf(File, "DSP load (%% of a %g ms buffer period, over %u callbacks):\n", Load->Period / 1000000.0, Callbacks);
+  fprintf(File, "  last %gs: min %.1f%%, avg %.1f%%, max %.1f%%, peak %.1f%%\n", DSP_LOAD_WINDOW, 100 * Stats.Min, 100 * Stats.Avg, 100 * Stats.Max, 100 * Stats.Peak);
+  for (i32 Bin = 0; Bin < DSP_LOAD_BIN_COUNT; ++Bin) {
+    u32 Count = atomic_load_explicit(&Load->Histogram[Bin], memory_order_relaxed);
+    if (Count == 0) {
+      continue;
+    }
+    i32 From = Bin * 100 / DSP_LOAD_BIN_COUNT;
+    i32 To = (Bin + 1) * 100 / DSP_LOAD_BIN_COUNT;
+    if (Bin == DSP_LOAD_BIN_COUNT - 1) {
+      fprintf(File, "  %3i%% -      : %u\n", From, Count);
+    }
+    else {
+      fprintf(File, "  %3i%% - %3i%%: %u\n", From, To, Count);
+    }
+  }
+  u32 LateCount = atomic_load_explicit(&Load->LateCount, memory_order_acquire);
+  fprintf(File, "Xruns: %u underflow(s), %u overflow(s), %u late callback(s)\n", atomic_load(&Load->Underflows), atomic_load(&Load->Overflows), LateCount);
+  for (u32 Index = LateCount > MAX_LATE_CALLBACK ? LateCount - MAX_LATE_CALLBACK : 0; Index < LateCount; ++Index) {
+    late_callback* Late = &Load->Late[Index % MAX_LATE_CALLBACK];
+    fprintf(File, "  late at %.3f s (%.1f%%)\n", atomic_load_explicit(&Late->Time, memory_order_relaxed) / 1000000000.0, 100 * atomic_load_explicit(&Late->Load, memory_order_relaxed));
+  }
+}
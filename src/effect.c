@@ -1,17 +1,60 @@
 // effect.c
 
 #define EFFECT_BUFFER_SIZE (1024 * 56)
-static f32 EffectBuffer[EFFECT_BUFFER_SIZE] = {0};
-static i32 EffectIndex = 0;
-static i32 CurrentEffectIndex = 0;
 
-void StubEffect(f32* Buffer, i32 ChannelCount, i32 FramesPerBuffer, f32 Mix, f32 Amount) {
-  (void)Buffer; (void)ChannelCount; (void)FramesPerBuffer; (void)Mix; (void)Amount;
-}
+typedef struct weird_state {
+  i32 Index;
+  f32 Buffer[EFFECT_BUFFER_SIZE];
+} weird_state;
+
+#define REVERB_CHUNK_SIZE 256
+#define REVERB_MAX_SECONDS 30
+
+typedef struct reverb_state {
+  convolver Convolver;
+} reverb_state;
+
+#define EQ_EFFECT_CHUNK_SIZE 256
+
+typedef struct eq_state {
+  eq_bank Eq;
+} eq_state;
+
+// Gains come from the eq_gains variable
+static const eq_band EqEffectBands[EQ_BAND_COUNT] = {
+  {EQ_LOW_SHELF, 80.0f, 0, 0.7f},
+  {EQ_BELL, 160.0f, 0, 1.0f},
+  {EQ_BELL, 350.0f, 0, 1.0f},
+  {EQ_BELL, 750.0f, 0, 1.0f},
+  {EQ_BELL, 1600.0f, 0, 1.0f},
+  {EQ_BELL, 3500.0f, 0, 1.0f},
+  {EQ_BELL, 7000.0f, 0, 1.0f},
+  {EQ_HIGH_SHELF, 12000.0f, 0, 0.7f},
+};
+
+static void Distortion(effect* Effect, f32* Buffer, i32 ChannelCount, i32 FramesPerBuffer);
+static void WeirdEffect(effect* Effect, f32* Buffer, i32 ChannelCount, i32 FramesPerBuffer);
+static void WeirdEffect2(effect* Effect, f32* Buffer, i32 ChannelCount, i32 FramesPerBuffer);
+static i32 ReverbImpulse(f32** Ir, i32* IrLength, i32 Channel, f32 Seconds);
+static i32 ReverbInit(effect* Effect, i32 Channel);
+static void Reverb(effect* Effect, f32* Buffer, i32 ChannelCount, i32 FramesPerBuffer);
+static void ReverbDestroy(effect* Effect);
+static i32 EqEffectInit(effect* Effect, i32 Channel);
+static void EqEffect(effect* Effect, f32* Buffer, i32 ChannelCount, i32 FramesPerBuffer);
 
-void Distortion(f32* Buffer, i32 ChannelCount, i32 FramesPerBuffer, f32 Mix, f32 Amount) {
-  f32 Dry = 1 - Mix;
+const effect_def EffectDefs[MAX_EFFECT_TYPE] = {
+  {"none", 0, NULL, 0, 0, NULL, NULL},
+  {"distortion", 0, Distortion, 0.25f, 120.0f, NULL, NULL},
+  {"weird", sizeof(weird_state), WeirdEffect, 0.25f, 1000.0f, NULL, NULL},
+  {"weird 2", sizeof(weird_state), WeirdEffect2, 0.02f, 50.0f, NULL, NULL},
+  {"reverb", sizeof(reverb_state), Reverb, 0.25f, 3.0f, ReverbInit, ReverbDestroy}, // Amount is the length of the impulse response in seconds
+  {"eq", sizeof(eq_state), EqEffect, 1.0f, 1.0f, EqEffectInit, NULL},  // Amount scales the gains of the bands
+};
+
+void Distortion(effect* Effect, f32* Buffer, i32 ChannelCount, i32 FramesPerBuffer) {
+  f32 Dry = 1 - Effect->Mix;
   f32 Wet = 1 - Dry;
+  f32 Amount = Effect->Amount;
   f32* Iter = Buffer;
 
   for (i32 FrameIndex = 0; FrameIndex < FramesPerBuffer * ChannelCount; ++FrameIndex) {
@@ -23,37 +66,239 @@ void Distortion(f32* Buffer, i32 ChannelCount, i32 FramesPerBuffer, f32 Mix, f32
   }
 }
 
-void WeirdEffect(f32* Buffer, i32 ChannelCount, i32 FramesPerBuffer, f32 Mix, f32 Amount) {
-  f32 Dry = 1 - Mix;
+void WeirdEffect(effect* Effect, f32* Buffer, i32 ChannelCount, i32 FramesPerBuffer) {
+  weird_state* State = (weird_state*)Effect->State;
+  f32 Dry = 1 - Effect->Mix;
   f32 Wet = 1 - Dry;
+  i32 Amount = (i32)Effect->Amount;
+  i32 Index = State->Index;
   f32* Iter = Buffer;
 
   for (i32 FrameIndex = 0; FrameIndex < FramesPerBuffer * ChannelCount; ++FrameIndex) {
     f32 WetFrame = *Iter;
     f32 DryFrame = WetFrame;
 
-    EffectBuffer[EffectIndex] = DryFrame;
-    EffectIndex = (EffectIndex + 1) % EFFECT_BUFFER_SIZE;
-    WetFrame = EffectBuffer[(EffectIndex & (i32)Amount) % EFFECT_BUFFER_SIZE];
+    State->Buffer[Index] = DryFrame;
+    Index = (Index + 1) % EFFECT_BUFFER_SIZE;
+    WetFrame = State->Buffer[(Index & Amount) % EFFECT_BUFFER_SIZE];
 
     *(Iter++) = (DryFrame * Dry) + (WetFrame * Wet);
   }
+  State->Index = Index;
 }
 
-void WeirdEffect2(f32* Buffer, i32 ChannelCount, i32 FramesPerBuffer, f32 Mix, f32 Amount) {
-  f32 Dry = 1 - Mix;
+void WeirdEffect2(effect* Effect, f32* Buffer, i32 ChannelCount, i32 FramesPerBuffer) {
+  weird_state* State = (weird_state*)Effect->State;
+  f32 Dry = 1 - Effect->Mix;
   f32 Wet = 1 - Dry;
+  i32 Index = State->Index;
   f32* Iter = Buffer;
 
   for (i32 FrameIndex = 0; FrameIndex < FramesPerBuffer * ChannelCount; ++FrameIndex) {
     f32 WetFrame = *Iter;
     f32 DryFrame = WetFrame;
 
-    WetFrame = EffectBuffer[CurrentEffectIndex];
-    EffectBuffer[(i32)(CurrentEffectIndex + (EFFECT_BUFFER_SIZE / (1.0f + FrameIndex))) % EFFECT_BUFFER_SIZE] = DryFrame;
-    CurrentEffectIndex = (CurrentEffectIndex + 5) % EFFECT_BUFFER_SIZE;
+    WetFrame = State->Buffer[Index];
+    State->Buffer[(i32)(Index + (EFFECT_BUFFER_SIZE / (1.0f + FrameIndex))) % EFFECT_BUFFER_SIZE] = DryFrame;
+    Index = (Index + 5) % EFFECT_BUFFER_SIZE;
 
     *(Iter++) = (DryFrame * Dry) + (WetFrame * Wet);
   }
+  State->Index = Index;
+}
+
+// Loads the impulse response from reverb_impulse, or synthesizes one that falls by 60 dB over Seconds
+i32 ReverbImpulse(f32** Ir, i32* IrLength, i32 Channel, f32 Seconds) {
+  i32 SampleRate = AudioEngine.Initialized ? AudioEngine.SampleRate : G_SampleRate;
+  i32 MaxLength = (i32)((Clamp(Seconds, 0.01f, REVERB_MAX_SECONDS)) * SampleRate);
+  if (G_ReverbImpulse[0] != 0) {
+    audio_source Source;
+    if (LoadAudioSource(G_ReverbImpulse, &Source) != NoError || Source.ChannelCount == 0) {
+      fprintf(stderr, "Failed to load impulse response '%s'\n", G_ReverbImpulse);
+      return Error;
+    }
+    i32 ChannelCount = Source.ChannelCount;
+    i32 SourceChannel = Min(Channel, ChannelCount - 1);
+    *IrLength = Min((i32)(Source.SampleCount / ChannelCount), MaxLength);
+    if (*IrLength <= 0 || !(*Ir = M_Malloc(sizeof(f32) * *IrLength))) {
+      UnloadAudioSource(&Source);
+      return Error;
+    }
+    for (i32 Index = 0; Index < *IrLength; ++Index) {
+      (*Ir)[Index] = Source.Buffer[Index * ChannelCount + SourceChannel];
+    }
+    UnloadAudioSource(&Source);
+    return NoError;
+  }
+  *IrLength = MaxLength;
+  if (!(*Ir = M_Malloc(sizeof(f32) * *IrLength))) {
+    return Error;
+  }
+  // NOTE(lucas): Every channel gets noise of its own, which is what makes the reverb sound wide
+  u32 Seed = 0x9e3779b9u * (Channel + 1);
+  f32 Decay = logf(1000.0f) / *IrLength;
+  f64 Energy = 0;
+  for (i32 Index = 0; Index < *IrLength; ++Index) {
+    Seed = Seed * 1664525u + 1013904223u;
+    f32 Noise = (f32)(Seed >> 8) / (1 << 23) - 1.0f;
+    f32 Sample = Noise * expf(-Decay * Index);
+    (*Ir)[Index] = Sample;
+    Energy += Sample * Sample;
+  }
+  f32 Scale = Energy > 0 ? (f32)(1.0 / sqrt(Energy)) : 0;
+  for (i32 Index = 0; Index < *IrLength; ++Index) {
+    (*Ir)[Index] *= Scale;
+  }
+  return NoError;
 }
 
+i32 ReverbInit(effect* Effect, i32 Channel) {
+  reverb_state* State = (reverb_state*)Effect->State;
+  f32* Ir = NULL;
+  i32 IrLength = 0;
+  if (ReverbImpulse(&Ir, &IrLength, Channel, Effect->Amount) != NoError) {
+    return Error;
+  }
+  // NOTE(lucas): Offline rendering runs faster than real time, where the tail thread would fall behind
+  u8 Threaded = G_ReverbTailThread && AudioEngine.Initialized && !AudioEngine.Offline;
+  i32 Result = ConvolverInit(&State->Convolver, Ir, IrLength, Threaded);
+  M_Free(Ir, sizeof(f32) * IrLength);
+  return Result;
+}
+
+void Reverb(effect* Effect, f32* Buffer, i32 ChannelCount, i32 FramesPerBuffer) {
+  reverb_state* State = (reverb_state*)Effect->State;
+  f32 Dry = 1 - Effect->Mix;
+  f32 Wet = 1 - Dry;
+  f32 WetChunk[REVERB_CHUNK_SIZE];
+  i32 SampleCount = FramesPerBuffer * ChannelCount;
+
+  for (i32 Offset = 0; Offset < SampleCount; Offset += REVERB_CHUNK_SIZE) {
+    i32 Count = Min(SampleCount - Offset, REVERB_CHUNK_SIZE);
+    f32* Iter = &Buffer[Offset];
+    ConvolverProcess(&State->Convolver, Iter, WetChunk, Count);
+    for (i32 Index = 0; Index < Count; ++Index) {
+      Iter[Index] = (Iter[Index] * Dry) + (WetChunk[Index] * Wet);
+    }
+  }
+}
+
+void ReverbDestroy(effect* Effect) {
+  reverb_state* State = (reverb_state*)Effect->State;
+  ConvolverFree(&State->Convolver);
+}
+
+i32 EqEffectInit(effect* Effect, i32 Channel) {
+  (void)Channel;
+  eq_state* State = (eq_state*)Effect->State;
+  eq_band Bands[EQ_BAND_COUNT];
+  for (i32 Index = 0; Index < EQ_BAND_COUNT; ++Index) {
+    Bands[Index] = EqEffectBands[Index];
+    Bands[Index].Gain = G_EqGains[Index] * Effect->Amount;
+  }
+  EqInit(&State->Eq, Bands, AudioEngine.Initialized ? AudioEngine.SampleRate : G_SampleRate);
+  return NoError;
+}
+
+void EqEffect(effect* Effect, f32* Buffer, i32 ChannelCount, i32 FramesPerBuffer) {
+  eq_state* State = (eq_state*)Effect->State;
+  i32 SampleCount = FramesPerBuffer * ChannelCount;
+  if (Effect->Mix >= 1.0f) {
+    EqProcess(&State->Eq, Buffer, Buffer, SampleCount);
+    return;
+  }
+  f32 Dry = 1 - Effect->Mix;
+  f32 Wet = 1 - Dry;
+  f32 WetChunk[EQ_EFFECT_CHUNK_SIZE];
+
+  for (i32 Offset = 0; Offset < SampleCount; Offset += EQ_EFFECT_CHUNK_SIZE) {
+    i32 Count = Min(SampleCount - Offset, EQ_EFFECT_CHUNK_SIZE);
+    f32* Iter = &Buffer[Offset];
+    EqProcess(&State->Eq, Iter, WetChunk, Count);
+    for (i32 Index = 0; Index < Count; ++Index) {
+      Iter[Index] = (Iter[Index] * Dry) + (WetChunk[Index] * Wet);
+    }
+  }
+}
+
+// NOTE(lucas): Band settings are only read back by the thread that sets them, the processing thread has a copy
+i32 EffectSetEqGain(effect* Effect, i32 Band, f32 Gain) {
+  if (!Effect || Effect->Type != EFFECT_EQ || Band < 0 || Band >= EQ_BAND_COUNT) {
+    return Error;
+  }
+  eq_state* State = (eq_state*)Effect->State;
+  eq_band Settings = State->Eq.Bands[Band];
+  Settings.Gain = Gain;
+  EqSetBand(&State->Eq, Band, &Settings);
+  return NoError;
+}
+
+const eq_band* EffectEqBand(effect* Effect, i32 Band) {
+  if (!Effect || Effect->Type != EFFECT_EQ || Band < 0 || Band >= EQ_BAND_COUNT) {
+    return NULL;
+  }
+  eq_state* State = (eq_state*)Effect->State;
+  return &State->Eq.Bands[Band];
+}
+
+i32 EffectFindDef(const char* Name, u32 Length) {
+  for (i32 Type = 0; Type < MAX_EFFECT_TYPE; ++Type) {
+    const effect_def* Def = &EffectDefs[Type];
+    if (strlen(Def->Name) == Length && !strncmp(Def->Name, Name, Length)) {
+      return Type;
+    }
+  }
+  return -1;
+}
+
+effect* EffectCreate(effect_type Type, i32 Channel, f32 Mix, f32 Amount) {
+  if (Type < 0 || Type >= MAX_EFFECT_TYPE) {
+    return NULL;
+  }
+  const effect_def* Def = &EffectDefs[Type];
+  effect* Effect = M_Malloc(sizeof(effect));
+  if (!Effect) {
+    fprintf(stderr, "Failed to create effect (out of memory?)\n");
+    return NULL;
+  }
+  Effect->Type = Type;
+  Effect->Mix = Mix;
+  Effect->Amount = Amount;
+  Effect->State = NULL;
+  Effect->Process = Def->Process;
+  if (Def->StateSize > 0) {
+    if (!(Effect->State = M_Calloc(Def->StateSize, 1))) {
+      fprintf(stderr, "Failed to allocate the state of effect '%s'\n", Def->Name);
+      M_Free(Effect, sizeof(effect));
+      return NULL;
+    }
+  }
+  if (Def->Init && Def->Init(Effect, Channel) != NoError) {
+    fprintf(stderr, "Failed to initialize effect '%s'\n", Def->Name);
+    if (Effect->State) {
+      M_Free(Effect->State, Def->StateSize);
+    }
+    M_Free(Effect, sizeof(effect));
+    return NULL;
+  }
+  return Effect;
+}
+
+void EffectProcess(effect* Effect, f32* Buffer, i32 ChannelCount, i32 FramesPerBuffer) {
+  if (Effect && Effect->Process) {
+    Effect->Process(Effect, Buffer, ChannelCount, FramesPerBuffer);
+  }
+}
+
+void EffectDestroy(effect* Effect) {
+  if (!Effect) {
+    return;
+  }
+  if (EffectDefs[Effect->Type].Destroy) {
+    EffectDefs[Effect->Type].Destroy(Effect);
+  }
+  if (Effect->State) {
+    M_Free(Effect->State, EffectDefs[Effect->Type].StateSize);
+  }
+  M_Free(Effect, sizeof(effect));
+}
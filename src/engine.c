@@ -1,9 +1,17 @@
 // engine.c
 
+#include "wait_word.c"
 #include "stream.c"
+#include "audio_thread.c"
+#include "worker_pool.c"
+#include "mixer_graph.c"
 #include "mixer.c"
 #include "instrument.c"
+#include "dsp_load.c"
 #include "audio_engine.c"
+#include "convolver.c"
+#include "eq.c"
+#include "analyzer.c"
 #include "effect.c"
 
 #include "midi.c"
@@ -16,6 +24,8 @@
 #include "draw.c"
 #include "ui.c"
 #include "window.c"
+#include "render.c"
+#include "bench.c"
 
 typedef enum window_tag {
   TAG_MAIN = 0,
@@ -29,22 +39,11 @@ static u8 UseWindowTags = 0;
 
 static i32 BaseNote = 0;
 
-#define MAX_NOTE 127
-float NoteTable[MAX_NOTE] = {0};
-
 char TitleBuffer[MAX_BUFFER_SIZE] = {};
 
 static i32 EngineRun(audio_engine* Engine) {
   mixer* Mixer = &Engine->Mixer;
 
-  MidiInitHandle(MIDI_HANDLE_SERIAL);
-  MidiInit();
-  MidiOpenDevices();
-
-  midi_event MidiEvents[MAX_MIDI_EVENT] = {0};
-  u32 MidiEventCount = 0;
-  memset(NoteTable, 0, ArraySize(NoteTable) * sizeof(float));
-
   if (WindowOpen(G_WindowWidth, G_WindowHeight, TITLE, G_Vsync, G_FullScreen) == NoError) {
     WindowAddResizeCallback(UI_WindowResizeCallback);
     WindowAddResizeCallback(RendererResizeWindowCallback);
@@ -55,31 +54,7 @@ static i32 EngineRun(audio_engine* Engine) {
     while (WindowPollEvents() == 0) {
       REAL_TIMER_START();
 
-      MidiEventCount = MidiFetchEvents(MidiEvents);
-
-      if (MidiEventCount > 0) {
-        for (u32 EventIndex = 0; EventIndex < MidiEventCount; ++EventIndex) {
-          midi_event* Event = &MidiEvents[EventIndex];
-          u8 Message = Event->Message;
-          u8 A = Event->A;
-          u8 B = Event->B;
-          switch (Message) {
-            case MIDI_NOTE_ON: {
-              // printf("NOTE ON, note: %u, velocity: %u\n", A, B);
-              float Velocity = (float)B / UINT8_MAX;
-              NoteTable[A] = Velocity;
-              break;
-            }
-            case MIDI_NOTE_OFF: {
-              NoteTable[A] = 0;
-              // printf("NOTE OFF, note: %u, velocity: %u\n", A, B);
-              break;
-            }
-            default:
-              break;
-          }
-        }
-      }
+      MixerUpdate(Mixer);
 
       if (KeyPressed[GLFW_KEY_SPACE]) {
         Engine->Playing = !Engine->Playing;
@@ -137,14 +112,13 @@ static i32 EngineRun(audio_engine* Engine) {
             case TAG_MAIN: {
               UI_SetPlacement(PLACEMENT_VERTICAL);
               if (UI_DoTextButton(UI_ID, "Add")) {
-                bus* Bus = MixerAddBus0(Mixer, 2, NULL, NULL);
-                if (Bus) {
-                  instrument* Sampler = InstrumentCreate(INSTRUMENT_SAMPLER);
-                  MixerAttachInstrumentToBus0(Mixer, Bus, Sampler);
-                }
+                MixerAddBus(Mixer, 2, NULL, InstrumentCreate(INSTRUMENT_SAMPLER), NULL);
               }
               if (UI_DoTextButton(UI_ID, "Remove")) {
-                MixerRemoveBus(Mixer, Mixer->BusCount - 1);
+                bus_handle Last = MixerGetBusHandle(Mixer, MixerBusCount(Mixer) - 1);
+                if (Last != BUS_HANDLE_NONE) {
+                  MixerRemoveBus(Mixer, Last);
+                }
               }
               if (UI_DoTextButton(UI_ID, "Reset")) {
                 Engine->Tick = 0;
@@ -167,6 +141,7 @@ static i32 EngineRun(audio_engine* Engine) {
               bus* Focus = MixerGetFocusedBus(Mixer);
               if (Focus) {
                 InstrumentDraw(Focus->Ins);
+                MixerDrawInserts(Mixer, Mixer->FocusedBus);
               }
               break;
             }
@@ -175,18 +150,13 @@ static i32 EngineRun(audio_engine* Engine) {
               for (i32 InstrumentIndex = 0; InstrumentIndex < InsHandler.InstrumentCount; ++InstrumentIndex) {
                 instrument_def* InstrumentDef = &InsHandler.Instruments[InstrumentIndex];
                 if (UI_DoTextButton(UI_ID + InstrumentIndex, InstrumentDef->Name)) {
-                  bus* Bus = MixerAddBus0(Mixer, 2, NULL, NULL);
-                  if (Bus) {
-                    instrument* Instrument = InstrumentCreate(InstrumentIndex);
-                    if (Instrument) {
-                      MixerAttachInstrumentToBus0(Mixer, Bus, Instrument);
-                    }
-                  }
+                  MixerAddBus(Mixer, 2, NULL, InstrumentCreate(InstrumentIndex), NULL);
                 }
               }
               break;
             }
             case TAG_MIXER: {
+              MixerDrawAnalyzer(Mixer);
               MixerRender(Mixer);
               break;
             }
@@ -205,14 +175,13 @@ static i32 EngineRun(audio_engine* Engine) {
 
           if (UI_DoContainer(UI_ID)) {
             if (UI_DoTextButton(UI_ID, "Add")) {
-              bus* Bus = MixerAddBus0(Mixer, 2, NULL, NULL);
-              if (Bus) {
-                instrument* Sampler = InstrumentCreate(INSTRUMENT_SAMPLER);
-                MixerAttachInstrumentToBus0(Mixer, Bus, Sampler);
-              }
+              MixerAddBus(Mixer, 2, NULL, InstrumentCreate(INSTRUMENT_SAMPLER), NULL);
             }
             if (UI_DoTextButton(UI_ID, "Remove")) {
-              MixerRemoveBus(Mixer, Mixer->BusCount - 1);
+              bus_handle Last = MixerGetBusHandle(Mixer, MixerBusCount(Mixer) - 1);
+              if (Last != BUS_HANDLE_NONE) {
+                MixerRemoveBus(Mixer, Last);
+              }
             }
             if (UI_DoTextButton(UI_ID, "Reset")) {
               Engine->Tick = 0;
@@ -234,13 +203,7 @@ static i32 EngineRun(audio_engine* Engine) {
               for (i32 InstrumentIndex = 0; InstrumentIndex < InsHandler.InstrumentCount; ++InstrumentIndex) {
                 instrument_def* InstrumentDef = &InsHandler.Instruments[InstrumentIndex];
                 if (UI_DoTextButton(UI_ID + InstrumentIndex, InstrumentDef->Name)) {
-                  bus* Bus = MixerAddBus0(Mixer, 2, NULL, NULL);
-                  if (Bus) {
-                    instrument* Instrument = InstrumentCreate(InstrumentIndex);
-                    if (Instrument) {
-                      MixerAttachInstrumentToBus0(Mixer, Bus, Instrument);
-                    }
-                  }
+                  MixerAddBus(Mixer, 2, NULL, InstrumentCreate(InstrumentIndex), NULL);
                 }
               }
               UI_EndContainer();
@@ -249,6 +212,7 @@ static i32 EngineRun(audio_engine* Engine) {
             if (Focus) {
               if (UI_DoContainer(UI_ID)) {
                 InstrumentDraw(Focus->Ins);
+                MixerDrawInserts(Mixer, Mixer->FocusedBus);
                 UI_EndContainer();
               }
             }
@@ -256,6 +220,7 @@ static i32 EngineRun(audio_engine* Engine) {
           }
           UI_SetContainerSize(V2(0.5f, 1.0f));
           if (UI_DoContainer(UI_ID)) {
+            MixerDrawAnalyzer(Mixer);
             MixerRender(Mixer);
             UI_EndContainer();
           }
@@ -267,13 +232,15 @@ static i32 EngineRun(audio_engine* Engine) {
       RendererEndFrame();
 
       REAL_TIMER_END(
-        snprintf(TitleBuffer, MAX_BUFFER_SIZE, "%s | fps: %i | bpm: %i | time: %.4g s", PROG_NAME, (i32)(1.0f / _DeltaTime), TempoBPM, Engine->Time);
+        dsp_load_stats Load;
+        DspLoadRead(&Engine->Load, &Load);
+        u32 Xruns = atomic_load(&Engine->Load.Underflows) + atomic_load(&Engine->Load.Overflows) + atomic_load(&Engine->Load.LateCount);
+        snprintf(TitleBuffer, MAX_BUFFER_SIZE, "%s | fps: %i | bpm: %i | time: %.4g s | dsp: %.0f%% (max %.0f%%) | xruns: %u", PROG_NAME, (i32)(1.0f / _DeltaTime), TempoBPM, Engine->Time, 100 * Load.Avg, 100 * Load.Max, Xruns);
         WindowSetTitle(TitleBuffer);
       );
     }
     RendererFree();
     UI_Free();
-    MidiCloseDevices();
   }
   return NoError;
 }
@@ -281,11 +248,24 @@ static i32 EngineRun(audio_engine* Engine) {
 i32 EngineInit() {
   audio_engine* Engine = &AudioEngine;
   mixer* Mixer = &Engine->Mixer;
+  // NOTE(lucas): Memory has to be locked before anything is allocated, so that samples don't get paged out either
+  AudioThreadLockMemory();
   MixerInit(Mixer, G_SampleRate, G_FramesPerBuffer);
   InstrumentHandlerInit();
 
+  // NOTE(lucas): The audio thread reads MIDI, so MIDI is started before the audio device and stopped after it
+  MidiInitHandle(MIDI_HANDLE_SERIAL);
+  MidiInit();
+  MidiOpenDevices();
+
   AudioEngineStateInit(G_SampleRate, G_FramesPerBuffer);
-  AudioEngineStart(NULL);
+  if (AudioEngineStart(NULL) == NoError) {
+    // NOTE(lucas): The audio thread configures itself in the first callback, give it a moment
+    for (i32 Attempt = 0; Attempt < 100 && !atomic_load(&AudioThreadReport.Ready); ++Attempt) {
+      usleep(10000);
+    }
+    AudioThreadPrintReport(stdout);
+  }
   EngineRun(Engine);
 
   WindowClose();
@@ -296,6 +276,9 @@ void EngineFree() {
   audio_engine* Engine = &AudioEngine;
   mixer* Mixer = &Engine->Mixer;
   AudioEngineTerminate();
+  DspLoadPrint(&Engine->Load, stdout);
+  MidiCloseDevices();
+  MidiFree();
   MixerFree(Mixer);
   InstrumentHandlerFree();
 }
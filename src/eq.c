@@ -0,0 +1,257 @@
+// eq.c
+// parametric equalizer, a cascade of state variable filters which are run side by side in vector lanes
+
+#define EQ_MIN_FREQ 10.0f
+#define EQ_MAX_FREQ 0.45f // Of the sample rate
+#define EQ_SETTLED 1e-5f  // Coefficients closer than this to their targets stop being smoothed
+
+static void EqComputeBand(eq_coefs* Coefs, i32 Index, const eq_band* Band, i32 SampleRate);
+static void EqUpdate(eq_bank* Eq, i32 FrameCount);
+static void EqDerive(eq_bank* Eq);
+static void EqChunk(eq_bank* Eq, const f32* In, f32* Out, i32 FrameCount);
+
+// NOTE(lucas): See "Solving the continuous SVF equations using trapezoidal integration..." by Andrew Simper
+void EqComputeBand(eq_coefs* Coefs, i32 Index, const eq_band* Band, i32 SampleRate) {
+  f32 Frequency = Clamp(Band->Frequency, EQ_MIN_FREQ, EQ_MAX_FREQ * SampleRate);
+  f32 G = tanf(PI32 * Frequency / SampleRate);
+  f32 K = 1.0f / (Clamp(Band->Q, 0.1f, 20.0f));
+  f32 A = powf(10.0f, Band->Gain / 40.0f);
+  f32 M0 = 1.0f;
+  f32 M1 = 0.0f;
+  f32 M2 = 0.0f;
+  switch (Band->Type) {
+    case EQ_BELL: {
+      K /= A;
+      M1 = K * (A * A - 1.0f);
+      break;
+    }
+    case EQ_LOW_SHELF: {
+      G /= sqrtf(A);
+      M1 = K * (A - 1.0f);
+      M2 = A * A - 1.0f;
+      break;
+    }
+    case EQ_HIGH_SHELF: {
+      G *= sqrtf(A);
+      M0 = A * A;
+      M1 = K * (1.0f - A) * A;
+      M2 = 1.0f - A * A;
+      break;
+    }
+    case EQ_LOW_CUT: {
+      M1 = -K;
+      M2 = -1.0f;
+      break;
+    }
+    case EQ_HIGH_CUT: {
+      M0 = 0.0f;
+      M2 = 1.0f;
+      break;
+    }
+    default:
+      break;
+  }
+  Coefs->G[Index] = G;
+  Coefs->K[Index] = K;
+  Coefs->M0[Index] = M0;
+  Coefs->M1[Index] = M1;
+  Coefs->M2[Index] = M2;
+}
+
+void EqInit(eq_bank* Eq, const eq_band* Bands, i32 SampleRate) {
+  memset(Eq, 0, sizeof(eq_bank));
+  memcpy(Eq->Bands, Bands, sizeof(Eq->Bands));
+  atomic_init(&Eq->Sequence, 0);
+  Eq->SampleRate = SampleRate;
+  for (i32 Index = 0; Index < EQ_BAND_COUNT; ++Index) {
+    EqComputeBand(&Eq->Target, Index, &Bands[Index], SampleRate);
+  }
+  Eq->Current = Eq->Target;
+  EqDerive(Eq);
+}
+
+void EqSetBand(eq_bank* Eq, i32 Index, const eq_band* Band) {
+  if (Index < 0 || Index >= EQ_BAND_COUNT) {
+    return;
+  }
+  u32 Sequence = atomic_load_explicit(&Eq->Sequence, memory_order_relaxed);
+  atomic_store_explicit(&Eq->Sequence, Sequence + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  Eq->Bands[Index] = *Band;
+  atomic_store_explicit(&Eq->Sequence, Sequence + 2, memory_order_release);
+}
+
+// NOTE(lucas): Settings that are being written, or that changed during the copy, are left for the next chunk
+void EqUpdate(eq_bank* Eq, i32 FrameCount) {
+  u32 Sequence = atomic_load_explicit(&Eq->Sequence, memory_order_acquire);
+  if (Sequence != Eq->Applied && !(Sequence & 1)) {
+    eq_band Bands[EQ_BAND_COUNT];
+    memcpy(Bands, Eq->Bands, sizeof(Bands));
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&Eq->Sequence, memory_order_relaxed) == Sequence) {
+      for (i32 Index = 0; Index < EQ_BAND_COUNT; ++Index) {
+        EqComputeBand(&Eq->Target, Index, &Bands[Index], Eq->SampleRate);
+      }
+      Eq->Applied = Sequence;
+      Eq->Smoothing = 1;
+    }
+  }
+  if (!Eq->Smoothing) {
+    return;
+  }
+  f32 Factor = 1.0f - expf(-FrameCount / (EQ_SMOOTH_TIME * Eq->SampleRate));
+  f32* Current = (f32*)&Eq->Current;
+  f32* Target = (f32*)&Eq->Target;
+  u8 Settled = 1;
+  for (i32 Index = 0; Index < (i32)(sizeof(eq_coefs) / sizeof(f32)); ++Index) {
+    Current[Index] += (Target[Index] - Current[Index]) * Factor;
+    if (fabsf(Target[Index] - Current[Index]) > EQ_SETTLED) {
+      Settled = 0;
+    }
+  }
+  if (Settled) {
+    Eq->Current = Eq->Target;
+    Eq->Smoothing = 0;
+  }
+  EqDerive(Eq);
+}
+
+// NOTE(lucas): The update of the paper with the outputs mixed in, split so that a band is one multiply-add deep
+void EqDerive(eq_bank* Eq) {
+  for (i32 Index = 0; Index < EQ_BAND_COUNT; ++Index) {
+    f32 G = Eq->Current.G[Index];
+    f32 K = Eq->Current.K[Index];
+    f32 M0 = Eq->Current.M0[Index];
+    f32 M1 = Eq->Current.M1[Index];
+    f32 M2 = Eq->Current.M2[Index];
+    f32 A1 = 1.0f / (1.0f + G * (G + K));
+    f32 A2 = G * A1;
+    f32 A3 = G * A2;
+    Eq->Gx[Index] = M0 + M1 * A2 + M2 * A3;
+    Eq->G1[Index] = M1 * A1 + M2 * A2;
+    Eq->G2[Index] = M2 * (1.0f - A3) - M1 * A2;
+    Eq->U1[Index] = 2.0f * A2;
+    Eq->U2[Index] = 2.0f * A3;
+    Eq->D1[Index] = 2.0f * A1 - 1.0f;
+    Eq->D2[Index] = 1.0f - 2.0f * A3;
+  }
+}
+
+#if USE_SSE
+
+// Shifts the lanes of Prev up by one, with the last lane of In going into the first lane
+#define EqShift(In, Prev) _mm_shuffle_ps(_mm_shuffle_ps(In, Prev, _MM_SHUFFLE(0, 0, 3, 3)), Prev, _MM_SHUFFLE(2, 1, 2, 0))
+
+typedef struct eq_lanes {
+  __m128 Gx[EQ_VECTOR_COUNT];
+  __m128 G1[EQ_VECTOR_COUNT];
+  __m128 G2[EQ_VECTOR_COUNT];
+  __m128 U1[EQ_VECTOR_COUNT];
+  __m128 U2[EQ_VECTOR_COUNT];
+  __m128 D1[EQ_VECTOR_COUNT];
+  __m128 D2[EQ_VECTOR_COUNT];
+  __m128 Ic1[EQ_VECTOR_COUNT];
+  __m128 Ic2[EQ_VECTOR_COUNT];
+  __m128 Y[EQ_VECTOR_COUNT];  // Output of every band at the previous step
+} eq_lanes;
+
+// Advances every band by a frame, only the lanes in Active (if given) update their state. Returns what the last band
+// put out.
+static inline f32 EqStep(eq_lanes* L, f32 In, const __m128* Active) {
+  __m128 X[EQ_VECTOR_COUNT];
+  X[0] = EqShift(_mm_set1_ps(In), L->Y[0]);
+  for (i32 V = 1; V < EQ_VECTOR_COUNT; ++V) {
+    X[V] = EqShift(L->Y[V - 1], L->Y[V]);
+  }
+  for (i32 V = 0; V < EQ_VECTOR_COUNT; ++V) {
+    __m128 Ic1 = L->Ic1[V];
+    __m128 Ic2 = L->Ic2[V];
+    __m128 NewIc1 = _mm_add_ps(_mm_mul_ps(L->U1[V], X[V]), _mm_sub_ps(_mm_mul_ps(L->D1[V], Ic1), _mm_mul_ps(L->U1[V], Ic2)));
+    __m128 NewIc2 = _mm_add_ps(_mm_mul_ps(L->U2[V], X[V]), _mm_add_ps(_mm_mul_ps(L->D2[V], Ic2), _mm_mul_ps(L->U1[V], Ic1)));
+    L->Y[V] = _mm_add_ps(_mm_mul_ps(L->Gx[V], X[V]), _mm_add_ps(_mm_mul_ps(L->G1[V], Ic1), _mm_mul_ps(L->G2[V], Ic2)));
+    if (Active) {
+      NewIc1 = _mm_or_ps(_mm_and_ps(Active[V], NewIc1), _mm_andnot_ps(Active[V], Ic1));
+      NewIc2 = _mm_or_ps(_mm_and_ps(Active[V], NewIc2), _mm_andnot_ps(Active[V], Ic2));
+    }
+    L->Ic1[V] = NewIc1;
+    L->Ic2[V] = NewIc2;
+  }
+  __m128 Last = L->Y[EQ_VECTOR_COUNT - 1];
+  return _mm_cvtss_f32(_mm_shuffle_ps(Last, Last, _MM_SHUFFLE(3, 3, 3, 3)));
+}
+
+// Step where some of the lanes are outside of the chunk
+static inline void EqEdgeStep(eq_lanes* L, const __m128* Lane, const f32* In, f32* Out, i32 Step, i32 FrameCount) {
+  __m128 Active[EQ_VECTOR_COUNT];
+  for (i32 V = 0; V < EQ_VECTOR_COUNT; ++V) {
+    __m128 Frame = _mm_sub_ps(_mm_set1_ps((f32)Step), Lane[V]);
+    Active[V] = _mm_and_ps(_mm_cmpge_ps(Frame, _mm_setzero_ps()), _mm_cmplt_ps(Frame, _mm_set1_ps((f32)FrameCount)));
+  }
+  f32 Result = EqStep(L, Step < FrameCount ? In[Step] : 0.0f, Active);
+  if (Step >= EQ_BAND_COUNT - 1) {
+    Out[Step - (EQ_BAND_COUNT - 1)] = Result;
+  }
+}
+
+// NOTE(lucas): Bands are skewed in time to run side by side, at step t band b processes frame t - b
+void EqChunk(eq_bank* Eq, const f32* In, f32* Out, i32 FrameCount) {
+  const i32 Depth = EQ_BAND_COUNT - 1;
+  eq_lanes L;
+  __m128 Lane[EQ_VECTOR_COUNT];
+  for (i32 V = 0; V < EQ_VECTOR_COUNT; ++V) {
+    i32 Offset = V * EQ_LANE_COUNT;
+    L.Gx[V] = _mm_loadu_ps(&Eq->Gx[Offset]);
+    L.G1[V] = _mm_loadu_ps(&Eq->G1[Offset]);
+    L.G2[V] = _mm_loadu_ps(&Eq->G2[Offset]);
+    L.U1[V] = _mm_loadu_ps(&Eq->U1[Offset]);
+    L.U2[V] = _mm_loadu_ps(&Eq->U2[Offset]);
+    L.D1[V] = _mm_loadu_ps(&Eq->D1[Offset]);
+    L.D2[V] = _mm_loadu_ps(&Eq->D2[Offset]);
+    L.Ic1[V] = _mm_loadu_ps(&Eq->Ic1[Offset]);
+    L.Ic2[V] = _mm_loadu_ps(&Eq->Ic2[Offset]);
+    L.Y[V] = _mm_setzero_ps();
+    Lane[V] = _mm_setr_ps(Offset, Offset + 1, Offset + 2, Offset + 3);
+  }
+
+  i32 Step = 0;
+  for (; Step < Depth; ++Step) {
+    EqEdgeStep(&L, Lane, In, Out, Step, FrameCount);
+  }
+  for (; Step < FrameCount; ++Step) {
+    Out[Step - Depth] = EqStep(&L, In[Step], NULL);
+  }
+  for (; Step < FrameCount + Depth; ++Step) {
+    EqEdgeStep(&L, Lane, In, Out, Step, FrameCount);
+  }
+
+  for (i32 V = 0; V < EQ_VECTOR_COUNT; ++V) {
+    _mm_storeu_ps(&Eq->Ic1[V * EQ_LANE_COUNT], L.Ic1[V]);
+    _mm_storeu_ps(&Eq->Ic2[V * EQ_LANE_COUNT], L.Ic2[V]);
+  }
+}
+
+#else
+
+void EqChunk(eq_bank* Eq, const f32* In, f32* Out, i32 FrameCount) {
+  for (i32 FrameIndex = 0; FrameIndex < FrameCount; ++FrameIndex) {
+    f32 X = In[FrameIndex];
+    for (i32 Index = 0; Index < EQ_BAND_COUNT; ++Index) {
+      f32 Ic1 = Eq->Ic1[Index];
+      f32 Ic2 = Eq->Ic2[Index];
+      Eq->Ic1[Index] = Eq->U1[Index] * X + (Eq->D1[Index] * Ic1 - Eq->U1[Index] * Ic2);
+      Eq->Ic2[Index] = Eq->U2[Index] * X + (Eq->D2[Index] * Ic2 + Eq->U1[Index] * Ic1);
+      X = Eq->Gx[Index] * X + (Eq->G1[Index] * Ic1 + Eq->G2[Index] * Ic2);
+    }
+    Out[FrameIndex] = X;
+  }
+}
+
+#endif
+
+void EqProcess(eq_bank* Eq, const f32* In, f32* Out, i32 FrameCount) {
+  for (i32 Offset = 0; Offset < FrameCount; Offset += EQ_CHUNK_SIZE) {
+    i32 Count = Min(FrameCount - Offset, EQ_CHUNK_SIZE);
+    EqUpdate(Eq, Count);
+    EqChunk(Eq, &In[Offset], &Out[Offset], Count);
+  }
+}
@@ -0,0 +1,327 @@
+// fft.c
+// fast fourier transform of power of two sizes
+
+#define FFT_TWIDDLE_ALIGN (FFT_ALIGNMENT / sizeof(f32)) // Every twiddle array of a stage starts at an aligned offset
+
+static i32 TwiddleStride(i32 Quarter);
+static void Radix2Stage(i32 Size, f32* Re, f32* Im);
+static void Radix4Stage(i32 Size, i32 Quarter, const f32* Twiddles, f32* Re, f32* Im);
+static void Transform(fft_plan* Plan, f32* Re, f32* Im);
+
+i32 TwiddleStride(i32 Quarter) {
+  return (Quarter + FFT_TWIDDLE_ALIGN - 1) & ~(FFT_TWIDDLE_ALIGN - 1);
+}
+
+// NOTE(lucas): Only runs first (when the size is an odd power of two), where all of the twiddles are one
+void Radix2Stage(i32 Size, f32* Re, f32* Im) {
+  for (i32 Index = 0; Index < Size; Index += 2) {
+    f32 Re1 = Re[Index + 1];
+    f32 Im1 = Im[Index + 1];
+    Re[Index + 1] = Re[Index] - Re1;
+    Im[Index + 1] = Im[Index] - Im1;
+    Re[Index] += Re1;
+    Im[Index] += Im1;
+  }
+}
+
+// NOTE(lucas): Two radix-2 stages per pass (radix-2^2), which halves the number of passes over the data
+void Radix4Stage(i32 Size, i32 Quarter, const f32* Twiddles, f32* Re, f32* Im) {
+  i32 Stride = TwiddleStride(Quarter);
+  const f32* Cos1 = Twiddles;
+  const f32* Sin1 = &Twiddles[Stride];
+  const f32* Cos2 = &Twiddles[2 * Stride];
+  const f32* Sin2 = &Twiddles[3 * Stride];
+  for (i32 Start = 0; Start < Size; Start += 4 * Quarter) {
+    f32* Re0 = &Re[Start];
+    f32* Im0 = &Im[Start];
+    f32* Re1 = &Re0[Quarter];
+    f32* Im1 = &Im0[Quarter];
+    f32* Re2 = &Re1[Quarter];
+    f32* Im2 = &Im1[Quarter];
+    f32* Re3 = &Re2[Quarter];
+    f32* Im3 = &Im2[Quarter];
+    i32 Index = 0;
+#if defined(SIMD_WIDTH)
+    for (; Index + SIMD_WIDTH <= Quarter; Index += SIMD_WIDTH) {
+      simd_f32 C1 = SimdLoad(&Cos1[Index]);
+      simd_f32 S1 = SimdLoad(&Sin1[Index]);
+      simd_f32 C2 = SimdLoad(&Cos2[Index]);
+      simd_f32 S2 = SimdLoad(&Sin2[Index]);
+      simd_f32 X0r = SimdLoad(&Re0[Index]);
+      simd_f32 X0i = SimdLoad(&Im0[Index]);
+      simd_f32 X1r = SimdLoad(&Re1[Index]);
+      simd_f32 X1i = SimdLoad(&Im1[Index]);
+      simd_f32 X2r = SimdLoad(&Re2[Index]);
+      simd_f32 X2i = SimdLoad(&Im2[Index]);
+      simd_f32 X3r = SimdLoad(&Re3[Index]);
+      simd_f32 X3i = SimdLoad(&Im3[Index]);
+
+      simd_f32 B1r = SimdSub(SimdMul(X1r, C1), SimdMul(X1i, S1));
+      simd_f32 B1i = SimdAdd(SimdMul(X1r, S1), SimdMul(X1i, C1));
+      simd_f32 B3r = SimdSub(SimdMul(X3r, C1), SimdMul(X3i, S1));
+      simd_f32 B3i = SimdAdd(SimdMul(X3r, S1), SimdMul(X3i, C1));
+      simd_f32 T0r = SimdAdd(X0r, B1r);
+      simd_f32 T0i = SimdAdd(X0i, B1i);
+      simd_f32 T1r = SimdSub(X0r, B1r);
+      simd_f32 T1i = SimdSub(X0i, B1i);
+      simd_f32 T2r = SimdAdd(X2r, B3r);
+      simd_f32 T2i = SimdAdd(X2i, B3i);
+      simd_f32 T3r = SimdSub(X2r, B3r);
+      simd_f32 T3i = SimdSub(X2i, B3i);
+
+      simd_f32 B2r = SimdSub(SimdMul(T2r, C2), SimdMul(T2i, S2));
+      simd_f32 B2i = SimdAdd(SimdMul(T2r, S2), SimdMul(T2i, C2));
+      // Multiplied by -j, so the real and imaginary parts swap places
+      simd_f32 B4i = SimdSub(SimdMul(T3i, S2), SimdMul(T3r, C2));
+      simd_f32 B4r = SimdAdd(SimdMul(T3r, S2), SimdMul(T3i, C2));
+
+      SimdStore(&Re0[Index], SimdAdd(T0r, B2r));
+      SimdStore(&Im0[Index], SimdAdd(T0i, B2i));
+      SimdStore(&Re2[Index], SimdSub(T0r, B2r));
+      SimdStore(&Im2[Index], SimdSub(T0i, B2i));
+      SimdStore(&Re1[Index], SimdAdd(T1r, B4r));
+      SimdStore(&Im1[Index], SimdAdd(T1i, B4i));
+      SimdStore(&Re3[Index], SimdSub(T1r, B4r));
+      SimdStore(&Im3[Index], SimdSub(T1i, B4i));
+    }
+#endif
+    for (; Index < Quarter; ++Index) {
+      f32 C1 = Cos1[Index];
+      f32 S1 = Sin1[Index];
+      f32 C2 = Cos2[Index];
+      f32 S2 = Sin2[Index];
+
+      f32 B1r = Re1[Index] * C1 - Im1[Index] * S1;
+      f32 B1i = Re1[Index] * S1 + Im1[Index] * C1;
+      f32 B3r = Re3[Index] * C1 - Im3[Index] * S1;
+      f32 B3i = Re3[Index] * S1 + Im3[Index] * C1;
+      f32 T0r = Re0[Index] + B1r;
+      f32 T0i = Im0[Index] + B1i;
+      f32 T1r = Re0[Index] - B1r;
+      f32 T1i = Im0[Index] - B1i;
+      f32 T2r = Re2[Index] + B3r;
+      f32 T2i = Im2[Index] + B3i;
+      f32 T3r = Re2[Index] - B3r;
+      f32 T3i = Im2[Index] - B3i;
+
+      f32 B2r = T2r * C2 - T2i * S2;
+      f32 B2i = T2r * S2 + T2i * C2;
+      f32 B4i = T3i * S2 - T3r * C2;
+      f32 B4r = T3r * S2 + T3i * C2;
+
+      Re0[Index] = T0r + B2r;
+      Im0[Index] = T0i + B2i;
+      Re2[Index] = T0r - B2r;
+      Im2[Index] = T0i - B2i;
+      Re1[Index] = T1r + B4r;
+      Im1[Index] = T1i + B4i;
+      Re3[Index] = T1r - B4r;
+      Im3[Index] = T1i - B4i;
+    }
+  }
+}
+
+// NOTE(lucas): Decimation in time, the input is put in bit reversed order and the butterflies grow from there
+void Transform(fft_plan* Plan, f32* Re, f32* Im) {
+  i32 Size = Plan->Size;
+  for (i32 Index = 0; Index < Size; ++Index) {
+    i32 Reversed = Plan->Reverse[Index];
+    if (Index < Reversed) {
+      f32 Temp = Re[Index];
+      Re[Index] = Re[Reversed];
+      Re[Reversed] = Temp;
+      Temp = Im[Index];
+      Im[Index] = Im[Reversed];
+      Im[Reversed] = Temp;
+    }
+  }
+  i32 Quarter = 1;
+  if (Plan->Log2Size & 1) {
+    Radix2Stage(Size, Re, Im);
+    Quarter = 2;
+  }
+  const f32* Twiddles = Plan->Twiddles;
+  for (; 4 * Quarter <= Size; Quarter *= 4) {
+    Radix4Stage(Size, Quarter, Twiddles, Re, Im);
+    Twiddles += 4 * TwiddleStride(Quarter);
+  }
+}
+
+i32 FftPlanInit(fft_plan* Plan, i32 Size) {
+  memset(Plan, 0, sizeof(fft_plan));
+  if (Size < FFT_MIN_SIZE || Size > FFT_MAX_SIZE || (Size & (Size - 1))) {
+    fprintf(stderr, "Unsupported FFT size %i\n", Size);
+    return Error;
+  }
+  Plan->Size = Size;
+  while ((1 << Plan->Log2Size) < Size) {
+    ++Plan->Log2Size;
+  }
+  i32 FirstQuarter = (Plan->Log2Size & 1) ? 2 : 1;
+  for (i32 Quarter = FirstQuarter; 4 * Quarter <= Size; Quarter *= 4) {
+    Plan->TwiddleCount += 4 * TwiddleStride(Quarter);
+  }
+  Plan->Twiddles = FftAlloc(Max(Plan->TwiddleCount, 1));
+  Plan->Reverse = M_Malloc(sizeof(u32) * Size);
+  if (!Plan->Twiddles || !Plan->Reverse) {
+    FftPlanFree(Plan);
+    return Error;
+  }
+  f32* Twiddles = Plan->Twiddles;
+  for (i32 Quarter = FirstQuarter; 4 * Quarter <= Size; Quarter *= 4) {
+    i32 Stride = TwiddleStride(Quarter);
+    for (i32 Index = 0; Index < Quarter; ++Index) {
+      f64 Angle1 = -2.0 * M_PI * Index / (2 * Quarter);
+      f64 Angle2 = -2.0 * M_PI * Index / (4 * Quarter);
+      Twiddles[Index] = (f32)cos(Angle1);
+      Twiddles[Stride + Index] = (f32)sin(Angle1);
+      Twiddles[2 * Stride + Index] = (f32)cos(Angle2);
+      Twiddles[3 * Stride + Index] = (f32)sin(Angle2);
+    }
+    Twiddles += 4 * Stride;
+  }
+  for (i32 Index = 0; Index < Size; ++Index) {
+    u32 Reversed = 0;
+    for (i32 Bit = 0; Bit < Plan->Log2Size; ++Bit) {
+      Reversed |= ((Index >> Bit) & 1) << (Plan->Log2Size - 1 - Bit);
+    }
+    Plan->Reverse[Index] = Reversed;
+  }
+  return NoError;
+}
+
+void FftForward(fft_plan* Plan, f32* Re, f32* Im) {
+  Transform(Plan, Re, Im);
+}
+
+// NOTE(lucas): Swapping real and imaginary parts turns the forward transform into the inverse one
+void FftInverse(fft_plan* Plan, f32* Re, f32* Im) {
+  Transform(Plan, Im, Re);
+}
+
+void FftPlanFree(fft_plan* Plan) {
+  FftFree(Plan->Twiddles, Max(Plan->TwiddleCount, 1));
+  if (Plan->Reverse) {
+    M_Free(Plan->Reverse, sizeof(u32) * Plan->Size);
+  }
+  memset(Plan, 0, sizeof(fft_plan));
+}
+
+i32 FftRealPlanInit(fft_real_plan* Plan, i32 Size) {
+  memset(Plan, 0, sizeof(fft_real_plan));
+  if (Size < 2 * FFT_MIN_SIZE || Size > FFT_MAX_SIZE || (Size & (Size - 1))) {
+    fprintf(stderr, "Unsupported real FFT size %i\n", Size);
+    return Error;
+  }
+  if (FftPlanInit(&Plan->Half, Size / 2) != NoError) {
+    return Error;
+  }
+  Plan->Size = Size;
+  Plan->Cos = FftAlloc(Size / 4 + 1);
+  Plan->Sin = FftAlloc(Size / 4 + 1);
+  if (!Plan->Cos || !Plan->Sin) {
+    FftRealPlanFree(Plan);
+    return Error;
+  }
+  for (i32 Index = 0; Index <= Size / 4; ++Index) {
+    f64 Angle = -2.0 * M_PI * Index / Size;
+    Plan->Cos[Index] = (f32)cos(Angle);
+    Plan->Sin[Index] = (f32)sin(Angle);
+  }
+  return NoError;
+}
+
+// NOTE(lucas): A half size transform of the even and odd samples, pulled apart by the symmetry of a real spectrum
+void FftRealForward(fft_real_plan* Plan, const f32* In, f32* Re, f32* Im) {
+  i32 Half = Plan->Size / 2;
+  for (i32 Index = 0; Index < Half; ++Index) {
+    Re[Index] = In[2 * Index];
+    Im[Index] = In[2 * Index + 1];
+  }
+  Transform(&Plan->Half, Re, Im);
+  f32 Dc = Re[0];
+  f32 Nyquist = Im[0];
+  Re[0] = Dc + Nyquist;
+  Im[0] = 0;
+  Re[Half] = Dc - Nyquist;
+  Im[Half] = 0;
+  for (i32 Index = 1; Index <= Half / 2; ++Index) {
+    i32 Mirror = Half - Index;
+    f32 Er = 0.5f * (Re[Index] + Re[Mirror]);
+    f32 Ei = 0.5f * (Im[Index] - Im[Mirror]);
+    f32 Or = 0.5f * (Im[Index] + Im[Mirror]);
+    f32 Oi = 0.5f * (Re[Mirror] - Re[Index]);
+    f32 C = Plan->Cos[Index];
+    f32 S = Plan->Sin[Index];
+    f32 WOr = Or * C - Oi * S;
+    f32 WOi = Or * S + Oi * C;
+    Re[Index] = Er + WOr;
+    Im[Index] = Ei + WOi;
+    Re[Mirror] = Er - WOr;
+    Im[Mirror] = WOi - Ei;
+  }
+}
+
+// The forward transform backwards, without the factors of one half, which scales the result by Size
+void FftRealInverse(fft_real_plan* Plan, f32* Re, f32* Im, f32* Out) {
+  i32 Half = Plan->Size / 2;
+  f32 Dc = Re[0];
+  f32 Nyquist = Re[Half];
+  Re[0] = Dc + Nyquist;
+  Im[0] = Dc - Nyquist;
+  for (i32 Index = 1; Index <= Half / 2; ++Index) {
+    i32 Mirror = Half - Index;
+    f32 Er = Re[Index] + Re[Mirror];
+    f32 Ei = Im[Index] - Im[Mirror];
+    f32 Dr = Re[Index] - Re[Mirror];
+    f32 Di = Im[Index] + Im[Mirror];
+    f32 C = Plan->Cos[Index];
+    f32 S = Plan->Sin[Index];
+    f32 Or = Dr * C + Di * S;
+    f32 Oi = Di * C - Dr * S;
+    Re[Index] = Er - Oi;
+    Im[Index] = Ei + Or;
+    Re[Mirror] = Er + Oi;
+    Im[Mirror] = Or - Ei;
+  }
+  Transform(&Plan->Half, Im, Re);
+  for (i32 Index = 0; Index < Half; ++Index) {
+    Out[2 * Index] = Re[Index];
+    Out[2 * Index + 1] = Im[Index];
+  }
+}
+
+void FftRealPlanFree(fft_real_plan* Plan) {
+  FftPlanFree(&Plan->Half);
+  FftFree(Plan->Cos, Plan->Size / 4 + 1);
+  FftFree(Plan->Sin, Plan->Size / 4 + 1);
+  memset(Plan, 0, sizeof(fft_real_plan));
+}
+
+void FftMultiplyAccumulate(f32* restrict AccRe, f32* restrict AccIm, const f32* ARe, const f32* AIm, const f32* BRe, const f32* BIm, i32 Count) {
+  i32 Index = 0;
+#if defined(SIMD_WIDTH)
+  for (; Index + SIMD_WIDTH <= Count; Index += SIMD_WIDTH) {
+    simd_f32 Ar = SimdLoad(&ARe[Index]);
+    simd_f32 Ai = SimdLoad(&AIm[Index]);
+    simd_f32 Br = SimdLoad(&BRe[Index]);
+    simd_f32 Bi = SimdLoad(&BIm[Index]);
+    SimdStore(&AccRe[Index], SimdAdd(SimdLoad(&AccRe[Index]), SimdSub(SimdMul(Ar, Br), SimdMul(Ai, Bi))));
+    SimdStore(&AccIm[Index], SimdAdd(SimdLoad(&AccIm[Index]), SimdAdd(SimdMul(Ar, Bi), SimdMul(Ai, Br))));
+  }
+#endif
+  for (; Index < Count; ++Index) {
+    AccRe[Index] += ARe[Index] * BRe[Index] - AIm[Index] * BIm[Index];
+    AccIm[Index] += ARe[Index] * BIm[Index] + AIm[Index] * BRe[Index];
+  }
+}
+
+f32* FftAlloc(i32 Count) {
+  return M_AlignedCalloc(FFT_ALIGNMENT, sizeof(f32), Count);
+}
+
+void FftFree(f32* Buffer, i32 Count) {
+  if (Buffer) {
+    M_Free(Buffer, sizeof(f32) * Count);
+  }
+}
@@ -0,0 +1,251 @@
+// fft_bench.c
+// speed and accuracy of the fft, compared to a naive dft
+
+#define FFT_BENCH_TOLERANCE 1e-5  // Largest error relative to the rms of the spectrum (or the signal for round trips)
+#define FFT_BENCH_CHECK_BINS 64 // Bins compared against the double precision reference
+
+typedef struct fft_bench_args {
+  char* OutputPath;
+  i32 MinSize;
+  i32 MaxSize;
+  i32 NaiveMaxSize;
+  f32 Duration;
+} fft_bench_args;
+
+typedef struct fft_bench_buffers {
+  f32* Input;  // Real part of the complex input, and the input of the real transform
+  f32* InputIm;
+  f32* Re;
+  f32* Im;
+  f32* Out;
+  f32* Cos;  // Twiddles of the naive dft
+  f32* Sin;
+} fft_bench_buffers;
+
+static i64 BenchTime();
+static void NaiveDft(i32 Size, const f32* Cos, const f32* Sin, const f32* InRe, const f32* InIm, f32* OutRe, f32* OutIm);
+static f64 SpectrumError(i32 Size, i32 BinCount, const f32* InRe, const f32* InIm, const f32* Re, const f32* Im);
+static f64 RoundTripError(i32 Count, f32 Scale, const f32* Expected, const f32* Re);
+static i32 BenchSize(fft_bench_args* Args, fft_bench_buffers* Buffers, i32 Size, FILE* File);
+
+i64 BenchTime() {
+  struct timespec Time;
+  clock_gettime(CLOCK_MONOTONIC, &Time);
+  return (i64)Time.tv_sec * 1000000000 + Time.tv_nsec;
+}
+
+void NaiveDft(i32 Size, const f32* Cos, const f32* Sin, const f32* InRe, const f32* InIm, f32* OutRe, f32* OutIm) {
+  for (i32 Bin = 0; Bin < Size; ++Bin) {
+    f32 SumRe = 0;
+    f32 SumIm = 0;
+    for (i32 Index = 0; Index < Size; ++Index) {
+      i32 Twiddle = ((u32)Bin * Index) & (Size - 1);
+      SumRe += InRe[Index] * Cos[Twiddle] - InIm[Index] * Sin[Twiddle];
+      SumIm += InRe[Index] * Sin[Twiddle] + InIm[Index] * Cos[Twiddle];
+    }
+    OutRe[Bin] = SumRe;
+    OutIm[Bin] = SumIm;
+  }
+}
+
+// NOTE(lucas): The reference only covers a subset of the bins, which keeps the check fast at the largest sizes
+f64 SpectrumError(i32 Size, i32 BinCount, const f32* InRe, const f32* InIm, const f32* Re, const f32* Im) {
+  i32 Step = Max(BinCount / FFT_BENCH_CHECK_BINS, 1);
+  f64 MaxError = 0;
+  f64 Power = 0;
+  i32 Checked = 0;
+  for (i32 Bin = 0; Bin < BinCount; Bin += Step) {
+    f64 SumRe = 0;
+    f64 SumIm = 0;
+    for (i32 Index = 0; Index < Size; ++Index) {
+      f64 Angle = -2.0 * M_PI * (f64)(((i64)Bin * Index) % Size) / Size;
+      f64 Xr = InRe[Index];
+      f64 Xi = InIm ? InIm[Index] : 0;
+      SumRe += Xr * cos(Angle) - Xi * sin(Angle);
+      SumIm += Xr * sin(Angle) + Xi * cos(Angle);
+    }
+    f64 Error = hypot(Re[Bin] - SumRe, Im[Bin] - SumIm);
+    MaxError = Max(MaxError, Error);
+    Power += SumRe * SumRe + SumIm * SumIm;
+    ++Checked;
+  }
+  return MaxError / sqrt(Power / Checked);
+}
+
+f64 RoundTripError(i32 Count, f32 Scale, const f32* Expected, const f32* Re) {
+  f64 MaxError = 0;
+  f64 Power = 0;
+  for (i32 Index = 0; Index < Count; ++Index) {
+    MaxError = Max(MaxError, fabs(Scale * Re[Index] - Expected[Index]));
+    Power += (f64)Expected[Index] * Expected[Index];
+  }
+  return MaxError / sqrt(Power / Count);
+}
+
+// NOTE(lucas): Transforms run in place, so every run copies the input in first (which is timed)
+i32 BenchSize(fft_bench_args* Args, fft_bench_buffers* Buffers, i32 Size, FILE* File) {
+  i32 Result = NoError;
+  fft_plan Plan;
+  fft_real_plan RealPlan;
+  if (FftPlanInit(&Plan, Size) != NoError) {
+    return Error;
+  }
+  if (FftRealPlanInit(&RealPlan, Size) != NoError) {
+    FftPlanFree(&Plan);
+    return Error;
+  }
+  f32* Re = Buffers->Re;
+  f32* Im = Buffers->Im;
+  i64 Duration = (i64)(Args->Duration * 1e9);
+
+  memcpy(Re, Buffers->Input, sizeof(f32) * Size);
+  memcpy(Im, Buffers->InputIm, sizeof(f32) * Size);
+  FftForward(&Plan, Re, Im);
+  f64 ComplexError = SpectrumError(Size, Size, Buffers->Input, Buffers->InputIm, Re, Im);
+  FftInverse(&Plan, Re, Im);
+  f64 ComplexRoundTrip = Max(RoundTripError(Size, 1.0f / Size, Buffers->Input, Re), RoundTripError(Size, 1.0f / Size, Buffers->InputIm, Im));
+
+  FftRealForward(&RealPlan, Buffers->Input, Re, Im);
+  f64 RealError = SpectrumError(Size, Size / 2 + 1, Buffers->Input, NULL, Re, Im);
+  FftRealInverse(&RealPlan, Re, Im, Buffers->Out);
+  f64 RealRoundTrip = RoundTripError(Size, 1.0f / Size, Buffers->Input, Buffers->Out);
+
+  i64 Runs = 0;
+  i64 Start = BenchTime();
+  i64 Elapsed = 0;
+  do {
+    memcpy(Re, Buffers->Input, sizeof(f32) * Size);
+    memcpy(Im, Buffers->InputIm, sizeof(f32) * Size);
+    FftForward(&Plan, Re, Im);
+    ++Runs;
+  } while ((Elapsed = BenchTime() - Start) < Duration);
+  f64 ComplexNs = (f64)Elapsed / Runs;
+
+  Runs = 0;
+  Start = BenchTime();
+  do {
+    FftRealForward(&RealPlan, Buffers->Input, Re, Im);
+    ++Runs;
+  } while ((Elapsed = BenchTime() - Start) < Duration);
+  f64 RealNs = (f64)Elapsed / Runs;
+
+  f64 NaiveNs = 0;
+  if (Size <= Args->NaiveMaxSize) {
+    for (i32 Index = 0; Index < Size; ++Index) {
+      Buffers->Cos[Index] = (f32)cos(-2.0 * M_PI * Index / Size);
+      Buffers->Sin[Index] = (f32)sin(-2.0 * M_PI * Index / Size);
+    }
+    Runs = 0;
+    Start = BenchTime();
+    do {
+      NaiveDft(Size, Buffers->Cos, Buffers->Sin, Buffers->Input, Buffers->InputIm, Re, Buffers->Out);
+      ++Runs;
+    } while ((Elapsed = BenchTime() - Start) < Duration);
+    NaiveNs = (f64)Elapsed / Runs;
+  }
+
+  i32 Log2Size = Plan.Log2Size;
+  f64 Mflops = 5.0 * Size * Log2Size / ComplexNs * 1e3;
+  u8 Pass = ComplexError < FFT_BENCH_TOLERANCE && ComplexRoundTrip < FFT_BENCH_TOLERANCE && RealError < FFT_BENCH_TOLERANCE && RealRoundTrip < FFT_BENCH_TOLERANCE;
+  if (!Pass) {
+    Result = Error;
+  }
+  // NOTE(lucas): Sizes above the naive max size have no naive timing, shown as '-'
+  char NaiveField[32] = "";
+  char SpeedupField[32] = "";
+  char NaiveText[32] = "-";
+  char SpeedupText[32] = "-";
+  if (NaiveNs > 0) {
+    snprintf(NaiveField, sizeof(NaiveField), "%.1f", NaiveNs);
+    snprintf(SpeedupField, sizeof(SpeedupField), "%.2f", NaiveNs / ComplexNs);
+    snprintf(SpeedupText, sizeof(SpeedupText), "%.1fx", NaiveNs / ComplexNs);
+    snprintf(NaiveText, sizeof(NaiveText), "%.1f", NaiveNs);
+  }
+  fprintf(File, "%i,%.1f,%.1f,%s,%s,%.1f,%.3e,%.3e,%.3e,%.3e,%i\n", Size, ComplexNs, RealNs, NaiveField, SpeedupField, Mflops, ComplexError, ComplexRoundTrip, RealError, RealRoundTrip, Pass);
+  fflush(File);
+  fprintf(stdout, "%6i | %10.1f | %10.1f | %12s | %9s | %7.0f | %9.2e | %9.2e | %9.2e | %9.2e | %s\n", Size, ComplexNs, RealNs, NaiveText, SpeedupText, Mflops, ComplexError, ComplexRoundTrip, RealError, RealRoundTrip, Pass ? "ok" : "FAILED");
+
+  FftRealPlanFree(&RealPlan);
+  FftPlanFree(&Plan);
+  return Result;
+}
+
+i32 BenchFft(i32 argc, char** argv) {
+  i32 Result = NoError;
+
+  fft_bench_args Args = {
+    .OutputPath = "bench_fft.csv",
+    .MinSize = 64,
+    .MaxSize = FFT_MAX_SIZE,
+    .NaiveMaxSize = 4096,
+    .Duration = 0.05f,
+  };
+
+  parse_arg Arguments[] = {
+    {'o', "output-path", "path to the CSV file to write the results to (default: bench_fft.csv)", ArgString, 1, &Args.OutputPath},
+    {'s', "min-size", "smallest transform size (default: 64)", ArgInt, 1, &Args.MinSize},
+    {'m', "max-size", "largest transform size (default: 65536)", ArgInt, 1, &Args.MaxSize},
+    {'n', "naive-max-size", "largest size to time the naive DFT at (default: 4096)", ArgInt, 1, &Args.NaiveMaxSize},
+    {'t', "time", "seconds to run every transform for (default: 0.05)", ArgFloat, 1, &Args.Duration},
+  };
+  Result = ParseArgs(Arguments, ArraySize(Arguments), argc, argv);
+  if (Result == Error) {
+    return Result;
+  }
+  else if (Result == HelpStatus) {
+    return NoError;
+  }
+  if (Args.MinSize < 2 * FFT_MIN_SIZE || Args.MaxSize > FFT_MAX_SIZE || Args.MinSize > Args.MaxSize || Args.Duration <= 0) {
+    fprintf(stderr, "Invalid benchmark arguments\n");
+    return Error;
+  }
+  FILE* File = fopen(Args.OutputPath, "w");
+  if (!File) {
+    fprintf(stderr, "Failed to open '%s'\n", Args.OutputPath);
+    return Error;
+  }
+
+  i32 Capacity = Args.MaxSize;
+  fft_bench_buffers Buffers = {
+    .Input = FftAlloc(Capacity),
+    .InputIm = FftAlloc(Capacity),
+    .Re = FftAlloc(Capacity + 1),
+    .Im = FftAlloc(Capacity + 1),
+    .Out = FftAlloc(Capacity),
+    .Cos = FftAlloc(Capacity),
+    .Sin = FftAlloc(Capacity),
+  };
+  if (Buffers.Input && Buffers.InputIm && Buffers.Re && Buffers.Im && Buffers.Out && Buffers.Cos && Buffers.Sin) {
+    u32 Seed = 1;
+    for (i32 Index = 0; Index < Capacity; ++Index) {
+      Seed = Seed * 1664525u + 1013904223u;
+      Buffers.Input[Index] = (f32)(Seed >> 8) / (1 << 23) - 1.0f;
+      Seed = Seed * 1664525u + 1013904223u;
+      Buffers.InputIm[Index] = (f32)(Seed >> 8) / (1 << 23) - 1.0f;
+    }
+    fprintf(File, "size,complex_ns,real_ns,naive_ns,speedup,complex_mflops,complex_error,complex_roundtrip_error,real_error,real_roundtrip_error,pass\n");
+    fprintf(stdout, "%6s | %10s | %10s | %12s | %9s | %7s | %9s | %9s | %9s | %9s |\n", "SIZE", "COMPLEX NS", "REAL NS", "NAIVE NS", "SPEEDUP", "MFLOPS", "ERROR", "ROUNDTRIP", "REAL ERR", "REAL RT");
+    for (i32 Size = 1; Size <= Args.MaxSize; Size *= 2) {
+      if (Size >= Args.MinSize && BenchSize(&Args, &Buffers, Size, File) != NoError) {
+        Result = Error;
+      }
+    }
+    fprintf(stdout, "Wrote results to '%s'\n", Args.OutputPath);
+    if (Result != NoError) {
+      fprintf(stderr, "Some of the transforms are less accurate than %g\n", FFT_BENCH_TOLERANCE);
+    }
+  }
+  else {
+    Result = Error;
+  }
+
+  FftFree(Buffers.Input, Capacity);
+  FftFree(Buffers.InputIm, Capacity);
+  FftFree(Buffers.Re, Capacity + 1);
+  FftFree(Buffers.Im, Capacity + 1);
+  FftFree(Buffers.Out, Capacity);
+  FftFree(Buffers.Cos, Capacity);
+  FftFree(Buffers.Sin, Capacity);
+  fclose(File);
+  return Result;
+}
@@ -12,8 +12,11 @@ void* LoadThread(void* Instrument) {
   if (Ins->Init) {
     Ins->Init(Ins);
   }
+  // NOTE(lucas): Nobody joins the load thread, and leaked threads add up quickly with thousands of buses
+  pthread_detach(pthread_self());
   Ins->Ready = 1;
-  pthread_join(Ins->LoadThread, NULL);
+  atomic_fetch_add(&InsHandler.Loaded.Value, 1);
+  WaitWordWake(&InsHandler.Loaded, INT32_MAX);
 
   TIMER_END();
   return NULL;
@@ -28,8 +31,9 @@ void* UnloadThread(void* Instrument) {
   BufferFree(&Ins->UserData);
   M_Free(Ins, sizeof(instrument));
 
-  Ins->Ready = 1;
-  pthread_join(Ins->LoadThread, NULL);
+  // NOTE(lucas): The instrument is gone by now, nobody is going to join this thread
+  pthread_detach(pthread_self());
+  atomic_fetch_sub(&InsHandler.UnloadCount, 1);
 
   TIMER_END();
   return NULL;
@@ -42,13 +46,17 @@ instrument* InstrumentCreate(instrument_def_type Type) {
       instrument_def* InsDef = &InsHandler.Instruments[Type];
       Ins->UserData.Data = NULL;
       Ins->UserData.Count = 0;
+      Ins->Type = Type;
       Ins->Init = InsDef->Init;
       Ins->Destroy = InsDef->Destroy;
       Ins->Draw = InsDef->Draw;
       Ins->Process = InsDef->Process;
       if (Ins->Init) {
         Ins->Ready = 0;
-        pthread_create(&Ins->LoadThread, NULL, LoadThread, (void*)Ins);
+        if (pthread_create(&Ins->LoadThread, NULL, LoadThread, (void*)Ins) != 0) {
+          Ins->Init(Ins);
+          Ins->Ready = 1;
+        }
       }
       else {
         Ins->Ready = 1;
@@ -63,6 +71,17 @@ instrument* InstrumentCreate(instrument_def_type Type) {
   return NULL;
 }
 
+// Returns the instrument definition type which has the given name, or -1 if there is no such instrument definition
+i32 InstrumentFindDef(const char* Name, u32 Length) {
+  for (u32 InstrumentIndex = 0; InstrumentIndex < InsHandler.InstrumentCount; ++InstrumentIndex) {
+    instrument_def* InsDef = &InsHandler.Instruments[InstrumentIndex];
+    if (strlen(InsDef->Name) == Length && !strncmp(InsDef->Name, Name, Length)) {
+      return InstrumentIndex;
+    }
+  }
+  return -1;
+}
+
 i32 InstrumentAllocUserData(instrument* Ins, i32 Size) {
   i32 Result = NoError;
   void* Data = M_Calloc(Size, 1);
@@ -90,11 +109,19 @@ i32 InstrumentDraw(instrument* Ins) {
 void InstrumentFree(instrument* Ins) {
   Assert(Ins != NULL);
   Ins->Ready = 0;
-  pthread_create(&Ins->LoadThread, NULL, UnloadThread, (void*)Ins);
+  atomic_fetch_add(&InsHandler.UnloadCount, 1);
+  if (pthread_create(&Ins->LoadThread, NULL, UnloadThread, (void*)Ins) != 0) {
+    InstrumentDestroy(Ins);
+    BufferFree(&Ins->UserData);
+    M_Free(Ins, sizeof(instrument));
+    atomic_fetch_sub(&InsHandler.UnloadCount, 1);
+  }
 }
 
 i32 InstrumentHandlerInit() {
   InsHandler.InstrumentCount = MAX_INSTRUMENT_DEF;
+  atomic_init(&InsHandler.UnloadCount, 0);
+  WaitWordInit(&InsHandler.Loaded, 0);
   InsHandler.Instruments = M_Malloc(sizeof(instrument_def) * MAX_INSTRUMENT_DEF);
   instrument_def* InsDef = &InsHandler.Instruments[0];
   *InsDef++ = (instrument_def) {"Oscillator Test", OscTestInit, OscTestFree, NULL, OscTestProcess};
@@ -103,7 +130,12 @@ i32 InstrumentHandlerInit() {
   return NoError;
 }
 
+// Waits for all instruments to be unloaded
 void InstrumentHandlerFree() {
+  while (atomic_load(&InsHandler.UnloadCount) > 0) {
+    sleep(0);
+  }
   M_Free(InsHandler.Instruments, sizeof(instrument_def) * InsHandler.InstrumentCount);
   InsHandler.InstrumentCount = 0;
+  WaitWordFree(&InsHandler.Loaded);
 }
@@ -1,36 +1,38 @@
 // memory.c
 // tracks basic memory information
 
+// NOTE(lucas): Instruments are loaded and free'd on threads of their own, so the counters are atomic
 struct {
-  i64 Total;
-  i64 Blocks;
+  _Atomic i64 Total;
+  _Atomic i64 Blocks;
 } MemoryInfo = {
   .Total = 0,
   .Blocks = 0,
 };
 
 #define MemoryInfoUpdate(AddTotal, AddNumBlocks) \
-  MemoryInfo.Total += (AddTotal); \
-  MemoryInfo.Blocks += (AddNumBlocks)
+  atomic_fetch_add_explicit(&MemoryInfo.Total, (AddTotal), memory_order_relaxed); \
+  atomic_fetch_add_explicit(&MemoryInfo.Blocks, (AddNumBlocks), memory_order_relaxed)
 
 i64 MemoryTotal() {
-  return MemoryInfo.Total;
+  return atomic_load(&MemoryInfo.Total);
 }
 
 i64 MemoryNumBlocks() {
-  return MemoryInfo.Blocks;
+  return atomic_load(&MemoryInfo.Blocks);
 }
 
 void MemoryPrintInfo(FILE* File) {
   fprintf(File,
     "Memory info:\n  Allocated blocks: %ld, Total: %g MB (%ld bytes)\n",
-    MemoryInfo.Blocks,
-    MemoryInfo.Total / (1024.0f * 1024.0f),
-    MemoryInfo.Total
+    MemoryNumBlocks(),
+    MemoryTotal() / (1024.0f * 1024.0f),
+    MemoryTotal()
   );
 }
 
 void* M_Malloc(const i32 Size) {
+  RtCheck("M_Malloc");
   void* Data = malloc(Size);
   if (!Data)
     return NULL;
@@ -39,6 +41,7 @@ void* M_Malloc(const i32 Size) {
 }
 
 void* M_Calloc(const i32 Size, const i32 Count) {
+  RtCheck("M_Calloc");
   void* Data = calloc(Size, Count);
   if (!Data)
     return NULL;
@@ -46,7 +49,18 @@ void* M_Calloc(const i32 Size, const i32 Count) {
   return Data;
 }
 
+void* M_AlignedCalloc(const i32 Alignment, const i32 Size, const i32 Count) {
+  RtCheck("M_AlignedCalloc");
+  void* Data = NULL;
+  if (posix_memalign(&Data, Alignment, Size * Count) != 0)
+    return NULL;
+  memset(Data, 0, Size * Count);
+  MemoryInfoUpdate(Size * Count, 1);
+  return Data;
+}
+
 void* M_Realloc(void* Data, const i32 OldSize, const i32 NewSize) {
+  RtCheck("M_Realloc");
   if (!Data) {
     return M_Malloc(NewSize);
   }
@@ -59,7 +73,36 @@ void* M_Realloc(void* Data, const i32 OldSize, const i32 NewSize) {
 }
 
 void M_Free(void* Data, const i32 Size) {
+  RtCheck("M_Free");
   assert(Data);
   free(Data);
   MemoryInfoUpdate(-Size, -1);
 }
+
+i32 ArenaInit(memory_arena* Arena, const i32 Size) {
+  Arena->Data = M_AlignedCalloc(ARENA_ALIGNMENT, 1, Size);
+  Arena->Size = Arena->Data ? Size : 0;
+  atomic_init(&Arena->Used, 0);
+  return Arena->Data ? NoError : Error;
+}
+
+void* ArenaPush(memory_arena* Arena, const i32 Size) {
+  i32 AlignedSize = (Size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+  i32 Offset = atomic_fetch_add_explicit(&Arena->Used, AlignedSize, memory_order_relaxed);
+  if (Offset + AlignedSize > Arena->Size) {
+    return NULL;
+  }
+  return &Arena->Data[Offset];
+}
+
+void ArenaReset(memory_arena* Arena) {
+  atomic_store_explicit(&Arena->Used, 0, memory_order_relaxed);
+}
+
+void ArenaFree(memory_arena* Arena) {
+  if (Arena->Data) {
+    M_Free(Arena->Data, Arena->Size);
+  }
+  Arena->Data = NULL;
+  Arena->Size = 0;
+}
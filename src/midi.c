@@ -2,9 +2,9 @@
 
 midi_handle MidiHandles[MAX_MIDI_HANDLE] = {
   {"Null MIDI"},
-  {"Serial MIDI", MidiSerialInit, MidiSerialFetchEvents, MidiSerialOpenDevices, MidiSerialCloseDevices},
+  {"Serial MIDI", MidiSerialInit, MidiSerialOpenDevices, MidiSerialCloseDevices},
 #if __APPLE__
-  {"Core MIDI", MidiAppleInit, MidiAppleFetchEvents, MidiAppleOpenDevices, MidiAppleCloseDevices},
+  {"Core MIDI", MidiAppleInit, MidiAppleOpenDevices, MidiAppleCloseDevices},
 #else
   {"Core MIDI (not avaliable on your system)"},
 #endif
@@ -13,6 +13,9 @@ midi_handle MidiHandles[MAX_MIDI_HANDLE] = {
 midi_handle MidiHandle;
 u8 MidiHandleInitialized = 0;
 
+// Events go straight from the thread of the MIDI backend to the audio thread
+static spsc_queue MidiQueue = {0};
+
 i32 MidiInitHandle(midi_handle_type HandleType) {
   if (HandleType >= 0 && HandleType < MAX_MIDI_HANDLE) {
     MidiHandle = MidiHandles[HandleType];
@@ -24,14 +27,39 @@ i32 MidiInitHandle(midi_handle_type HandleType) {
 }
 
 i32 MidiInit() {
+  i32 Result = NoError;
+  if ((Result = SpscQueueInit(&MidiQueue, sizeof(midi_timed_event), MIDI_QUEUE_SIZE)) != NoError) {
+    return Result;
+  }
   CALL(MidiHandle.Init);
   return NoError;
 }
 
-u32 MidiFetchEvents(midi_event* Dest) {
-  if (MidiHandle.FetchEvents)
-    return MidiHandle.FetchEvents(Dest);
-  return 0;
+// Nanoseconds on the monotonic clock
+i64 MidiTime() {
+  struct timespec Time;
+  clock_gettime(CLOCK_MONOTONIC, &Time);
+  return (i64)Time.tv_sec * 1000000000 + Time.tv_nsec;
+}
+
+// Called by the MIDI backend from a single thread, events are dropped if the audio thread doesn't keep up
+void MidiPushEvent(midi_event Event) {
+  midi_timed_event TimedEvent = (midi_timed_event) {
+    .Event = Event,
+    .Time = MidiTime(),
+  };
+  if (MidiQueue.Data) {
+    SpscQueuePush(&MidiQueue, &TimedEvent);
+  }
+}
+
+// Called by the audio thread, events come out in order of arrival
+u32 MidiFetchEvents(midi_timed_event* Dest, u32 MaxCount) {
+  u32 Count = 0;
+  while (Count < MaxCount && SpscQueuePop(&MidiQueue, &Dest[Count])) {
+    ++Count;
+  }
+  return Count;
 }
 
 i32 MidiOpenDevices() {
@@ -42,3 +70,8 @@ i32 MidiOpenDevices() {
 void MidiCloseDevices() {
   CALL(MidiHandle.CloseDevices);
 }
+
+// NOTE(lucas): The devices have to be closed, and the audio thread stopped, before the queue can be free'd
+void MidiFree() {
+  SpscQueueFree(&MidiQueue);
+}
@@ -25,9 +25,6 @@ typedef struct midi_apple_state {
   midi_source_port SourcePorts[MAX_SOURCE_PORT];
   u32 SourcePortCount;
 
-  midi_event MidiEvents[MAX_MIDI_EVENT];
-  u32 EventCount;
-
   MIDIClientRef Client;
 } midi_apple_state;
 
@@ -40,7 +37,6 @@ static void ReadCallback(const MIDIPacketList* PacketList, void* ReadRefCon, voi
 static i32 AddInputDevice(MIDIEndpointRef InputDevice, buffer Name);
 static i32 AddSourcePort(MIDIEndpointRef InputDevice, MIDIPortRef Port);
 static i32 OpenMidiReference(MIDIEndpointRef Device, buffer Name, u8 IsInput);
-static void PushMidiEvent(midi_event Event);
 
 i32 GetDeviceName(MIDIObjectRef Object, buffer* Buffer) {
   CFStringRef Name = NULL;
@@ -123,7 +119,7 @@ void ReadCallback(const MIDIPacketList* PacketList, void* ReadRefCon, void* Sour
           Event.Message = Command;
           Event.A = A;
           Event.B = B;
-          PushMidiEvent(Event);
+          MidiPushEvent(Event);
           break;
         }
         case 0:
@@ -179,30 +175,13 @@ i32 OpenMidiReference(MIDIEndpointRef Device, buffer Name, u8 IsInput) {
   return NoError;
 }
 
-void PushMidiEvent(midi_event Event) {
-  if (MidiApple.EventCount < MAX_MIDI_EVENT) {
-    MidiApple.MidiEvents[MidiApple.EventCount++] = Event;
-  }
-}
-
 i32 MidiAppleInit() {
   MidiApple.InputDeviceCount = 0;
   MidiApple.SourcePortCount = 0;
-  MidiApple.EventCount = 0;
   MidiApple.Client = 0;
   return NoError;
 }
 
-u32 MidiAppleFetchEvents(midi_event* Dest) {
-  u32 Count = MidiApple.EventCount;
-  for (u32 EventIndex = 0; EventIndex < MidiApple.EventCount; ++EventIndex) {
-    midi_event Event = MidiApple.MidiEvents[EventIndex];
-    Dest[EventIndex] = Event;
-  }
-  MidiApple.EventCount = 0;
-  return Count;
-}
-
 i32 MidiAppleOpenDevices() {
   i32 Result = NoError;
 
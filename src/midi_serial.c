@@ -6,10 +6,7 @@
 #include <dirent.h>
 
 typedef struct serial_midi_state {
-  pthread_mutex_t Mutex;
   pthread_t ReadThread;
-  midi_event MidiEvents[MAX_MIDI_EVENT];
-  u32 EventCount;
   i32 Fd;
   u8 HasInitialized;
   u8 ShouldExit;
@@ -20,37 +17,27 @@ static serial_midi_state SerialMidi = {0};
 static void* SerialRead(void* State);
 static i32 ReadEvent(i32 Fd, midi_event* Event);
 
+// NOTE(lucas): Events are handed over as soon as they have been read, so that they are timestamped on arrival
 void* SerialRead(void* State) {
   serial_midi_state* Serial = (serial_midi_state*)State;
-  u32 ReadEvents = 0;
-  const u32 MaxReadEvents = 32;
+  midi_event Event;
   while (!Serial->ShouldExit) {
-    if (pthread_mutex_trylock(&Serial->Mutex)) {
-      midi_event Event;
-      while (Serial->EventCount < MAX_MIDI_EVENT && ReadEvents < MaxReadEvents && !Serial->ShouldExit) {
-        if (ReadEvent(Serial->Fd, &Event)) {
-          Serial->MidiEvents[Serial->EventCount++] = Event;
-          ReadEvents++;
-        }
-        else {
-          break;
-        }
-      }
-      ReadEvents = 0;
-      pthread_mutex_unlock(&Serial->Mutex);
+    if (ReadEvent(Serial->Fd, &Event)) {
+      MidiPushEvent(Event);
+    }
+    else {
+      sleep(0);
     }
-    sleep(0);
   }
   return NULL;
 }
 
 i32 ReadEvent(i32 Fd, midi_event* Event) {
+  Event->Data = 0;
   return (read(Fd, &Event->Data, 3)) == 3;
 }
 
 i32 MidiSerialInit() {
-  SerialMidi.Mutex = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
-  SerialMidi.EventCount = 0;
   SerialMidi.Fd = -1;
   SerialMidi.HasInitialized = 1;
   SerialMidi.ShouldExit = 0;
@@ -82,26 +69,6 @@ i32 MidiSerialOpenDevices() {
   return Result;
 }
 
-u32 MidiSerialFetchEvents(midi_event* Dest) {
-  u32 Count = 0;
-
-  serial_midi_state* Serial = &SerialMidi;
-
-  if (Serial->Fd < 0) {
-    return 0;
-  }
-
-  if (pthread_mutex_trylock(&Serial->Mutex)) {
-    for (u32 EventIndex = 0; EventIndex < Serial->EventCount; ++EventIndex) {
-      Dest[EventIndex] = Serial->MidiEvents[EventIndex];
-    }
-    Count = Serial->EventCount;
-    Serial->EventCount = 0;
-    pthread_mutex_unlock(&Serial->Mutex);
-  }
-  return Count;
-}
-
 i32 OpenSerial(const char* Device) {
   Assert(SerialMidi.HasInitialized == 1);
   i32 Flags = O_RDWR | O_NOCTTY | O_NDELAY | O_NONBLOCK;
@@ -122,9 +89,12 @@ void CloseSerial() {
   pthread_join(SerialMidi.ReadThread, NULL);
   if (SerialMidi.Fd >= 0) {
     close(SerialMidi.Fd);
+    SerialMidi.Fd = -1;
   }
 }
 
 void MidiSerialCloseDevices() {
-
+  if (SerialMidi.Fd >= 0) {
+    CloseSerial();
+  }
 }
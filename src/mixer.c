@@ -1,295 +1,1013 @@
 // mixer.c
 
 #define MASTER_BUS_INDEX 0
-#define MASTER_CHANNEL_COUNT 2
+#define MASTER_BUS_HANDLE ((bus_handle)0)
+#define MASTER_CHANNEL_COUNT MAX_BUS_CHANNEL
+#define MIX_BATCH_SIZE 64
+#define INSERT_FADE_CHUNK 128 // Frames faded at a time while an insert is being enabled or bypassed
+#define EQ_GAIN_STEP 3.0f // dB that an eq band is raised by per click in the inserts view, it wraps around at the range
+#define EQ_GAIN_RANGE 12.0f
 
-static void FreeBus(mixer* Mixer, bus* Bus);
-static i32 RemoveBus(mixer* Mixer, i32 BusIndex);
+static bus* BusInSlot(bus_store* Store, u32 Slot);
+static bus_handle AllocBus(bus_store* Store);
+static void ReleaseBus(bus_store* Store, bus_handle Handle);
+static void FreeBusStore(bus_store* Store);
+static void FreeGarbage(mixer_garbage* Garbage);
+static void RemoveBus(mixer* Mixer, bus* Bus);
+static void DiscardInstrument(mixer* Mixer, instrument* Ins);
+static i32 PushCommand(mixer* Mixer, mixer_command* Command);
+static i32 CheckRouting(mixer* Mixer);
+static void ResolvePlan(mixer* Mixer);
+static void InitMeter(bus_meter* Meter);
+static f32 AmplitudeToDb(f32 Amplitude);
+static void MeterBus(bus* Bus, i32 FramesPerBuffer);
+static void UpdateMeterView(meter_view* View, v2 Peak, f32 DeltaTime);
+static void InitProfile(bus_profile* Profile);
+static void PublishProfile(mixer* Mixer, mixer_plan* Plan);
+static void RecordBus(mixer* Mixer, bus* Bus, bus_handle Handle);
+static void ProcessInserts(bus* Bus, i32 FrameCount);
+static void ProcessNode(mixer* Mixer, i32 NodeIndex);
+static void ProcessNodeJob(void* Data, i32 JobIndex);
 
-void FreeBus(mixer* Mixer, bus* Bus) {
-  if (Bus->InternalBuffer) {
-    M_Free(Bus->Buffer, sizeof(f32) * Bus->ChannelCount * Mixer->FramesPerBuffer);
+bus* BusInSlot(bus_store* Store, u32 Slot) {
+  bus* Chunk = Store->Chunks[Slot / BUS_CHUNK_SIZE];
+  return Chunk ? &Chunk[Slot % BUS_CHUNK_SIZE] : NULL;
+}
+
+// Runs on the UI thread. The first bus in a slot gets generation 0, which gives the master bus handle 0
+bus_handle AllocBus(bus_store* Store) {
+  u32 Slot = 0;
+  if (Store->FreeCount > 0) {
+    Slot = Store->FreeSlots[--Store->FreeCount];
   }
-  if (Bus->Ins) {
-    InstrumentFree(Bus->Ins);
+  else {
+    if (Store->SlotCount >= MAX_AUDIO_BUS) {
+      return BUS_HANDLE_NONE;
+    }
+    Slot = Store->SlotCount++;
+    if (Slot / BUS_CHUNK_SIZE >= (u32)Store->ChunkCount) {
+      i32 SlotCapacity = Store->ChunkCount * BUS_CHUNK_SIZE;
+      bus* Chunk = M_Calloc(sizeof(bus), BUS_CHUNK_SIZE);
+      for (i32 Index = 0; Index < BUS_CHUNK_SIZE; ++Index) {
+        atomic_init(&Chunk[Index].Handle, BUS_HANDLE_NONE);
+      }
+      Store->Generations = M_Realloc(Store->Generations, sizeof(u16) * SlotCapacity, sizeof(u16) * (SlotCapacity + BUS_CHUNK_SIZE));
+      Store->FreeSlots = M_Realloc(Store->FreeSlots, sizeof(u32) * SlotCapacity, sizeof(u32) * (SlotCapacity + BUS_CHUNK_SIZE));
+      memset(&Store->Generations[SlotCapacity], 0, sizeof(u16) * BUS_CHUNK_SIZE);
+      Store->Chunks[Store->ChunkCount++] = Chunk;
+    }
   }
+  return MakeBusHandle(Slot, Store->Generations[Slot]++);
+}
+
+void ReleaseBus(bus_store* Store, bus_handle Handle) {
+  Store->FreeSlots[Store->FreeCount++] = BusHandleSlot(Handle);
 }
 
-i32 RemoveBus(mixer* Mixer, i32 BusIndex) {
-  if (BusIndex > MASTER_BUS_INDEX && BusIndex < Mixer->BusCount) {
-    bus* Bus = &Mixer->Buses[BusIndex];
-    if (Bus == Mixer->FocusedBus) {
-      Mixer->FocusedBus = NULL;
+void FreeBusStore(bus_store* Store) {
+  i32 SlotCapacity = Store->ChunkCount * BUS_CHUNK_SIZE;
+  for (i32 ChunkIndex = 0; ChunkIndex < Store->ChunkCount; ++ChunkIndex) {
+    M_Free(Store->Chunks[ChunkIndex], sizeof(bus) * BUS_CHUNK_SIZE);
+    Store->Chunks[ChunkIndex] = NULL;
+  }
+  if (SlotCapacity > 0) {
+    M_Free(Store->Generations, sizeof(u16) * SlotCapacity);
+    M_Free(Store->FreeSlots, sizeof(u32) * SlotCapacity);
+  }
+  Store->Generations = NULL;
+  Store->FreeSlots = NULL;
+  Store->ChunkCount = Store->SlotCount = Store->FreeCount = 0;
+}
+
+void FreeGarbage(mixer_garbage* Garbage) {
+  if (Garbage->Ins) {
+    InstrumentFree(Garbage->Ins);
+  }
+  for (i32 Index = 0; Index < (i32)ArraySize(Garbage->Effects); ++Index) {
+    EffectDestroy(Garbage->Effects[Index]);
+  }
+}
+
+// Called on the audio thread, which makes sure that there is room in the garbage queue
+void RemoveBus(mixer* Mixer, bus* Bus) {
+  mixer_garbage Garbage = (mixer_garbage) {
+    .Ins = Bus->Ins,
+    .Bus = atomic_load_explicit(&Bus->Handle, memory_order_relaxed),
+  };
+  for (i32 SlotIndex = 0; SlotIndex < MAX_INSERT_SLOT; ++SlotIndex) {
+    insert_slot* Slot = &Bus->Inserts[SlotIndex];
+    for (i32 Channel = 0; Channel < MAX_BUS_CHANNEL; ++Channel) {
+      Garbage.Effects[SlotIndex * MAX_BUS_CHANNEL + Channel] = Slot->Effects[Channel];
+      Slot->Effects[Channel] = NULL;
     }
-    FreeBus(Mixer, Bus);
-    --Mixer->BusCount;
-    if (Mixer->BusCount > 0) {
-      bus* Top = &Mixer->Buses[Mixer->BusCount];
-      if (Mixer->FocusedBus == Top) {
-        Mixer->FocusedBus = Bus;
-      }
-      *Bus = Mixer->Buses[Mixer->BusCount];
+  }
+  atomic_store_explicit(&Bus->Handle, BUS_HANDLE_NONE, memory_order_release);
+  Bus->Ins = NULL;
+  u8 Pushed = SpscQueuePush(&Mixer->Garbage, &Garbage);
+  Assert(Pushed);
+  (void)Pushed;
+  Mixer->ResolveNeeded = 1;
+}
+
+// NOTE(lucas): For instruments that never made it to the audio thread, the ones still loading are left to MixerUpdate
+void DiscardInstrument(mixer* Mixer, instrument* Ins) {
+  mixer_garbage Garbage = (mixer_garbage) {
+    .Ins = Ins,
+    .Bus = BUS_HANDLE_NONE,
+  };
+  if (!Ins->Ready) {
+    if (Mixer->PendingCount < MIXER_QUEUE_SIZE) {
+      Mixer->Pending[Mixer->PendingCount++] = Garbage;
+      return;
+    }
+    while (!Ins->Ready) {
+      sleep(0);
     }
   }
+  FreeGarbage(&Garbage);
+}
+
+i32 PushCommand(mixer* Mixer, mixer_command* Command) {
+  if (!SpscQueuePush(&Mixer->Commands, Command)) {
+    fprintf(stderr, "Mixer command queue is full\n");
+    return Error;
+  }
   return NoError;
 }
 
+// Routing changes are made directly on the graph, and undone by the caller if they make it cyclic
+i32 CheckRouting(mixer* Mixer) {
+  if (MixerGraphCompile(&Mixer->Graph, NULL) != NoError) {
+    return Error;
+  }
+  Mixer->Graph.Dirty = 1;
+  return NoError;
+}
+
+// Buses that the plan refers to but that haven't been added yet are left out
+void ResolvePlan(mixer* Mixer) {
+  mixer_plan* Plan = &Mixer->Plans[atomic_load_explicit(&Mixer->PlanIndex, memory_order_relaxed)];
+  for (i32 NodeIndex = 0; NodeIndex < Plan->NodeCount; ++NodeIndex) {
+    plan_node* Node = &Plan->Nodes[NodeIndex];
+    bus* Bus = MixerFindBus(Mixer, Node->Handle);
+    if (Bus && Bus->InternalBuffer) {
+      Bus->Buffer = Node->BufferIndex >= 0 ? Plan->Buffers[Node->BufferIndex] : NULL;
+    }
+    Plan->Resolved[NodeIndex] = Bus;
+  }
+  Mixer->ResolveNeeded = 0;
+}
+void InitMeter(bus_meter* Meter) {
+  atomic_init(&Meter->Sequence, 0);
+  for (i32 Channel = 0; Channel < 2; ++Channel) {
+    atomic_init(&Meter->Peak[Channel], DB_MIN);
+    atomic_init(&Meter->Rms[Channel], DB_MIN);
+  }
+}
+
+f32 AmplitudeToDb(f32 Amplitude) {
+  f32 Db = Amplitude > 0.0f ? 20.0f * log10f(Amplitude) : DB_MIN;
+  return Db > DB_MIN ? Db : DB_MIN;
+}
+
+// NOTE(lucas): The dB conversion is paid once per block rather than once per sample
+void MeterBus(bus* Bus, i32 FramesPerBuffer) {
+  bus_meter* Meter = &Bus->Meter;
+  f32 Peak[2];
+  f32 Power[2];
+  for (i32 Channel = 0; Channel < Bus->ChannelCount; ++Channel) {
+    MeasureFloatBuffer(&Bus->Buffer[Channel * Bus->Stride], FramesPerBuffer, &Peak[Channel], &Power[Channel]);
+  }
+  if (Bus->ChannelCount == 1) {
+    Peak[1] = Peak[0];
+    Power[1] = Power[0];
+  }
+  u32 Sequence = atomic_load_explicit(&Meter->Sequence, memory_order_relaxed);
+  atomic_store_explicit(&Meter->Sequence, Sequence + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  for (i32 Channel = 0; Channel < 2; ++Channel) {
+    atomic_store_explicit(&Meter->Peak[Channel], AmplitudeToDb(Peak[Channel]), memory_order_relaxed);
+    atomic_store_explicit(&Meter->Rms[Channel], AmplitudeToDb(sqrtf(Power[Channel])), memory_order_relaxed);
+  }
+  atomic_store_explicit(&Meter->Sequence, Sequence + 2, memory_order_release);
+}
+
+void UpdateMeterView(meter_view* View, v2 Peak, f32 DeltaTime) {
+  f32 Decay = METER_DECAY_RATE * DeltaTime;
+  f32* Level = &View->Level.L;
+  f32* PeakHold = &View->PeakHold.L;
+  f32* HoldTime = &View->HoldTime.L;
+  f32* Current = &Peak.L;
+  for (i32 Channel = 0; Channel < 2; ++Channel) {
+    Level[Channel] = Max(Current[Channel], Level[Channel] - Decay);
+    if (Current[Channel] >= PeakHold[Channel]) {
+      PeakHold[Channel] = Current[Channel];
+      HoldTime[Channel] = METER_HOLD_TIME;
+    }
+    else if (HoldTime[Channel] > 0.0f) {
+      HoldTime[Channel] -= DeltaTime;
+    }
+    else {
+      PeakHold[Channel] = Max(Current[Channel], PeakHold[Channel] - Decay);
+    }
+  }
+}
+
+void InitProfile(bus_profile* Profile) {
+  Profile->Ticks = 0;
+  Profile->InstrumentTicks = 0;
+  Profile->MaxTicks = 0;
+  atomic_init(&Profile->Load, 0);
+  atomic_init(&Profile->InstrumentLoad, 0);
+  atomic_init(&Profile->Peak, 0);
+  atomic_init(&Profile->MaxPeak, 0);
+}
+
+// NOTE(lucas): Loads are relative to the audio that was processed, so they hold when rendering faster than real time
+void PublishProfile(mixer* Mixer, mixer_plan* Plan) {
+  u64 Ticks = ReadCycleCounter();
+  i64 Time = DspLoadTime();
+  f64 TicksPerSecond = Time > Mixer->ProfileTime ? 1000000000.0 * (Ticks - Mixer->ProfileTicks) / (Time - Mixer->ProfileTime) : 1000000000.0;
+  f64 Budget = TicksPerSecond * Mixer->ProfileFrames / Mixer->SampleRate;
+  f64 BlockBudget = TicksPerSecond * Mixer->BlockSize / Mixer->SampleRate;
+  for (i32 NodeIndex = 0; NodeIndex < Plan->NodeCount; ++NodeIndex) {
+    bus* Bus = Plan->Resolved[NodeIndex];
+    if (!Bus) {
+      continue;
+    }
+    bus_profile* Profile = &Bus->Profile;
+    f32 Peak = (f32)(Profile->MaxTicks / BlockBudget);
+    atomic_store_explicit(&Profile->Load, (f32)(Profile->Ticks / Budget), memory_order_relaxed);
+    atomic_store_explicit(&Profile->InstrumentLoad, (f32)(Profile->InstrumentTicks / Budget), memory_order_relaxed);
+    atomic_store_explicit(&Profile->Peak, Peak, memory_order_relaxed);
+    if (Peak > atomic_load_explicit(&Profile->MaxPeak, memory_order_relaxed)) {
+      atomic_store_explicit(&Profile->MaxPeak, Peak, memory_order_relaxed);
+    }
+    Profile->Ticks = 0;
+    Profile->InstrumentTicks = 0;
+    Profile->MaxTicks = 0;
+  }
+  Mixer->ProfileTicks = Ticks;
+  Mixer->ProfileTime = Time;
+  Mixer->ProfileFrames = 0;
+}
+
+void RecordBus(mixer* Mixer, bus* Bus, bus_handle Handle) {
+  u32 Slot = BusHandleSlot(Handle);
+  if (Slot < (u32)Mixer->RecordSlotCount && Mixer->RecordTargets[Slot].Handle == Handle) {
+    StreamWritePlanar(Mixer->RecordTargets[Slot].Track, Bus->Buffer, Bus->ChannelCount, Bus->Stride, Mixer->FrameCount);
+  }
+}
+
+// NOTE(lucas): Slots fade over a block when toggled so that they don't click, faded out effects aren't run
+void ProcessInserts(bus* Bus, i32 FrameCount) {
+  for (i32 SlotIndex = 0; SlotIndex < MAX_INSERT_SLOT; ++SlotIndex) {
+    insert_slot* Slot = &Bus->Inserts[SlotIndex];
+    f32 Target = atomic_load_explicit(&Slot->Bypass, memory_order_relaxed) ? 0.0f : 1.0f;
+    if (!Slot->Effects[0] || (Target == 0.0f && Slot->Wet == 0.0f)) {
+      continue;
+    }
+    f32 Step = (Target - Slot->Wet) / FrameCount;
+    for (i32 Channel = 0; Channel < Bus->ChannelCount; ++Channel) {
+      effect* Effect = Slot->Effects[Channel];
+      f32* Buffer = &Bus->Buffer[Channel * Bus->Stride];
+      if (Slot->Wet == Target) {
+        EffectProcess(Effect, Buffer, 1, FrameCount);
+        continue;
+      }
+      f32 Dry[INSERT_FADE_CHUNK];
+      for (i32 Offset = 0; Offset < FrameCount; Offset += INSERT_FADE_CHUNK) {
+        i32 Count = Min(FrameCount - Offset, INSERT_FADE_CHUNK);
+        f32* Chunk = &Buffer[Offset];
+        memcpy(Dry, Chunk, sizeof(f32) * Count);
+        EffectProcess(Effect, Chunk, 1, Count);
+        for (i32 FrameIndex = 0; FrameIndex < Count; ++FrameIndex) {
+          f32 Wet = Slot->Wet + Step * (Offset + FrameIndex + 1);
+          Chunk[FrameIndex] = Dry[FrameIndex] + Wet * (Chunk[FrameIndex] - Dry[FrameIndex]);
+        }
+      }
+    }
+    Slot->Wet = Target;
+  }
+}
+
+// NOTE(lucas): Only a node writes to its own buffer, so nodes on the same level never touch each other's data
+void ProcessNode(mixer* Mixer, i32 NodeIndex) {
+  mixer_plan* Plan = &Mixer->Plans[atomic_load_explicit(&Mixer->PlanIndex, memory_order_relaxed)];
+  plan_node* Node = &Plan->Nodes[NodeIndex];
+  bus* Bus = Plan->Resolved[NodeIndex];
+  if (!Bus || Bus->Disabled || !Bus->Buffer) {
+    return;
+  }
+  u64 Start = Mixer->Profile ? ReadCycleCounter() : 0;
+  u8 IsMaster = Node->Handle == MASTER_BUS_HANDLE;
+  if (!IsMaster) {
+    ClearFloatBuffer(Bus->Buffer, sizeof(f32) * Bus->ChannelCount * Bus->Stride);
+  }
+
+  instrument* Ins = Bus->Ins;
+  if (Bus->Active && Ins && Ins->Process && Ins->Ready) {
+    Bus->Sidechain = Node->Sidechain >= 0 ? Plan->Resolved[Node->Sidechain] : NULL;
+    if (Bus->MidiInput) {
+      Bus->MidiEvents = Mixer->MidiEvents;
+      Bus->MidiEventCount = Mixer->MidiEventCount;
+    }
+    u64 InstrumentStart = Mixer->Profile ? ReadCycleCounter() : 0;
+    Ins->Process(Ins, Bus, Mixer->FrameCount, Mixer->SampleRate);
+    if (Mixer->Profile) {
+      Bus->Profile.InstrumentTicks += ReadCycleCounter() - InstrumentStart;
+    }
+    Bus->Sidechain = NULL;
+    Bus->MidiEvents = NULL;
+    Bus->MidiEventCount = 0;
+  }
+
+  // NOTE(lucas): The master bus has nowhere to route to, so its panning is applied to everything summed into it
+  v2 Pan = IsMaster ? Bus->Pan : V2(1, 1);
+  f32* Sources[MIX_BATCH_SIZE];
+  f32 Gains[MIX_BATCH_SIZE];
+  for (i32 Channel = 0; Channel < Bus->ChannelCount; ++Channel) {
+    f32* Dest = &Bus->Buffer[Channel * Bus->Stride];
+    i32 SourceCount = 0;
+    for (i32 InputIndex = 0; InputIndex < Node->InputCount; ++InputIndex) {
+      plan_input* Input = &Plan->Inputs[Node->InputStart + InputIndex];
+      bus* Source = Plan->Resolved[Input->Node];
+      if (!Source || !Source->Active || Source->Disabled || !Source->Buffer) {
+        continue;
+      }
+      if (SourceCount + MASTER_CHANNEL_COUNT > MIX_BATCH_SIZE) {
+        MixFloatBuffers(Dest, Sources, Gains, SourceCount, Mixer->FrameCount);
+        SourceCount = 0;
+      }
+      if (Bus->ChannelCount == 2) {
+        i32 SourceChannel = Min(Channel, Source->ChannelCount - 1);
+        Sources[SourceCount] = &Source->Buffer[SourceChannel * Source->Stride];
+        Gains[SourceCount++] = Channel == 0 ? Source->Pan.X * Input->Gain * Pan.X : Source->Pan.Y * Input->Gain * Pan.Y;
+      }
+      else {
+        Sources[SourceCount] = &Source->Buffer[0];
+        Gains[SourceCount++] = 0.5f * Source->Pan.X * Input->Gain * Pan.X;
+        Sources[SourceCount] = &Source->Buffer[(Source->ChannelCount - 1) * Source->Stride];
+        Gains[SourceCount++] = 0.5f * Source->Pan.Y * Input->Gain * Pan.Y;
+      }
+    }
+    MixFloatBuffers(Dest, Sources, Gains, SourceCount, Mixer->FrameCount);
+  }
+  // NOTE(lucas): Inserts process everything that is routed into the bus, and recordings are taken after them
+  if (Bus->Active) {
+    ProcessInserts(Bus, Mixer->FrameCount);
+  }
+  if (Mixer->Recording && !IsMaster) {
+    RecordBus(Mixer, Bus, Node->Handle);
+  }
+  MeterBus(Bus, Mixer->FrameCount);
+  if (IsMaster) {
+    TapWrite(&Mixer->Taps[TAP_MASTER], &Bus->Buffer[0], &Bus->Buffer[(Bus->ChannelCount - 1) * Bus->Stride], Mixer->FrameCount);
+  }
+  else if (Node->Handle == Mixer->BlockTapHandle) {
+    TapWrite(&Mixer->Taps[TAP_FOCUS], &Bus->Buffer[0], &Bus->Buffer[(Bus->ChannelCount - 1) * Bus->Stride], Mixer->FrameCount);
+  }
+  if (Mixer->Profile) {
+    u64 Ticks = ReadCycleCounter() - Start;
+    Bus->Profile.Ticks += Ticks;
+    Bus->Profile.MaxTicks = Max(Bus->Profile.MaxTicks, Ticks);
+  }
+}
+
+void ProcessNodeJob(void* Data, i32 JobIndex) {
+  mixer* Mixer = (mixer*)Data;
+  ProcessNode(Mixer, Mixer->JobOffset + JobIndex);
+}
+
+// Buses are sized for a single block, or the whole buffer if that is smaller
 i32 MixerInit(mixer* Mixer, i32 SampleRate, i32 FramesPerBuffer) {
   Mixer->SampleRate = SampleRate;
-  Mixer->FramesPerBuffer = FramesPerBuffer;
-  Mixer->FocusedBus = NULL;
+  Mixer->BlockSize = G_ProcessQuantum > 0 ? Min(G_ProcessQuantum, FramesPerBuffer) : FramesPerBuffer;
+  Mixer->FrameCount = Mixer->BlockSize;
+  Mixer->MidiEvents = NULL;
+  Mixer->MidiEventCount = 0;
+  Mixer->FocusedBus = BUS_HANDLE_NONE;
+  for (i32 TapIndex = 0; TapIndex < MAX_TAP; ++TapIndex) {
+    TapInit(&Mixer->Taps[TapIndex]);
+    Mixer->Analyzers[TapIndex] = (analyzer) {0};
+  }
+  atomic_init(&Mixer->TapHandle, BUS_HANDLE_NONE);
+  Mixer->BlockTapHandle = BUS_HANDLE_NONE;
+  Mixer->AnalyzerTime = 0;
+  Mixer->RecordTargets = NULL;
+  Mixer->RecordSlotCount = 0;
+  Mixer->Recording = 0;
+  Mixer->ResolveNeeded = 1;
+  Mixer->BufferPool = NULL;
+  Mixer->BufferPoolCount = 0;
+  Mixer->Stride = PlanarStride(Mixer->BlockSize);
+  Mixer->MasterBuffer = M_AlignedCalloc(AUDIO_BUFFER_ALIGNMENT, sizeof(f32), MASTER_CHANNEL_COUNT * Mixer->Stride);
+  ArenaInit(&Mixer->Scratch, G_MixerScratchSize);
+  Mixer->JobOffset = 0;
+  Mixer->MeterTime = 0;
+  Mixer->ProfileTicks = ReadCycleCounter();
+  Mixer->ProfileTime = DspLoadTime();
+  Mixer->ProfileFrames = 0;
+  Mixer->Profile = G_MixerProfile != 0;
+  Mixer->PendingCount = 0;
   Mixer->Active = 0;
+  Mixer->Buses = (bus_store) {0};
+  Mixer->Plans[0] = (mixer_plan) {0};
+  Mixer->Plans[1] = (mixer_plan) {0};
+  atomic_init(&Mixer->PlanIndex, 0);
+  atomic_init(&Mixer->PlanPending, 0);
+  MixerGraphInit(&Mixer->Graph);
+  SpscQueueInit(&Mixer->Commands, sizeof(mixer_command), MIXER_QUEUE_SIZE);
+  SpscQueueInit(&Mixer->Garbage, sizeof(mixer_garbage), MIXER_QUEUE_SIZE);
+  WorkerPoolInit(&Mixer->Workers, G_MixerWorkerCount);
 
-  bus* Master = &Mixer->Buses[0];
-  Master->Buffer = NULL;
+  bus_handle Handle = AllocBus(&Mixer->Buses);
+  Assert(Handle == MASTER_BUS_HANDLE);
+  bus* Master = BusInSlot(&Mixer->Buses, BusHandleSlot(Handle));
+  Master->Buffer = Mixer->MasterBuffer;
   Master->ChannelCount = MASTER_CHANNEL_COUNT;
-  Master->ID = 0;
+  Master->Stride = Mixer->Stride;
   Master->Pan = V2(1, 1);
-  Master->Db = V2(DB_MIN, DB_MIN);
+  InitMeter(&Master->Meter);
+  InitProfile(&Master->Profile);
   Master->Active = 1;
   Master->Disabled = 0;
   Master->InternalBuffer = 0;
-  Master->ToRemove = 0;
   Master->MidiInput = 0;
-
-  Mixer->BusCount = 1;
+  Master->Ins = NULL;
+  Master->Sidechain = NULL;
+  Master->MidiEvents = NULL;
+  Master->MidiEventCount = 0;
+  atomic_store_explicit(&Master->Handle, Handle, memory_order_release);
 
   return NoError;
 }
 
-bus* MixerGetBus(mixer* Mixer, i32 BusIndex) {
-  if (BusIndex > MASTER_BUS_INDEX && BusIndex < Mixer->BusCount) {
-    return &Mixer->Buses[BusIndex];
+// O(1), returns NULL if the bus has been removed or hasn't reached the audio thread yet
+bus* MixerFindBus(mixer* Mixer, bus_handle Handle) {
+  if (Handle == BUS_HANDLE_NONE) {
+    return NULL;
+  }
+  bus* Bus = BusInSlot(&Mixer->Buses, BusHandleSlot(Handle));
+  if (Bus && atomic_load_explicit(&Bus->Handle, memory_order_acquire) == Handle) {
+    return Bus;
   }
   return NULL;
 }
 
-bus* MixerGetFocusedBus(mixer* Mixer) {
-  return Mixer->FocusedBus;
+// Number of buses in the routing graph, including the master bus
+i32 MixerBusCount(mixer* Mixer) {
+  return Mixer->Graph.NodeCount;
 }
 
-i32 MixerAddBus(mixer* Mixer, i32 ChannelCount, f32* Buffer) {
-  if (Mixer->BusCount < MAX_AUDIO_BUS) {
-    bus* Bus = &Mixer->Buses[Mixer->BusCount];
-    if (!Buffer) {
-      Bus->Buffer = M_Calloc(sizeof(f32), ChannelCount * Mixer->FramesPerBuffer);
-      Bus->InternalBuffer = 1;
-    }
-    else {
-      Bus->Buffer = Buffer;
-      Bus->InternalBuffer = 0;
+// Whether the instruments of all buses have been loaded
+u8 MixerInstrumentsReady(mixer* Mixer) {
+  for (i32 BusIndex = MASTER_BUS_INDEX + 1; BusIndex < MixerBusCount(Mixer); ++BusIndex) {
+    bus* Bus = MixerGetBus(Mixer, BusIndex);
+    if (Bus && Bus->Ins && !Bus->Ins->Ready) {
+      return 0;
     }
-    Bus->ChannelCount = ChannelCount;
-    Bus->ID = RandomSeed();
-    Bus->Pan = V2(1, 1);
-    Bus->Db = V2(DB_MIN, DB_MIN);
-    Bus->Active = 1;
-    Bus->Disabled = 0;
-    Bus->ToRemove = 0;
-    Bus->MidiInput = 0;
-    Bus->Ins = NULL;
+  }
+  return 1;
+}
 
-    Mixer->BusCount++;
+// Blocks until the instruments of all buses have been loaded
+void MixerWaitInstruments(mixer* Mixer) {
+  for (;;) {
+    u32 Loaded = atomic_load(&InsHandler.Loaded.Value);
+    if (MixerInstrumentsReady(Mixer)) {
+      break;
+    }
+    WaitWordSleep(&InsHandler.Loaded, Loaded, 0);
   }
-  else {
-    fprintf(stderr, "Maximum amount of buses are in use (%i)\n", Mixer->BusCount);
-    return Error;
+}
+
+bus_handle MixerGetBusHandle(mixer* Mixer, i32 BusIndex) {
+  if (BusIndex > MASTER_BUS_INDEX && BusIndex < Mixer->Graph.NodeCount) {
+    return Mixer->Graph.Nodes[BusIndex].Handle;
   }
-  return NoError;
+  return BUS_HANDLE_NONE;
 }
 
-// NOTE(lucas): Returns a reference to the bus that you added. It should be noted, however, that the reference is
-// not persistant, in other words the reference can change so that it will point to a bus which you initially did not
-// select. Thus, this function should be used with caution.
-bus* MixerAddBus0(mixer* Mixer, i32 ChannelCount, f32* Buffer, i32* BusIndex) {
-  bus* Bus = NULL;
-  i32 Index = Mixer->BusCount;
+bus* MixerGetBus(mixer* Mixer, i32 BusIndex) {
+  return MixerFindBus(Mixer, MixerGetBusHandle(Mixer, BusIndex));
+}
 
-  if (MixerAddBus(Mixer, ChannelCount, Buffer) == NoError) {
-    Bus = &Mixer->Buses[Index];
-    if (BusIndex) {
-      *BusIndex = Index;
-    }
+bus* MixerGetFocusedBus(mixer* Mixer) {
+  return MixerFindBus(Mixer, Mixer->FocusedBus);
+}
+
+// External buffers are planar without padding. The mixer owns Ins even on failure, Handle can be used right away
+i32 MixerAddBus(mixer* Mixer, i32 ChannelCount, f32* Buffer, instrument* Ins, bus_handle* Handle) {
+  Assert(ChannelCount > 0 && ChannelCount <= MAX_BUS_CHANNEL);
+  mixer_command Command = (mixer_command) {
+    .Type = MIXER_CMD_ADD_BUS,
+    .Handle = AllocBus(&Mixer->Buses),
+  };
+  bus* Bus = &Command.Bus;
+  if (!Buffer) {
+    Bus->Buffer = NULL;
+    Bus->InternalBuffer = 1;
+    Bus->Stride = Mixer->Stride;
   }
   else {
-    if (BusIndex) {
-      *BusIndex = -1;
+    Bus->Buffer = Buffer;
+    Bus->InternalBuffer = 0;
+    Bus->Stride = Mixer->BlockSize;
+  }
+  Bus->ChannelCount = ChannelCount;
+  atomic_init(&Bus->Handle, BUS_HANDLE_NONE);
+  Bus->Pan = V2(1, 1);
+  InitMeter(&Bus->Meter);
+  InitProfile(&Bus->Profile);
+  Bus->Active = 1;
+  Bus->Disabled = 0;
+  Bus->MidiInput = 1;
+  Bus->Ins = Ins;
+  Bus->Sidechain = NULL;
+  Bus->MidiEvents = NULL;
+  Bus->MidiEventCount = 0;
+
+  i32 Result = NoError;
+  if (Command.Handle == BUS_HANDLE_NONE) {
+    fprintf(stderr, "Maximum amount of buses are in use (%i)\n", MAX_AUDIO_BUS);
+    Result = Error;
+  }
+  else if ((Result = PushCommand(Mixer, &Command)) != NoError) {
+    ReleaseBus(&Mixer->Buses, Command.Handle);
+  }
+  else {
+    MixerGraphAddNode(&Mixer->Graph, Command.Handle, !Bus->InternalBuffer);
+  }
+  if (Result != NoError && Ins) {
+    DiscardInstrument(Mixer, Ins);
+  }
+  if (Handle) {
+    *Handle = Result == NoError ? Command.Handle : BUS_HANDLE_NONE;
+  }
+  return Result;
+}
+
+i32 MixerRemoveBus(mixer* Mixer, bus_handle Handle) {
+  if (Handle == MASTER_BUS_HANDLE || !MixerGraphFindNode(&Mixer->Graph, Handle)) {
+    return Error;
+  }
+  mixer_command Command = (mixer_command) {
+    .Type = MIXER_CMD_REMOVE_BUS,
+    .Handle = Handle,
+  };
+  i32 Result = PushCommand(Mixer, &Command);
+  if (Result == NoError) {
+    MixerGraphRemoveNode(&Mixer->Graph, Handle);
+    if (Mixer->FocusedBus == Handle) {
+      Mixer->FocusedBus = BUS_HANDLE_NONE;
     }
   }
-  return Bus;
+  return Result;
 }
 
-// NOTE(lucas): We mark the bus for later removal. This is to make sure we
-// don't simultaneously process and try to free the bus.
-i32 MixerRemoveBus(mixer* Mixer, i32 BusIndex) {
-  if (BusIndex > MASTER_BUS_INDEX && BusIndex < Mixer->BusCount) {
-    bus* Bus = &Mixer->Buses[BusIndex];
-    Bus->ToRemove = 1;
+// Routing changes that would make the graph cyclic are rejected
+i32 MixerSetOutput(mixer* Mixer, bus_handle Handle, bus_handle Output) {
+  mixer_node* Node = MixerGraphFindNode(&Mixer->Graph, Handle);
+  if (!Node || Handle == Output || !MixerGraphFindNode(&Mixer->Graph, Output)) {
+    return Error;
+  }
+  bus_handle Previous = Node->Output;
+  Node->Output = Output;
+  if (CheckRouting(Mixer) != NoError) {
+    Node->Output = Previous;
+    return Error;
   }
   return NoError;
 }
 
-i32 MixerAttachInstrumentToBus(mixer* Mixer, i32 BusIndex, instrument* Ins) {
-  if (BusIndex > MASTER_BUS_INDEX && BusIndex < MAX_AUDIO_BUS) {
-    bus* Bus = &Mixer->Buses[BusIndex];
-    if (Bus->Ins) {
-      instrument* Instrument = Bus->Ins;
-      InstrumentFree(Instrument);
-      Bus->Ins = NULL;
+// Sends a copy of the bus to another bus, setting the send again updates its gain
+i32 MixerSetSend(mixer* Mixer, bus_handle Handle, bus_handle Target, f32 Gain) {
+  mixer_node* Node = MixerGraphFindNode(&Mixer->Graph, Handle);
+  if (!Node || Handle == Target || !MixerGraphFindNode(&Mixer->Graph, Target)) {
+    return Error;
+  }
+  i32 SendIndex = 0;
+  for (; SendIndex < Node->SendCount; ++SendIndex) {
+    if (Node->Sends[SendIndex].Target == Target) {
+      Node->Sends[SendIndex].Gain = Gain;
+      Mixer->Graph.Dirty = 1;
+      return NoError;
     }
-    Bus->Ins = Ins;
   }
-  else {
+  if (Node->SendCount >= MAX_BUS_SEND) {
+    return Error;
+  }
+  Node->Sends[Node->SendCount++] = (bus_send) { .Target = Target, .Gain = Gain, };
+  if (CheckRouting(Mixer) != NoError) {
+    --Node->SendCount;
     return Error;
   }
   return NoError;
 }
 
-i32 MixerAttachInstrumentToBus0(mixer* Mixer, bus* Bus, instrument* Ins) {
-  if (!Bus) {
+i32 MixerRemoveSend(mixer* Mixer, bus_handle Handle, bus_handle Target) {
+  mixer_node* Node = MixerGraphFindNode(&Mixer->Graph, Handle);
+  if (!Node) {
     return Error;
   }
-  if (Bus->Ins) {
-    instrument* Instrument = Bus->Ins;
-    InstrumentFree(Instrument);
-    Bus->Ins = NULL;
+  for (i32 SendIndex = 0; SendIndex < Node->SendCount; ++SendIndex) {
+    if (Node->Sends[SendIndex].Target == Target) {
+      Node->Sends[SendIndex] = Node->Sends[--Node->SendCount];
+      Mixer->Graph.Dirty = 1;
+      return NoError;
+    }
+  }
+  return Error;
+}
+
+// The instrument of the bus gets to read the output of the source bus through Bus->Sidechain
+i32 MixerSetSidechain(mixer* Mixer, bus_handle Handle, bus_handle Source) {
+  mixer_node* Node = MixerGraphFindNode(&Mixer->Graph, Handle);
+  if (!Node || Handle == Source || !MixerGraphFindNode(&Mixer->Graph, Source)) {
+    return Error;
+  }
+  bus_handle Previous = Node->Sidechain;
+  Node->Sidechain = Source;
+  if (CheckRouting(Mixer) != NoError) {
+    Node->Sidechain = Previous;
+    return Error;
   }
-  Bus->Ins = Ins;
   return NoError;
 }
 
-i32 MixerToggleActiveBus(mixer* Mixer, i32 BusIndex) {
-  if (BusIndex < Mixer->BusCount) {
-    bus* Bus = &Mixer->Buses[BusIndex];
-    Bus->Active = !Bus->Active;
+i32 MixerClearSidechain(mixer* Mixer, bus_handle Handle) {
+  mixer_node* Node = MixerGraphFindNode(&Mixer->Graph, Handle);
+  if (!Node) {
+    return Error;
   }
+  Node->Sidechain = BUS_HANDLE_NONE;
+  Mixer->Graph.Dirty = 1;
   return NoError;
 }
 
-i32 MixerClearBuffers(mixer* Mixer) {
-  TIMER_START();
-  for (i32 BusIndex = 0; BusIndex < Mixer->BusCount; ++BusIndex) {
-    bus* Bus = &Mixer->Buses[BusIndex];
-    // NOTE(lucas): The buffer is cleared elsewhere if it is not internal
-    if (Bus->Buffer) {
-      if (Bus->InternalBuffer || (Bus->Buffer && BusIndex == MASTER_BUS_INDEX)) {
-        ClearFloatBuffer(Bus->Buffer, sizeof(f32) * Bus->ChannelCount * Mixer->FramesPerBuffer);
+// Replaces the instrument of the bus, the old one is free'd once the audio thread has let go of it
+i32 MixerAttachInstrument(mixer* Mixer, bus_handle Handle, instrument* Ins) {
+  mixer_command Command = (mixer_command) {
+    .Type = MIXER_CMD_ATTACH_INSTRUMENT,
+    .Handle = Handle,
+    .Ins = Ins,
+  };
+  i32 Result = PushCommand(Mixer, &Command);
+  if (Result != NoError && Ins) {
+    DiscardInstrument(Mixer, Ins);
+  }
+  return Result;
+}
+
+// Effect instances are created here on the UI thread, the ones they replace come back as garbage
+i32 MixerSetInsert(mixer* Mixer, bus_handle Handle, i32 SlotIndex, effect_type Type) {
+  mixer_node* Node = MixerGraphFindNode(&Mixer->Graph, Handle);
+  if (!Node || SlotIndex < 0 || SlotIndex >= MAX_INSERT_SLOT || Type < 0 || Type >= MAX_EFFECT_TYPE) {
+    return Error;
+  }
+  mixer_command Command = (mixer_command) {
+    .Type = MIXER_CMD_SET_INSERT,
+    .Handle = Handle,
+    .Slot = SlotIndex,
+  };
+  i32 Result = NoError;
+  if (Type != EFFECT_NONE) {
+    const effect_def* Def = &EffectDefs[Type];
+    for (i32 Channel = 0; Channel < MAX_BUS_CHANNEL && Result == NoError; ++Channel) {
+      if (!(Command.Effects[Channel] = EffectCreate(Type, Channel, Def->DefaultMix, Def->DefaultAmount))) {
+        Result = Error;
       }
     }
   }
-  TIMER_END();
+  if (Result == NoError) {
+    Result = PushCommand(Mixer, &Command);
+  }
+  if (Result != NoError) {
+    for (i32 Channel = 0; Channel < MAX_BUS_CHANNEL; ++Channel) {
+      EffectDestroy(Command.Effects[Channel]);
+    }
+    return Result;
+  }
+  Node->Inserts[SlotIndex] = Type;
+  memcpy(Node->InsertEffects[SlotIndex], Command.Effects, sizeof(Command.Effects));
   return NoError;
 }
 
-i32 MixerSumBuses(mixer* Mixer, u8 Playing, f32* OutBuffer, f32* InBuffer) {
-  TIMER_START();
-
-  bus* Master = &Mixer->Buses[0];
-  if (!Master->Buffer) {
-    Master->Buffer = OutBuffer;
-    ClearFloatBuffer(Master->Buffer, sizeof(f32) * Master->ChannelCount * Mixer->FramesPerBuffer);
+// NOTE(lucas): Instances are only free'd on this thread, once they have been replaced
+i32 MixerSetEqGain(mixer* Mixer, bus_handle Handle, i32 SlotIndex, i32 Band, f32 Gain) {
+  mixer_node* Node = MixerGraphFindNode(&Mixer->Graph, Handle);
+  if (!Node || SlotIndex < 0 || SlotIndex >= MAX_INSERT_SLOT || Node->Inserts[SlotIndex] != EFFECT_EQ) {
+    return Error;
   }
+  i32 Result = NoError;
+  for (i32 Channel = 0; Channel < MAX_BUS_CHANNEL; ++Channel) {
+    Result |= EffectSetEqGain(Node->InsertEffects[SlotIndex][Channel], Band, Gain);
+  }
+  return Result ? Error : NoError;
+}
 
-  if (!Master->Active || Master->Disabled || !Master->Buffer) {
-    return NoError;
+// NOTE(lucas): Every command makes at most one piece of garbage, so we never take more than the garbage queue can hold
+void MixerProcessCommands(mixer* Mixer) {
+  if (atomic_load_explicit(&Mixer->PlanPending, memory_order_acquire)) {
+    i32 PlanIndex = atomic_load_explicit(&Mixer->PlanIndex, memory_order_relaxed);
+    atomic_store_explicit(&Mixer->PlanIndex, !PlanIndex, memory_order_relaxed);
+    atomic_store_explicit(&Mixer->PlanPending, 0, memory_order_release);
+    Mixer->ResolveNeeded = 1;
   }
 
-  // Process all buses
-  for (i32 BusIndex = 1; BusIndex < Mixer->BusCount; ++BusIndex) {
-    bus* Bus = &Mixer->Buses[BusIndex];
-    if (Bus->ToRemove) {
-      if (Bus->Ins) {
-        if (!Bus->Ins->Ready) {
-          // We are processing this instrument (loading/unloading), thus we cannot remove it as of yet
-          continue;
+  mixer_command Command;
+  while (SpscQueueSpace(&Mixer->Garbage) > 0 && SpscQueuePop(&Mixer->Commands, &Command)) {
+    switch (Command.Type) {
+      case MIXER_CMD_ADD_BUS: {
+        bus* Bus = BusInSlot(&Mixer->Buses, BusHandleSlot(Command.Handle));
+        *Bus = Command.Bus;
+        atomic_store_explicit(&Bus->Handle, Command.Handle, memory_order_release);
+        Mixer->ResolveNeeded = 1;
+        break;
+      }
+      case MIXER_CMD_REMOVE_BUS: {
+        bus* Bus = MixerFindBus(Mixer, Command.Handle);
+        if (Bus) {
+          RemoveBus(Mixer, Bus);
         }
+        break;
       }
-      RemoveBus(Mixer, BusIndex);
-      continue;
-    }
-    // NOTE(lucas): We do not want to process the bus if we are not playing
-    if (!Playing) {
-      continue;
+      case MIXER_CMD_ATTACH_INSTRUMENT: {
+        bus* Bus = MixerFindBus(Mixer, Command.Handle);
+        mixer_garbage Garbage = (mixer_garbage) {
+          .Ins = Command.Ins,
+          .Bus = BUS_HANDLE_NONE,
+        };
+        if (Bus) {
+          Garbage.Ins = Bus->Ins;
+          Bus->Ins = Command.Ins;
+        }
+        if (Garbage.Ins) {
+          SpscQueuePush(&Mixer->Garbage, &Garbage);
+        }
+        break;
+      }
+      case MIXER_CMD_SET_INSERT: {
+        bus* Bus = MixerFindBus(Mixer, Command.Handle);
+        mixer_garbage Garbage = (mixer_garbage) {
+          .Ins = NULL,
+          .Bus = BUS_HANDLE_NONE,
+        };
+        for (i32 Channel = 0; Channel < MAX_BUS_CHANNEL; ++Channel) {
+          Garbage.Effects[Channel] = Command.Effects[Channel];
+        }
+        if (Bus) {
+          // NOTE(lucas): The new effect fades in from the dry signal, like a slot that is being enabled
+          insert_slot* Slot = &Bus->Inserts[Command.Slot];
+          for (i32 Channel = 0; Channel < MAX_BUS_CHANNEL; ++Channel) {
+            Garbage.Effects[Channel] = Slot->Effects[Channel];
+            Slot->Effects[Channel] = Command.Effects[Channel];
+          }
+          Slot->Wet = 0.0f;
+        }
+        if (Garbage.Effects[0]) {
+          SpscQueuePush(&Mixer->Garbage, &Garbage);
+        }
+        break;
+      }
+      default:
+        break;
     }
+  }
+}
 
-    instrument* Ins = Bus->Ins;
-    if (Bus->Active && !Bus->Disabled && Bus->Buffer && !Bus->ToRemove) {
-      if (Ins) {
-        if (Ins->Process && Ins->Ready) {
-          Ins->Process(Ins, Bus, Mixer->FramesPerBuffer, Mixer->SampleRate);
+// NOTE(lucas): Only one plan is in flight at a time, and instruments that are still loading are kept until ready
+void MixerUpdate(mixer* Mixer) {
+  if (Mixer->Graph.Dirty && !atomic_load_explicit(&Mixer->PlanPending, memory_order_acquire)) {
+    mixer_plan* Plan = &Mixer->Plans[!atomic_load_explicit(&Mixer->PlanIndex, memory_order_relaxed)];
+    if (MixerGraphCompile(&Mixer->Graph, Plan) == NoError) {
+      if (Plan->BufferCount > Mixer->BufferPoolCount) {
+        Mixer->BufferPool = M_Realloc(Mixer->BufferPool, sizeof(f32*) * Mixer->BufferPoolCount, sizeof(f32*) * Plan->BufferCount);
+        while (Mixer->BufferPoolCount < Plan->BufferCount) {
+          Mixer->BufferPool[Mixer->BufferPoolCount++] = M_AlignedCalloc(AUDIO_BUFFER_ALIGNMENT, sizeof(f32), MASTER_CHANNEL_COUNT * Mixer->Stride);
         }
       }
+      for (i32 BufferIndex = 0; BufferIndex < Plan->BufferCount; ++BufferIndex) {
+        Plan->Buffers[BufferIndex] = Mixer->BufferPool[BufferIndex];
+      }
+      atomic_store_explicit(&Mixer->PlanPending, 1, memory_order_release);
     }
+    Mixer->Graph.Dirty = 0;
   }
 
-  // Early out if we are not playing
-  if (!Playing) {
+  for (i32 PendingIndex = 0; PendingIndex < Mixer->PendingCount; ++PendingIndex) {
+    mixer_garbage* Garbage = &Mixer->Pending[PendingIndex];
+    if (Garbage->Ins->Ready) {
+      FreeGarbage(Garbage);
+      *Garbage = Mixer->Pending[--Mixer->PendingCount];
+      --PendingIndex;
+    }
+  }
+
+  mixer_garbage Garbage;
+  while (Mixer->PendingCount < MIXER_QUEUE_SIZE && SpscQueuePop(&Mixer->Garbage, &Garbage)) {
+    if (Garbage.Bus != BUS_HANDLE_NONE) {
+      ReleaseBus(&Mixer->Buses, Garbage.Bus);
+    }
+    if (Garbage.Ins && !Garbage.Ins->Ready) {
+      Mixer->Pending[Mixer->PendingCount++] = Garbage;
+    }
+    else {
+      FreeGarbage(&Garbage);
+    }
+  }
+}
+
+// Gives up and returns the last value it saw if the audio thread keeps writing
+void MixerReadMeter(bus* Bus, v2* Peak, v2* Rms) {
+  bus_meter* Meter = &Bus->Meter;
+  for (i32 Attempt = 0; Attempt < 4; ++Attempt) {
+    u32 Sequence = atomic_load_explicit(&Meter->Sequence, memory_order_acquire);
+    *Peak = V2(atomic_load_explicit(&Meter->Peak[0], memory_order_relaxed), atomic_load_explicit(&Meter->Peak[1], memory_order_relaxed));
+    *Rms = V2(atomic_load_explicit(&Meter->Rms[0], memory_order_relaxed), atomic_load_explicit(&Meter->Rms[1], memory_order_relaxed));
+    atomic_thread_fence(memory_order_acquire);
+    if (!(Sequence & 1) && atomic_load_explicit(&Meter->Sequence, memory_order_relaxed) == Sequence) {
+      break;
+    }
+  }
+}
+
+// NOTE(lucas): Only buses that exist when recording first starts get a track, the tracks are fixed from then on
+i32 MixerAddRecordTracks(mixer* Mixer, const char* Prefix) {
+  if (Mixer->RecordTargets) {
     return NoError;
   }
+  Mixer->RecordSlotCount = Mixer->Buses.SlotCount;
+  Mixer->RecordTargets = M_Malloc(sizeof(record_target) * Mixer->RecordSlotCount);
+  if (!Mixer->RecordTargets) {
+    Mixer->RecordSlotCount = 0;
+    return Error;
+  }
+  for (i32 Slot = 0; Slot < Mixer->RecordSlotCount; ++Slot) {
+    Mixer->RecordTargets[Slot] = (record_target) { .Handle = BUS_HANDLE_NONE, .Track = -1 };
+  }
+  char Path[MAX_PATH_SIZE];
+  for (i32 NodeIndex = MASTER_BUS_INDEX + 1; NodeIndex < Mixer->Graph.NodeCount; ++NodeIndex) {
+    bus_handle Handle = Mixer->Graph.Nodes[NodeIndex].Handle;
+    bus* Bus = MixerFindBus(Mixer, Handle);
+    snprintf(Path, MAX_PATH_SIZE, "%s_bus%i.wav", Prefix, NodeIndex);
+    i32 Track = StreamAddTrack(Bus ? Bus->ChannelCount : MASTER_CHANNEL_COUNT, Path);
+    if (Track < 0) {
+      break;
+    }
+    Mixer->RecordTargets[BusHandleSlot(Handle)] = (record_target) { .Handle = Handle, .Track = Track };
+  }
+  return NoError;
+}
 
-  // Sum all buses into the master bus
-  for (i32 BusIndex = Mixer->BusCount - 1; BusIndex >= 0; --BusIndex) {
-    bus* Bus = &Mixer->Buses[BusIndex];
-    f32* Iter = &Master->Buffer[0];
-    if (!Bus->Disabled && !Bus->ToRemove && Bus->Buffer) {
-      f32 Frame0 = 0.0f;
-      f32 Frame1 = 0.0f;
-      v2 Db = V2(0.0f, 0.0f);
-      i32 WindowSize = Mixer->FramesPerBuffer;
-      for (i32 FrameIndex = 0; FrameIndex < Mixer->FramesPerBuffer; ++FrameIndex) {
-        if (Bus->ChannelCount == 2) {
-          Frame0 = Bus->Buffer[FrameIndex * Bus->ChannelCount];
-          Frame1 = Bus->Buffer[FrameIndex * Bus->ChannelCount + 1];
-        }
-        else {
-          Frame0 = Frame1 = Bus->Buffer[FrameIndex * Bus->ChannelCount];
-        }
-        if (Bus->Active && BusIndex != MASTER_BUS_INDEX && Bus->InternalBuffer) {
-          *(Iter++) += Frame0 * Bus->Pan.X * Master->Pan.X;
-          *(Iter++) += Frame1 * Bus->Pan.Y * Master->Pan.Y;
-        }
-        Db.L += 20.0f * Log10(Abs(Frame0));
-        Db.R += 20.0f * Log10(Abs(Frame1));
+i32 MixerToggleActiveBus(mixer* Mixer, i32 BusIndex) {
+  if (BusIndex >= 0 && BusIndex < Mixer->Graph.NodeCount) {
+    bus* Bus = MixerFindBus(Mixer, Mixer->Graph.Nodes[BusIndex].Handle);
+    if (Bus) {
+      Bus->Active = !Bus->Active;
+    }
+  }
+  return NoError;
+}
+
+// NOTE(lucas): A level only goes to the worker pool when it has enough nodes to pay for waking the workers
+i32 MixerSumBuses(mixer* Mixer, u8 Playing, f32* OutBuffer, f32* InBuffer, i32 FrameCount) {
+  Assert(FrameCount > 0 && FrameCount <= Mixer->BlockSize);
+  Mixer->FrameCount = FrameCount;
+
+  bus* Master = MixerFindBus(Mixer, MASTER_BUS_HANDLE);
+  if (!OutBuffer) {
+    return NoError;
+  }
+
+  if (!Master->Active || Master->Disabled || !Playing) {
+    ClearFloatBuffer(OutBuffer, sizeof(f32) * Master->ChannelCount * FrameCount);
+    return NoError;
+  }
+  ClearFloatBuffer(Master->Buffer, sizeof(f32) * Master->ChannelCount * Master->Stride);
+
+  if (Mixer->ResolveNeeded) {
+    ResolvePlan(Mixer);
+  }
+
+  // NOTE(lucas): Read once per block, so that only one bus (and so one thread) writes to the tap
+  Mixer->BlockTapHandle = atomic_load_explicit(&Mixer->TapHandle, memory_order_relaxed);
+  mixer_plan* Plan = &Mixer->Plans[atomic_load_explicit(&Mixer->PlanIndex, memory_order_relaxed)];
+  for (i32 LevelIndex = 0; LevelIndex < Plan->LevelCount; ++LevelIndex) {
+    i32 NodeIndex = Plan->LevelStart[LevelIndex];
+    i32 NodeCount = Plan->LevelStart[LevelIndex + 1] - NodeIndex;
+    if (Mixer->Workers.WorkerCount > 0 && NodeCount >= G_MixerParallelMinBuses) {
+      Mixer->JobOffset = NodeIndex;
+      WorkerPoolRun(&Mixer->Workers, ProcessNodeJob, Mixer, NodeCount);
+    }
+    else {
+      for (i32 JobIndex = 0; JobIndex < NodeCount; ++JobIndex) {
+        ProcessNode(Mixer, NodeIndex + JobIndex);
       }
-      Db.L /= WindowSize;
-      Db.R /= WindowSize;
-      Bus->Db = Db;
     }
   }
-  TIMER_END();
+  InterleaveFloatBuffer(OutBuffer, &Master->Buffer[0], &Master->Buffer[Master->Stride], FrameCount);
+  if (Mixer->Profile) {
+    Mixer->ProfileFrames += FrameCount;
+    if (Mixer->ProfileFrames >= DSP_LOAD_WINDOW * Mixer->SampleRate) {
+      PublishProfile(Mixer, Plan);
+    }
+  }
   return NoError;
 }
 
+void MixerPrintProfile(mixer* Mixer, FILE* File) {
+  if (!Mixer->Profile) {
+    fprintf(File, "Bus profiling is disabled (mixer_profile)\n");
+    return;
+  }
+  fprintf(File, "Bus cpu load (%% of real time over the last %gs, peak is relative to a %i frame block):\n", DSP_LOAD_WINDOW, Mixer->BlockSize);
+  fprintf(File, "%6s | %-16s | %7s | %10s | %7s | %8s\n", "BUS", "INSTRUMENT", "LOAD", "INSTRUMENT", "PEAK", "MAX PEAK");
+  for (i32 NodeIndex = 0; NodeIndex < Mixer->Graph.NodeCount; ++NodeIndex) {
+    bus* Bus = MixerFindBus(Mixer, Mixer->Graph.Nodes[NodeIndex].Handle);
+    if (!Bus) {
+      continue;
+    }
+    bus_profile* Profile = &Bus->Profile;
+    const char* Name = NodeIndex == MASTER_BUS_INDEX ? "(master)" : "-";
+    if (Bus->Ins && Bus->Ins->Type >= 0 && Bus->Ins->Type < (i32)InsHandler.InstrumentCount) {
+      Name = InsHandler.Instruments[Bus->Ins->Type].Name;
+    }
+    fprintf(File, "%6i | %-16s | %6.2f%% | %9.2f%% | %6.1f%% | %7.1f%%\n",
+      NodeIndex,
+      Name,
+      100 * atomic_load_explicit(&Profile->Load, memory_order_relaxed),
+      100 * atomic_load_explicit(&Profile->InstrumentLoad, memory_order_relaxed),
+      100 * atomic_load_explicit(&Profile->Peak, memory_order_relaxed),
+      100 * atomic_load_explicit(&Profile->MaxPeak, memory_order_relaxed)
+    );
+  }
+}
+
+// NOTE(lucas): Removing a bus moves the last node into its place, so that node is drawn next instead of skipped
 i32 MixerRender(mixer* Mixer) {
   const i32 TileSize = 24;
   v2 PrevButtonSize = UIButtonSize;
   UIButtonSize.H = TileSize;
   v3 PrevColorButton = UIColorButton;
-  for (i32 BusIndex = 0; BusIndex < Mixer->BusCount; ++BusIndex) {
-    bus* Bus = &Mixer->Buses[BusIndex];
-    f32 DbFactorL = 1.0f / (1 + Abs(Bus->Db.L));
-    f32 DbFactorR = 1.0f / (1 + Abs(Bus->Db.R));
+
+  struct timeval TimeNow;
+  gettimeofday(&TimeNow, NULL);
+  f64 Time = TimeNow.tv_sec + TimeNow.tv_usec / 1000000.0;
+  f32 DeltaTime = Mixer->MeterTime > 0 ? Time - Mixer->MeterTime : 0.0f;
+  Mixer->MeterTime = Time;
+
+  for (i32 NodeIndex = 0; NodeIndex < Mixer->Graph.NodeCount; ++NodeIndex) {
+    mixer_node* Node = &Mixer->Graph.Nodes[NodeIndex];
+    bus_handle Handle = Node->Handle;
+    bus* Bus = MixerFindBus(Mixer, Handle);
+    if (!Bus) {
+      continue;
+    }
+    u32 ID = UI_ID + Handle * 2654435761u;
+    v2 Peak;
+    v2 Rms;
+    MixerReadMeter(Bus, &Peak, &Rms);
+    UpdateMeterView(&Node->Meter, Peak, DeltaTime);
+    meter_view View = Node->Meter;
+    f32 DbFactorL = 1.0f / (1 + Abs(View.Level.L));
+    f32 DbFactorR = 1.0f / (1 + Abs(View.Level.R));
     f32 DbFactorAverage = (DbFactorL + DbFactorR) / 2.0f;
-    if (UI_DoBox(UI_ID + Bus->ID, V2(TileSize, TileSize), ColorGain(V3(0.3f, 1.0f, 0.3f), 10 * DbFactorAverage))) {
+    if (UI_DoBox(ID, V2(TileSize, TileSize), ColorGain(V3(0.3f, 1.0f, 0.3f), 10 * DbFactorAverage))) {
       Bus->Active = !Bus->Active;
     }
-    if (BusIndex > MASTER_BUS_INDEX) {
+    f32 PeakHold = Max(View.PeakHold.L, View.PeakHold.R);
+    v3 PeakColor = PeakHold >= 0.0f ? V3(1.0f, 0.2f, 0.2f) : ColorGain(V3(0.3f, 1.0f, 0.3f), 10.0f / (1 + Abs(PeakHold)));
+    UI_DoBox(ID + 5, V2(TileSize / 4, TileSize), PeakColor);
+    if (Mixer->Profile) {
+      UI_DoStringButton(ID + 6, "%4.1f%%", 100 * atomic_load_explicit(&Bus->Profile.Load, memory_order_relaxed));
+    }
+    if (NodeIndex > MASTER_BUS_INDEX) {
       UIColorButton = UIColorDecline;
-      if (UI_DoTextButton(UI_ID + Bus->ID + 1, "DEL")) {
-        MixerRemoveBus(Mixer, BusIndex);
+      if (UI_DoTextButton(ID + 1, "DEL")) {
+        UIColorButton = PrevColorButton;
+        if (MixerRemoveBus(Mixer, Handle) == NoError) {
+          --NodeIndex;
+        }
         continue;
       }
       UIColorButton = PrevColorButton;
-      u8 ThisFocus = Mixer->FocusedBus == Bus;
-      if (UI_DoTextToggle(UI_ID + Bus->ID + 2, "FOC", &ThisFocus)) {
-        if (!ThisFocus) {
-          Mixer->FocusedBus = NULL;
-        }
-        else {
-          Mixer->FocusedBus = Bus;
+      u8 ThisFocus = Mixer->FocusedBus == Handle;
+      if (UI_DoTextToggle(ID + 2, "FOC", &ThisFocus)) {
+        Mixer->FocusedBus = ThisFocus ? Handle : BUS_HANDLE_NONE;
+      }
+      UI_DoTextToggle(ID + 3, "MID", &Bus->MidiInput);
+      i32 OutputIndex = Max(MixerGraphFindNode(&Mixer->Graph, Node->Output) - Mixer->Graph.Nodes, MASTER_BUS_INDEX);
+      if (UI_DoStringButton(ID + 4, "OUT %i", OutputIndex)) {
+        // Route to the next bus which doesn't make the graph cyclic
+        for (i32 Offset = 1; Offset < Mixer->Graph.NodeCount; ++Offset) {
+          bus_handle Target = Mixer->Graph.Nodes[(OutputIndex + Offset) % Mixer->Graph.NodeCount].Handle;
+          if (MixerSetOutput(Mixer, Handle, Target) == NoError) {
+            break;
+          }
         }
       }
-      UI_DoTextToggle(UI_ID + Bus->ID + 3, "MID", &Bus->MidiInput);
     }
   }
   UIButtonSize = PrevButtonSize;
@@ -297,32 +1015,120 @@ i32 MixerRender(mixer* Mixer) {
   return NoError;
 }
 
-// NOTE(lucas): We spin and wait for buses to be completely free'd
+i32 MixerDrawInserts(mixer* Mixer, bus_handle Handle) {
+  mixer_node* Node = MixerGraphFindNode(&Mixer->Graph, Handle);
+  bus* Bus = MixerFindBus(Mixer, Handle);
+  if (!Node || !Bus) {
+    return NoError;
+  }
+  u32 ID = UI_ID + Handle * 2654435761u;
+  for (i32 SlotIndex = 0; SlotIndex < MAX_INSERT_SLOT; ++SlotIndex) {
+    effect_type Type = Node->Inserts[SlotIndex];
+    if (UI_DoStringButton(ID + 2 * SlotIndex, "FX %i: %s", SlotIndex + 1, EffectDefs[Type].Name)) {
+      MixerSetInsert(Mixer, Handle, SlotIndex, (Type + 1) % MAX_EFFECT_TYPE);
+    }
+    if (Type != EFFECT_NONE) {
+      _Atomic u8* Bypass = &Bus->Inserts[SlotIndex].Bypass;
+      u8 Value = atomic_load_explicit(Bypass, memory_order_relaxed);
+      if (UI_DoTextToggle(ID + 2 * SlotIndex + 1, "BYP", &Value)) {
+        atomic_store_explicit(Bypass, Value, memory_order_relaxed);
+      }
+    }
+    if (Type == EFFECT_EQ) {
+      // Every click raises the gain of the band by a step, going back to the bottom of the range at the top
+      for (i32 Band = 0; Band < EQ_BAND_COUNT; ++Band) {
+        const eq_band* Settings = EffectEqBand(Node->InsertEffects[SlotIndex][0], Band);
+        if (!Settings) {
+          break;
+        }
+        u32 BandID = ID + 2 * MAX_INSERT_SLOT + SlotIndex * EQ_BAND_COUNT + Band;
+        if (UI_DoStringButton(BandID, "%.0f Hz %+.0f dB", Settings->Frequency, Settings->Gain)) {
+          f32 Gain = Settings->Gain + EQ_GAIN_STEP > EQ_GAIN_RANGE + 0.5f ? -EQ_GAIN_RANGE : Settings->Gain + EQ_GAIN_STEP;
+          MixerSetEqGain(Mixer, Handle, SlotIndex, Band, Gain);
+        }
+      }
+    }
+  }
+  return NoError;
+}
+
+// NOTE(lucas): The analysis happens here, on the UI thread, the audio thread only writes the taps
+i32 MixerDrawAnalyzer(mixer* Mixer) {
+  const v2 SpectrumSize = V2(3 * ANALYZER_BAND_COUNT, 96);
+  const v2 ScopeSize = V2(SCOPE_POINT_COUNT, 96);
+  const v3 Colors[MAX_TAP] = { V3(0.3f, 1.0f, 0.3f), V3(1.0f, 0.75f, 0.2f) };
+
+  atomic_store_explicit(&Mixer->TapHandle, Mixer->FocusedBus, memory_order_relaxed);
+  struct timeval TimeNow;
+  gettimeofday(&TimeNow, NULL);
+  f64 Time = TimeNow.tv_sec + TimeNow.tv_usec / 1000000.0;
+  f32 DeltaTime = Mixer->AnalyzerTime > 0 ? Time - Mixer->AnalyzerTime : 0.0f;
+  Mixer->AnalyzerTime = Time;
+
+  i32 TapCount = MixerGetFocusedBus(Mixer) ? MAX_TAP : TAP_FOCUS;
+  for (i32 TapIndex = 0; TapIndex < TapCount; ++TapIndex) {
+    analyzer* Analyzer = &Mixer->Analyzers[TapIndex];
+    if (AnalyzerUpdate(Analyzer, &Mixer->Taps[TapIndex], Mixer->SampleRate, DeltaTime) != NoError) {
+      return Error;
+    }
+    UI_DoPlot(UI_ID + 2 * TapIndex, SpectrumSize, Analyzer->Bands, ANALYZER_BAND_COUNT, Colors[TapIndex], 1);
+    UI_DoPlot(UI_ID + 2 * TapIndex + 1, ScopeSize, Analyzer->Scope, SCOPE_POINT_COUNT, Colors[TapIndex], 0);
+  }
+  return NoError;
+}
+
+// NOTE(lucas): The audio thread is stopped, so we apply whatever is left in the command queue ourselves
 void MixerFree(mixer* Mixer) {
   TIMER_START();
 
-  u8 Spin = 0;
-  u32 SpinCounter = 0;
-  (void)SpinCounter;
-  u8 InvokedFree = 0;
+  WorkerPoolFree(&Mixer->Workers);
 
   do {
-    Spin = 0;
-    for (i32 BusIndex = 1; BusIndex < Mixer->BusCount; ++BusIndex) {
-      bus* Bus = &Mixer->Buses[BusIndex];
-      if (!InvokedFree) {
-        FreeBus(Mixer, Bus);
-      }
-      if (Bus->Ins) {
-        if (!Bus->Ins->Ready) {
-          Spin = 1; // Continue spinning because we are not done processing this bus
-        }
+    MixerProcessCommands(Mixer);
+    MixerUpdate(Mixer);
+  } while (SpscQueueCount(&Mixer->Commands) > 0);
+
+  u32 SpinCounter = 0;
+  (void)SpinCounter;
+  for (i32 Slot = MASTER_BUS_INDEX + 1; Slot < Mixer->Buses.SlotCount; ++Slot) {
+    bus* Bus = BusInSlot(&Mixer->Buses, Slot);
+    if (atomic_load_explicit(&Bus->Handle, memory_order_relaxed) != BUS_HANDLE_NONE) {
+      while (SpscQueueSpace(&Mixer->Garbage) == 0) {
+        MixerUpdate(Mixer);
       }
+      RemoveBus(Mixer, Bus);
     }
-    InvokedFree = 1;
+  }
+  while (Mixer->PendingCount > 0 || SpscQueueCount(&Mixer->Garbage) > 0) {
+    MixerUpdate(Mixer);
     ++SpinCounter;
     sleep(0);
-  } while (Spin);
+  }
+  SpscQueueFree(&Mixer->Commands);
+  SpscQueueFree(&Mixer->Garbage);
+  FreeBusStore(&Mixer->Buses);
+  MixerGraphFree(&Mixer->Graph);
+  MixerPlanFree(&Mixer->Plans[0]);
+  MixerPlanFree(&Mixer->Plans[1]);
+  for (i32 BufferIndex = 0; BufferIndex < Mixer->BufferPoolCount; ++BufferIndex) {
+    M_Free(Mixer->BufferPool[BufferIndex], sizeof(f32) * MASTER_CHANNEL_COUNT * Mixer->Stride);
+  }
+  if (Mixer->BufferPool) {
+    M_Free(Mixer->BufferPool, sizeof(f32*) * Mixer->BufferPoolCount);
+  }
+  Mixer->BufferPool = NULL;
+  Mixer->BufferPoolCount = 0;
+  M_Free(Mixer->MasterBuffer, sizeof(f32) * MASTER_CHANNEL_COUNT * Mixer->Stride);
+  for (i32 TapIndex = 0; TapIndex < MAX_TAP; ++TapIndex) {
+    AnalyzerFree(&Mixer->Analyzers[TapIndex]);
+  }
+  Mixer->MasterBuffer = NULL;
+  ArenaFree(&Mixer->Scratch);
+  if (Mixer->RecordTargets) {
+    M_Free(Mixer->RecordTargets, sizeof(record_target) * Mixer->RecordSlotCount);
+    Mixer->RecordTargets = NULL;
+    Mixer->RecordSlotCount = 0;
+  }
 
   TIMER_END(
 #if 0
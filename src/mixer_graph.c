@@ -0,0 +1,327 @@
+// mixer_graph.c
+
+static i32 FindNode(mixer_graph* Graph, bus_handle Handle);
+static void PlanReserve(mixer_plan* Plan, i32 NodeCount, i32 InputCount);
+
+i32 FindNode(mixer_graph* Graph, bus_handle Handle) {
+  u32 Slot = BusHandleSlot(Handle);
+  if (Handle != BUS_HANDLE_NONE && Slot < (u32)Graph->SlotCapacity) {
+    i32 NodeIndex = Graph->NodeOfSlot[Slot];
+    if (NodeIndex >= 0 && Graph->Nodes[NodeIndex].Handle == Handle) {
+      return NodeIndex;
+    }
+  }
+  return -1;
+}
+
+void PlanReserve(mixer_plan* Plan, i32 NodeCount, i32 InputCount) {
+  if (NodeCount > Plan->NodeCapacity) {
+    i32 Capacity = Max(NodeCount, 2 * Plan->NodeCapacity);
+    Plan->Nodes = M_Realloc(Plan->Nodes, sizeof(plan_node) * Plan->NodeCapacity, sizeof(plan_node) * Capacity);
+    Plan->Resolved = M_Realloc(Plan->Resolved, sizeof(bus*) * Plan->NodeCapacity, sizeof(bus*) * Capacity);
+    Plan->LevelStart = M_Realloc(Plan->LevelStart, sizeof(i32) * (Plan->NodeCapacity + 1), sizeof(i32) * (Capacity + 1));
+    Plan->Buffers = M_Realloc(Plan->Buffers, sizeof(f32*) * Plan->BufferCapacity, sizeof(f32*) * Capacity);
+    Plan->NodeCapacity = Capacity;
+    Plan->BufferCapacity = Capacity;
+  }
+  if (InputCount > Plan->InputCapacity) {
+    i32 Capacity = Max(InputCount, 2 * Plan->InputCapacity);
+    Plan->Inputs = M_Realloc(Plan->Inputs, sizeof(plan_input) * Plan->InputCapacity, sizeof(plan_input) * Capacity);
+    Plan->InputCapacity = Capacity;
+  }
+}
+
+// The master bus is the first node, and writes straight into the output buffer
+void MixerGraphInit(mixer_graph* Graph) {
+  Graph->Nodes = NULL;
+  Graph->NodeCount = 0;
+  Graph->NodeCapacity = 0;
+  Graph->NodeOfSlot = NULL;
+  Graph->SlotCapacity = 0;
+  MixerGraphAddNode(Graph, 0, 1);
+}
+
+mixer_node* MixerGraphFindNode(mixer_graph* Graph, bus_handle Handle) {
+  i32 NodeIndex = FindNode(Graph, Handle);
+  if (NodeIndex >= 0) {
+    return &Graph->Nodes[NodeIndex];
+  }
+  return NULL;
+}
+
+i32 MixerGraphAddNode(mixer_graph* Graph, bus_handle Handle, u8 ExternalBuffer) {
+  i32 Slot = BusHandleSlot(Handle);
+  if (Graph->NodeCount >= Graph->NodeCapacity) {
+    i32 Capacity = Graph->NodeCapacity > 0 ? 2 * Graph->NodeCapacity : BUS_CHUNK_SIZE;
+    Graph->Nodes = M_Realloc(Graph->Nodes, sizeof(mixer_node) * Graph->NodeCapacity, sizeof(mixer_node) * Capacity);
+    Graph->NodeCapacity = Capacity;
+  }
+  if (Slot >= Graph->SlotCapacity) {
+    i32 Capacity = Max(2 * Graph->SlotCapacity, Slot + BUS_CHUNK_SIZE);
+    Graph->NodeOfSlot = M_Realloc(Graph->NodeOfSlot, sizeof(i32) * Graph->SlotCapacity, sizeof(i32) * Capacity);
+    for (i32 Index = Graph->SlotCapacity; Index < Capacity; ++Index) {
+      Graph->NodeOfSlot[Index] = -1;
+    }
+    Graph->SlotCapacity = Capacity;
+  }
+  Graph->NodeOfSlot[Slot] = Graph->NodeCount;
+  Graph->Nodes[Graph->NodeCount++] = (mixer_node) {
+    .Handle = Handle,
+    .Output = 0,
+    .Sidechain = BUS_HANDLE_NONE,
+    .ExternalBuffer = ExternalBuffer,
+    .SendCount = 0,
+    .Meter = (meter_view) {
+      .Level = V2(DB_MIN, DB_MIN),
+      .PeakHold = V2(DB_MIN, DB_MIN),
+      .HoldTime = V2(0, 0),
+    },
+  };
+  Graph->Dirty = 1;
+  return NoError;
+}
+
+// Inputs of the removed bus are routed to the master bus, sends and sidechains to it are dropped
+void MixerGraphRemoveNode(mixer_graph* Graph, bus_handle Handle) {
+  i32 NodeIndex = FindNode(Graph, Handle);
+  if (NodeIndex <= 0) {
+    return;
+  }
+  Graph->NodeOfSlot[BusHandleSlot(Handle)] = -1;
+  Graph->Nodes[NodeIndex] = Graph->Nodes[--Graph->NodeCount];
+  if (NodeIndex < Graph->NodeCount) {
+    Graph->NodeOfSlot[BusHandleSlot(Graph->Nodes[NodeIndex].Handle)] = NodeIndex;
+  }
+  for (NodeIndex = 0; NodeIndex < Graph->NodeCount; ++NodeIndex) {
+    mixer_node* Node = &Graph->Nodes[NodeIndex];
+    if (Node->Output == Handle) {
+      Node->Output = 0;
+    }
+    if (Node->Sidechain == Handle) {
+      Node->Sidechain = BUS_HANDLE_NONE;
+    }
+    for (i32 SendIndex = 0; SendIndex < Node->SendCount; ++SendIndex) {
+      if (Node->Sends[SendIndex].Target == Handle) {
+        Node->Sends[SendIndex--] = Node->Sends[--Node->SendCount];
+      }
+    }
+  }
+  Graph->Dirty = 1;
+}
+
+void MixerGraphFree(mixer_graph* Graph) {
+  if (Graph->Nodes) {
+    M_Free(Graph->Nodes, sizeof(mixer_node) * Graph->NodeCapacity);
+  }
+  if (Graph->NodeOfSlot) {
+    M_Free(Graph->NodeOfSlot, sizeof(i32) * Graph->SlotCapacity);
+  }
+  Graph->Nodes = NULL;
+  Graph->NodeCount = Graph->NodeCapacity = 0;
+  Graph->NodeOfSlot = NULL;
+  Graph->SlotCapacity = 0;
+}
+
+// NOTE(lucas): Kahn's algorithm, levels are longest paths. A buffer is reused once the last node reading it has run
+i32 MixerGraphCompile(mixer_graph* Graph, mixer_plan* Plan) {
+  i32 Result = NoError;
+  i32 NodeCount = Graph->NodeCount;
+  i32 MaxEdgeCount = NodeCount * (2 + MAX_BUS_SEND);
+  i32 ScratchSize = sizeof(i32) * (13 * NodeCount + 1 + 3 * MaxEdgeCount);
+  i32* Scratch = M_Calloc(ScratchSize, 1);
+  i32* Output = Scratch;
+  i32* InDegree = Output + NodeCount;
+  i32* Level = InDegree + NodeCount;
+  i32* LastUse = Level + NodeCount;
+  i32* Expiring = LastUse + NodeCount;  // First buffer that is free after each level, -1 if none
+  i32* NextExpiring = Expiring + NodeCount;
+  i32* FreeBuffers = NextExpiring + NodeCount;
+  i32* Queue = FreeBuffers + NodeCount;
+  i32* Order = Queue + NodeCount;  // Plan node of each graph node
+  i32* GraphNode = Order + NodeCount; // Graph node of each plan node
+  i32* InputCount = GraphNode + NodeCount;
+  i32* Cursor = InputCount + NodeCount;
+  i32* EdgeFrom = Cursor + NodeCount;
+  i32* EdgeTo = EdgeFrom + MaxEdgeCount;
+  i32* EdgeStart = EdgeTo + MaxEdgeCount; // The edges leaving node N are Edges[EdgeStart[N]] up to Edges[EdgeStart[N + 1]]
+  i32* Edges = EdgeStart + NodeCount + 1;
+  i32 EdgeCount = 0;
+  i32 TotalInputCount = 0;
+
+  for (i32 NodeIndex = 0; NodeIndex < NodeCount; ++NodeIndex) {
+    mixer_node* Node = &Graph->Nodes[NodeIndex];
+    Output[NodeIndex] = -1;
+    if (NodeIndex > 0) {
+      i32 Target = FindNode(Graph, Node->Output);
+      if (Target < 0) {
+        Target = 0;
+      }
+      if (Target == NodeIndex) {
+        Result = Error;
+        goto Done;
+      }
+      EdgeFrom[EdgeCount] = NodeIndex;
+      EdgeTo[EdgeCount++] = Target;
+      Output[NodeIndex] = Target;
+      ++InputCount[Target];
+    }
+    for (i32 SendIndex = 0; SendIndex < Node->SendCount; ++SendIndex) {
+      i32 Target = FindNode(Graph, Node->Sends[SendIndex].Target);
+      if (Target == NodeIndex) {
+        Result = Error;
+        goto Done;
+      }
+      if (Target >= 0) {
+        EdgeFrom[EdgeCount] = NodeIndex;
+        EdgeTo[EdgeCount++] = Target;
+        ++InputCount[Target];
+      }
+    }
+    i32 Source = FindNode(Graph, Node->Sidechain);
+    if (Source == NodeIndex) {
+      Result = Error;
+      goto Done;
+    }
+    if (Source >= 0) {
+      EdgeFrom[EdgeCount] = Source;
+      EdgeTo[EdgeCount++] = NodeIndex;
+    }
+  }
+
+  for (i32 EdgeIndex = 0; EdgeIndex < EdgeCount; ++EdgeIndex) {
+    ++EdgeStart[EdgeFrom[EdgeIndex] + 1];
+    ++InDegree[EdgeTo[EdgeIndex]];
+  }
+  for (i32 NodeIndex = 0; NodeIndex < NodeCount; ++NodeIndex) {
+    EdgeStart[NodeIndex + 1] += EdgeStart[NodeIndex];
+    Cursor[NodeIndex] = EdgeStart[NodeIndex];
+  }
+  for (i32 EdgeIndex = 0; EdgeIndex < EdgeCount; ++EdgeIndex) {
+    Edges[Cursor[EdgeFrom[EdgeIndex]]++] = EdgeTo[EdgeIndex];
+  }
+
+  i32 Head = 0;
+  i32 Tail = 0;
+  for (i32 NodeIndex = 0; NodeIndex < NodeCount; ++NodeIndex) {
+    if (InDegree[NodeIndex] == 0) {
+      Queue[Tail++] = NodeIndex;
+    }
+  }
+  i32 LevelCount = 0;
+  while (Head < Tail) {
+    i32 From = Queue[Head++];
+    LevelCount = Max(LevelCount, Level[From] + 1);
+    for (i32 EdgeIndex = EdgeStart[From]; EdgeIndex < EdgeStart[From + 1]; ++EdgeIndex) {
+      i32 To = Edges[EdgeIndex];
+      Level[To] = Max(Level[To], Level[From] + 1);
+      if (--InDegree[To] == 0) {
+        Queue[Tail++] = To;
+      }
+    }
+  }
+  if (Tail < NodeCount) {
+    Result = Error;
+    goto Done;
+  }
+  if (!Plan) {
+    goto Done;
+  }
+
+  for (i32 NodeIndex = 0; NodeIndex < NodeCount; ++NodeIndex) {
+    TotalInputCount += InputCount[NodeIndex];
+    LastUse[NodeIndex] = Level[NodeIndex];
+    for (i32 EdgeIndex = EdgeStart[NodeIndex]; EdgeIndex < EdgeStart[NodeIndex + 1]; ++EdgeIndex) {
+      LastUse[NodeIndex] = Max(LastUse[NodeIndex], Level[Edges[EdgeIndex]]);
+    }
+  }
+  PlanReserve(Plan, NodeCount, TotalInputCount);
+
+  // Group the nodes by level, keeping the order in which they were sorted within each level
+  for (i32 LevelIndex = 0; LevelIndex <= LevelCount; ++LevelIndex) {
+    Plan->LevelStart[LevelIndex] = 0;
+  }
+  for (i32 NodeIndex = 0; NodeIndex < NodeCount; ++NodeIndex) {
+    ++Plan->LevelStart[Level[NodeIndex] + 1];
+  }
+  for (i32 LevelIndex = 0; LevelIndex < LevelCount; ++LevelIndex) {
+    Plan->LevelStart[LevelIndex + 1] += Plan->LevelStart[LevelIndex];
+    Cursor[LevelIndex] = Plan->LevelStart[LevelIndex];
+  }
+  for (i32 QueueIndex = 0; QueueIndex < NodeCount; ++QueueIndex) {
+    i32 NodeIndex = Queue[QueueIndex];
+    Order[NodeIndex] = Cursor[Level[NodeIndex]]++;
+    GraphNode[Order[NodeIndex]] = NodeIndex;
+  }
+  Plan->NodeCount = NodeCount;
+  Plan->LevelCount = LevelCount;
+
+  Plan->InputCount = TotalInputCount;
+  Plan->BufferCount = 0;
+  for (i32 LevelIndex = 0; LevelIndex < LevelCount; ++LevelIndex) {
+    Expiring[LevelIndex] = -1;
+  }
+  i32 FreeCount = 0;
+  i32 InputStart = 0;
+  i32 CurrentLevel = 0;
+  for (i32 PlanIndex = 0; PlanIndex < NodeCount; ++PlanIndex) {
+    i32 NodeIndex = GraphNode[PlanIndex];
+    mixer_node* Node = &Graph->Nodes[NodeIndex];
+    plan_node* Target = &Plan->Nodes[PlanIndex];
+    i32 Source = FindNode(Graph, Node->Sidechain);
+    Target->Handle = Node->Handle;
+    Target->Level = Level[NodeIndex];
+    Target->Sidechain = Source >= 0 ? Order[Source] : -1;
+    Target->InputStart = InputStart;
+    Target->InputCount = 0;
+    InputStart += InputCount[NodeIndex];
+    Plan->Resolved[PlanIndex] = NULL;
+
+    // Buffers whose last reader ran on an earlier level are up for grabs again
+    for (; CurrentLevel < Target->Level; ++CurrentLevel) {
+      for (i32 BufferIndex = Expiring[CurrentLevel]; BufferIndex >= 0; BufferIndex = NextExpiring[BufferIndex]) {
+        FreeBuffers[FreeCount++] = BufferIndex;
+      }
+    }
+    Target->BufferIndex = -1;
+    if (!Node->ExternalBuffer) {
+      i32 BufferIndex = FreeCount > 0 ? FreeBuffers[--FreeCount] : Plan->BufferCount++;
+      NextExpiring[BufferIndex] = Expiring[LastUse[NodeIndex]];
+      Expiring[LastUse[NodeIndex]] = BufferIndex;
+      Target->BufferIndex = BufferIndex;
+    }
+  }
+
+  // NOTE(lucas): Inputs are summed in reverse order of addition, like the mixer always has
+  for (i32 From = NodeCount - 1; From >= 0; --From) {
+    mixer_node* Source = &Graph->Nodes[From];
+    if (Output[From] >= 0) {
+      plan_node* Target = &Plan->Nodes[Order[Output[From]]];
+      Plan->Inputs[Target->InputStart + Target->InputCount++] = (plan_input) { .Node = Order[From], .Gain = 1.0f, };
+    }
+    for (i32 SendIndex = 0; SendIndex < Source->SendCount; ++SendIndex) {
+      bus_send* Send = &Source->Sends[SendIndex];
+      i32 To = FindNode(Graph, Send->Target);
+      if (To >= 0) {
+        plan_node* Target = &Plan->Nodes[Order[To]];
+        Plan->Inputs[Target->InputStart + Target->InputCount++] = (plan_input) { .Node = Order[From], .Gain = Send->Gain, };
+      }
+    }
+  }
+
+Done:
+  M_Free(Scratch, ScratchSize);
+  return Result;
+}
+
+void MixerPlanFree(mixer_plan* Plan) {
+  if (Plan->NodeCapacity > 0) {
+    M_Free(Plan->Nodes, sizeof(plan_node) * Plan->NodeCapacity);
+    M_Free(Plan->Resolved, sizeof(bus*) * Plan->NodeCapacity);
+    M_Free(Plan->LevelStart, sizeof(i32) * (Plan->NodeCapacity + 1));
+    M_Free(Plan->Buffers, sizeof(f32*) * Plan->BufferCapacity);
+  }
+  if (Plan->InputCapacity > 0) {
+    M_Free(Plan->Inputs, sizeof(plan_input) * Plan->InputCapacity);
+  }
+  *Plan = (mixer_plan) {0};
+}
@@ -1,176 +1,241 @@
 // osc_test.c
 
-static float InsTime = 0;
-static i32 MelodyTable[] = {
-#if 0
-  24, 27, 29, 31,
-  24, 27, 29, 31,
-  24, 27, 29, 31,
-  32, 31, 29, 27,
-#else
-  -1,
-#endif
-};
-
-static i32 MelodyIndex = 0;
-static float InitAmp = 0.5f;
+#define OSC_VOICE_COUNT 32  // Size of the voice pool, must be a multiple of SIMD_WIDTH
+#define OSC_CHUNK_SIZE 64 // Frames rendered at a time, envelopes are linear over a chunk
+#define OSC_LEVEL 0.5f  // Gain of a voice at full velocity
 
 static float DefaultAttackTime = 0.01f;
 static float DefaultReleaseTime = 0.8f;
 
-typedef enum ins_state {
-  STATE_ATTACK = 0,
-  STATE_RELEASE,
-  STATE_DONE,
-} ins_state;
-
-typedef struct note_state {
-  float Amp;
-  float AttackTime;
-  float ReleaseTime;
-  float Velocity;
-  i32 FreqIndex;
-  ins_state State;
-} note_state;
-
-#define MAX_NOTES 32
-
-#define MAX_NOTE 127
-
-static note_state _NoteTable[MAX_NOTES] = {0};
-static i32 _NoteCount = 0;
+// NOTE(lucas): Sounding voices are packed at the front of the pool, so that the cost follows the number of voices
+typedef struct osc_voices {
+  f32 Phase[OSC_VOICE_COUNT]; // In half turns, from -1 up to 1
+  f32 Increment[OSC_VOICE_COUNT];
+  f32 Gain[OSC_VOICE_COUNT];
+  f32 Step[OSC_VOICE_COUNT];  // Change of the gain per frame over the chunk that is being rendered
+  f32 Target[OSC_VOICE_COUNT];  // Level while the key is held, zero once it is released
+  f32 Rate[OSC_VOICE_COUNT];  // Change of the gain per frame on the way to the target
+  u32 Age[OSC_VOICE_COUNT];  // Note on which started the voice, the oldest voice is stolen first
+  u8 Note[OSC_VOICE_COUNT];
+} osc_voices;
 
 typedef struct osc_test_instrument {
+  osc_voices Voices;
+  i32 ActiveCount;
+  u32 Clock;  // Note ons so far
 } osc_test_instrument;
 
-inline i32 Sign(float Value);
-static float SineWave(i32 Tick, i32 FreqIndex, i32 SampleRate);
-static float SquareWave(i32 Tick, i32 FreqIndex, i32 SampleRate);
-static void ClearNoteTable(note_state* Table, i32* Count);
+static i32 VoiceFind(osc_test_instrument* Osc, u8 Note);
+static i32 VoiceAllocate(osc_test_instrument* Osc);
+static void VoiceNoteOn(osc_test_instrument* Osc, u8 Note, f32 Velocity, i32 SampleRate);
+static void VoiceNoteOff(osc_test_instrument* Osc, u8 Note, i32 SampleRate);
+static void VoiceRetire(osc_test_instrument* Osc);
+static void VoiceRender(osc_test_instrument* Osc, f32* Out, i32 FrameCount);
+static void HandleMidiEvent(osc_test_instrument* Osc, midi_event* Event, i32 SampleRate);
 
-i32 Sign(float Value) {
-  return Value >= 0 ? 1 : -1;
+i32 VoiceFind(osc_test_instrument* Osc, u8 Note) {
+  for (i32 Index = 0; Index < Osc->ActiveCount; ++Index) {
+    if (Osc->Voices.Note[Index] == Note) {
+      return Index;
+    }
+  }
+  return -1;
 }
 
-float SineWave(i32 Tick, i32 FreqIndex, i32 SampleRate) {
-  float Freq = FreqTable[FreqIndex % FreqTableSize];
-  return Sin((Tick * Freq * 2 * PI32) / (float)SampleRate);
+// NOTE(lucas): A stolen voice glides from its phase and gain, so that it doesn't click
+i32 VoiceAllocate(osc_test_instrument* Osc) {
+  osc_voices* Voices = &Osc->Voices;
+  if (Osc->ActiveCount < OSC_VOICE_COUNT) {
+    i32 Index = Osc->ActiveCount++;
+    Voices->Phase[Index] = 0;
+    Voices->Gain[Index] = 0;
+    return Index;
+  }
+  i32 Oldest = 0;
+  i32 OldestReleased = -1;
+  for (i32 Index = 0; Index < OSC_VOICE_COUNT; ++Index) {
+    u32 Age = Osc->Clock - Voices->Age[Index];
+    if (Age > Osc->Clock - Voices->Age[Oldest]) {
+      Oldest = Index;
+    }
+    if (Voices->Target[Index] == 0 && (OldestReleased < 0 || Age > Osc->Clock - Voices->Age[OldestReleased])) {
+      OldestReleased = Index;
+    }
+  }
+  return OldestReleased >= 0 ? OldestReleased : Oldest;
+}
+
+// A key that is still sounding is retriggered on the voice that it already has
+void VoiceNoteOn(osc_test_instrument* Osc, u8 Note, f32 Velocity, i32 SampleRate) {
+  osc_voices* Voices = &Osc->Voices;
+  i32 Index = VoiceFind(Osc, Note);
+  if (Index < 0) {
+    Index = VoiceAllocate(Osc);
+  }
+  f32 Freq = FreqTable[Note % FreqTableSize];
+  Voices->Increment[Index] = Min(2.0f * Freq / SampleRate, 1.0f);
+  Voices->Target[Index] = OSC_LEVEL * Velocity;
+  Voices->Rate[Index] = Voices->Target[Index] / (DefaultAttackTime * SampleRate);
+  Voices->Age[Index] = Osc->Clock++;
+  Voices->Note[Index] = Note;
 }
 
-float SquareWave(i32 Tick, i32 FreqIndex, i32 SampleRate) {
-  float Freq = FreqTable[FreqIndex % FreqTableSize];
-  return Sign(Sin((Tick * Freq * 2 * PI32) / SampleRate));
+void VoiceNoteOff(osc_test_instrument* Osc, u8 Note, i32 SampleRate) {
+  osc_voices* Voices = &Osc->Voices;
+  i32 Index = VoiceFind(Osc, Note);
+  if (Index >= 0 && Voices->Target[Index] > 0) {
+    Voices->Target[Index] = 0;
+    Voices->Rate[Index] = Voices->Gain[Index] / (DefaultReleaseTime * SampleRate);
+  }
 }
 
-void ClearNoteTable(note_state* Table, i32* Count) {
-  for (i32 NoteIndex = 0; NoteIndex < *Count; ++NoteIndex) {
-    note_state* Note = &Table[NoteIndex];
-    if (Note->State == STATE_DONE) {
-      *Note = Table[--(*Count)];
-      --NoteIndex;
+// Voices that have faded out are swapped with the last active voice, and their slot is silenced
+void VoiceRetire(osc_test_instrument* Osc) {
+  osc_voices* Voices = &Osc->Voices;
+  for (i32 Index = 0; Index < Osc->ActiveCount; ++Index) {
+    if (Voices->Target[Index] > 0 || Voices->Gain[Index] > 0) {
       continue;
     }
+    i32 Last = --Osc->ActiveCount;
+    Voices->Phase[Index] = Voices->Phase[Last];
+    Voices->Increment[Index] = Voices->Increment[Last];
+    Voices->Gain[Index] = Voices->Gain[Last];
+    Voices->Target[Index] = Voices->Target[Last];
+    Voices->Rate[Index] = Voices->Rate[Last];
+    Voices->Age[Index] = Voices->Age[Last];
+    Voices->Note[Index] = Voices->Note[Last];
+    Voices->Phase[Last] = 0;
+    Voices->Increment[Last] = 0;
+    Voices->Gain[Last] = 0;
+    Voices->Step[Last] = 0;
+    --Index;
   }
 }
 
-note_state* OscTestPlayNote(i32 FreqIndex, float AttackTime, float ReleaseTime, float Velocity) {
-  if (_NoteCount < MAX_NOTES) {
-    note_state Note = (note_state) {
-      .Amp = 0.0f,
-      .AttackTime = AttackTime,
-      .ReleaseTime = ReleaseTime,
-      .Velocity = Velocity,
-      .FreqIndex = FreqIndex,
-      .State = STATE_ATTACK,
-    };
-    _NoteTable[_NoteCount] = Note;
-    return &_NoteTable[_NoteCount++];
-  }
-  return NULL;
-}
+// NOTE(lucas): sin(pi * x) for x in [-1, 1), fitted by least squares, the error is around 1e-5
+#define OSC_SIN_C0 3.14153577f
+#define OSC_SIN_C1 -2.02497355f
+#define OSC_SIN_C2 0.51811947f
+#define OSC_SIN_C3 -0.06421765f
 
-// TODO(lucas): Generalized ADSR
-i32 OscTestProcess(instrument* Ins, bus* Bus, i32 FramesPerBuffer, i32 SampleRate) {
-  TIMER_START();
-
-  (void)InitAmp;
-  (void)SquareWave;
-  float* Iter = Bus->Buffer;
-  i32 Tick = AudioEngine.Tick;
-  float Time = AudioEngine.Time;
-  float DeltaTime = AudioEngine.DeltaTime;
-
-  (void)DeltaTime;
-
-  float TimeStamp = InsTime + (60.0f / TempoBPM);
-  if (Time >= TimeStamp) {
-    float Delta = Time - TimeStamp;
-    InsTime = Time - Delta;
-    i32 Note = MelodyTable[MelodyIndex];
-    if (Note >= 0) {
-      note_state* NewNote = OscTestPlayNote(MelodyTable[MelodyIndex], DefaultAttackTime, DefaultReleaseTime, 0.5f);
-      if (NewNote) {
-        NewNote->Velocity = 0.25f;
-      }
+void VoiceRender(osc_test_instrument* Osc, f32* Out, i32 FrameCount) {
+  Assert(FrameCount <= OSC_CHUNK_SIZE);
+  osc_voices* Voices = &Osc->Voices;
+  if (Osc->ActiveCount == 0) {
+    memset(Out, 0, sizeof(f32) * FrameCount);
+    return;
+  }
+  // The envelope goes in a straight line to where it will be at the end of the chunk
+  f32 End[OSC_VOICE_COUNT];
+  for (i32 Index = 0; Index < Osc->ActiveCount; ++Index) {
+    f32 Gain = Voices->Gain[Index];
+    f32 Target = Voices->Target[Index];
+    f32 Change = Voices->Rate[Index] * FrameCount;
+    End[Index] = Gain < Target ? Min(Gain + Change, Target) : Max(Gain - Change, Target);
+    Voices->Step[Index] = (End[Index] - Gain) / FrameCount;
+  }
+
+#if defined(SIMD_WIDTH)
+  f32 Sum[OSC_CHUNK_SIZE * SIMD_WIDTH]; // Sum of every lane for every frame
+  const simd_f32 One = SimdSet1(1.0f);
+  const simd_f32 Two = SimdSet1(2.0f);
+  i32 GroupCount = (Osc->ActiveCount + SIMD_WIDTH - 1) / SIMD_WIDTH;
+  for (i32 Group = 0; Group < GroupCount; ++Group) {
+    i32 Offset = Group * SIMD_WIDTH;
+    simd_f32 Phase = SimdLoad(&Voices->Phase[Offset]);
+    simd_f32 Increment = SimdLoad(&Voices->Increment[Offset]);
+    simd_f32 Gain = SimdLoad(&Voices->Gain[Offset]);
+    simd_f32 Step = SimdLoad(&Voices->Step[Offset]);
+    for (i32 FrameIndex = 0; FrameIndex < FrameCount; ++FrameIndex) {
+      Phase = SimdAdd(Phase, Increment);
+      Phase = SimdSub(Phase, SimdAnd(SimdCmpGe(Phase, One), Two));
+      simd_f32 X2 = SimdMul(Phase, Phase);
+      simd_f32 Poly = SimdAdd(SimdSet1(OSC_SIN_C2), SimdMul(X2, SimdSet1(OSC_SIN_C3)));
+      Poly = SimdAdd(SimdSet1(OSC_SIN_C1), SimdMul(X2, Poly));
+      Poly = SimdAdd(SimdSet1(OSC_SIN_C0), SimdMul(X2, Poly));
+      simd_f32 Sine = SimdMul(SimdMul(Phase, SimdSub(One, X2)), Poly);
+      simd_f32 Sample = SimdMul(Gain, Sine);
+      f32* Lanes = &Sum[FrameIndex * SIMD_WIDTH];
+      SimdStore(Lanes, Group == 0 ? Sample : SimdAdd(SimdLoad(Lanes), Sample));
+      Gain = SimdAdd(Gain, Step);
     }
-    MelodyIndex = (MelodyIndex + 1) % ArraySize(MelodyTable);
-  }
-
-  ClearNoteTable(&_NoteTable[0], &_NoteCount);
-  for (i32 FrameIndex = 0; FrameIndex < FramesPerBuffer; ++FrameIndex, ++Tick) {
-    float Frame0 = 0.0f;
-    float Frame1 = 0.0f;
-#if 0
-    for (i32 NoteIndex = 0; NoteIndex < _NoteCount; ++NoteIndex) {
-      note_state* Note = &_NoteTable[NoteIndex];
-      switch (Note->State) {
-        case STATE_ATTACK: {
-          Note->Amp += (1.0f / Note->AttackTime / 60.0f) * DeltaTime;
-          if (Note->Amp >= InitAmp) {
-            Note->State = STATE_RELEASE;
-          }
-          break;
-        }
-        case STATE_RELEASE: {
-          Note->Amp -= (1.0f / Note->ReleaseTime / 60.0f) * DeltaTime;
-          if (Note->Amp < 0.0f) {
-            Note->Amp = 0.0f;
-            Note->State = STATE_DONE;
-          }
-          break;
-        }
-        case STATE_DONE: {
-          break;
-        }
-        default:
-          break;
-      }
-      Frame0 += Note->Velocity * Note->Amp * SineWave(Tick, Note->FreqIndex, SampleRate);
-      Frame1 += Note->Velocity * Note->Amp * SineWave(Tick, Note->FreqIndex, SampleRate);
+    SimdStore(&Voices->Phase[Offset], Phase);
+  }
+  for (i32 FrameIndex = 0; FrameIndex < FrameCount; ++FrameIndex) {
+    f32 Frame = 0;
+    for (i32 Lane = 0; Lane < SIMD_WIDTH; ++Lane) {
+      Frame += Sum[FrameIndex * SIMD_WIDTH + Lane];
     }
+    Out[FrameIndex] = Frame;
+  }
+#else
+  memset(Out, 0, sizeof(f32) * FrameCount);
+  for (i32 Index = 0; Index < Osc->ActiveCount; ++Index) {
+    f32 Phase = Voices->Phase[Index];
+    f32 Gain = Voices->Gain[Index];
+    for (i32 FrameIndex = 0; FrameIndex < FrameCount; ++FrameIndex) {
+      Phase += Voices->Increment[Index];
+      Phase -= Phase >= 1.0f ? 2.0f : 0.0f;
+      f32 X2 = Phase * Phase;
+      f32 Poly = OSC_SIN_C0 + X2 * (OSC_SIN_C1 + X2 * (OSC_SIN_C2 + X2 * OSC_SIN_C3));
+      Out[FrameIndex] += Gain * Phase * (1.0f - X2) * Poly;
+      Gain += Voices->Step[Index];
+    }
+    Voices->Phase[Index] = Phase;
+  }
 #endif
-    for (i32 NoteIndex = 0; NoteIndex < MAX_NOTE; ++NoteIndex) {
-      float NoteIsPressed = NoteTable[NoteIndex];
-      if (NoteIsPressed > 0.0f) {
-        Frame0 += NoteIsPressed * 0.5f * SineWave(Tick, NoteIndex, SampleRate);
-        Frame1 += NoteIsPressed * 0.5f * SineWave(Tick, NoteIndex, SampleRate);
+
+  for (i32 Index = 0; Index < Osc->ActiveCount; ++Index) {
+    Voices->Gain[Index] = End[Index];
+  }
+  VoiceRetire(Osc);
+}
+
+void HandleMidiEvent(osc_test_instrument* Osc, midi_event* Event, i32 SampleRate) {
+  u8 Note = Event->A & 0x7f;
+  switch (Event->Message & 0xf0) {
+    case MIDI_NOTE_ON: {
+      if (Event->B > 0) {
+        VoiceNoteOn(Osc, Note, (float)Event->B / UINT8_MAX, SampleRate);
       }
+      else {
+        VoiceNoteOff(Osc, Note, SampleRate);
+      }
+      break;
     }
-    if (Bus->ChannelCount == 2) {
-      *(Iter++) = Frame0;
-      *(Iter++) = Frame1;
-    }
-    else {
-      *(Iter++) = 0.5f * Frame0 + 0.5f * Frame1;
+    case MIDI_NOTE_OFF: {
+      VoiceNoteOff(Osc, Note, SampleRate);
+      break;
     }
+    default:
+      break;
   }
+}
 
-  // WeirdEffect2(Bus->Buffer, Bus->ChannelCount, FramesPerBuffer, 0.02f, 50.0f);
-  // Distortion(Bus->Buffer, Bus->ChannelCount, FramesPerBuffer, 0.5f, 230.0f);
-  // WeirdEffect(Bus->Buffer, Bus->ChannelCount, FramesPerBuffer, 0.5f, 100.0f);
-  // Distortion(Bus->Buffer, Bus->ChannelCount, FramesPerBuffer, 0.5f, 230.0f);
+// Rendering is split at every MIDI event, so that events land on their own frame
+i32 OscTestProcess(instrument* Ins, bus* Bus, i32 FramesPerBuffer, i32 SampleRate) {
+  osc_test_instrument* Osc = (osc_test_instrument*)Ins->UserData.Data;
+  float* Left = &Bus->Buffer[0];
+  float* Right = &Bus->Buffer[Bus->Stride];
+  i32 EventIndex = 0;
+  for (i32 Offset = 0; Offset < FramesPerBuffer;) {
+    for (; EventIndex < Bus->MidiEventCount && Bus->MidiEvents[EventIndex].Frame <= Offset; ++EventIndex) {
+      HandleMidiEvent(Osc, &Bus->MidiEvents[EventIndex].Event, SampleRate);
+    }
+    i32 End = Min(Offset + OSC_CHUNK_SIZE, FramesPerBuffer);
+    if (EventIndex < Bus->MidiEventCount) {
+      End = Min(End, Bus->MidiEvents[EventIndex].Frame);
+    }
+    VoiceRender(Osc, &Left[Offset], End - Offset);
+    Offset = End;
+  }
+  for (; EventIndex < Bus->MidiEventCount; ++EventIndex) {
+    HandleMidiEvent(Osc, &Bus->MidiEvents[EventIndex].Event, SampleRate);
+  }
+  if (Bus->ChannelCount == 2) {
+    memcpy(Right, Left, sizeof(float) * FramesPerBuffer);
+  }
 
-  TIMER_END();
   return NoError;
 }
 
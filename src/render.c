@@ -0,0 +1,177 @@
+// render.c
+// headless offline rendering of a session, driving the audio engine as fast as possible
+
+typedef struct render_args {
+  char* SessionPath;
+  char* OutputPath;
+  f32 Duration;
+  i32 FramesPerBuffer;
+  i32 PrintLoad;
+  i32 PrintProfile;
+} render_args;
+
+static i32 LoadSession(mixer* Mixer, const char* Path);
+static i32 RenderRun(render_args* Args);
+
+// NOTE(lucas): An instrument per line, '+ effect' lines fill the inserts of the bus above, '#' lines are comments
+i32 LoadSession(mixer* Mixer, const char* Path) {
+  i32 Result = NoError;
+  buffer Source;
+  if ((Result = ReadFile(Path, &Source)) != NoError) {
+    fprintf(stderr, "Failed to read session file '%s'\n", Path);
+    return Result;
+  }
+
+  i32 Count = 0;
+  bus_handle Handle = BUS_HANDLE_NONE;
+  i32 InsertCount = 0;
+  char* Iter = Source.Data;
+  char* End = Source.Data + Source.Count;
+  while (Iter < End) {
+    char* Line = Iter;
+    while (Iter < End && *Iter != '\n') {
+      ++Iter;
+    }
+    u32 Length = Iter - Line;
+    ++Iter;
+    while (Length > 0 && (Line[Length - 1] == '\r' || Line[Length - 1] == ' ' || Line[Length - 1] == '\t')) {
+      --Length;
+    }
+    if (Length == 0 || Line[0] == '#') {
+      continue;
+    }
+    // NOTE(lucas): Make room in the command queue for sessions with more buses than it can hold
+    if (SpscQueueSpace(&Mixer->Commands) == 0) {
+      MixerProcessCommands(Mixer);
+    }
+    if (Line[0] == '+') {
+      u32 Skip = 1;
+      while (Skip < Length && (Line[Skip] == ' ' || Line[Skip] == '\t')) {
+        ++Skip;
+      }
+      i32 Type = EffectFindDef(Line + Skip, Length - Skip);
+      if (Type < 0) {
+        fprintf(stderr, "%s: No effect named '%.*s'\n", Path, Length - Skip, Line + Skip);
+        Result = Error;
+        break;
+      }
+      if (Handle == BUS_HANDLE_NONE || InsertCount >= MAX_INSERT_SLOT) {
+        fprintf(stderr, "%s: No bus with a free insert slot for '%.*s'\n", Path, Length - Skip, Line + Skip);
+        Result = Error;
+        break;
+      }
+      if (MixerSetInsert(Mixer, Handle, InsertCount++, Type) != NoError) {
+        fprintf(stderr, "%s: Failed to create effect '%.*s'\n", Path, Length - Skip, Line + Skip);
+        Result = Error;
+        break;
+      }
+      continue;
+    }
+    ++Count;
+    i32 Type = InstrumentFindDef(Line, Length);
+    if (Type < 0) {
+      fprintf(stderr, "%s: No instrument named '%.*s'\n", Path, Length, Line);
+      Result = Error;
+      break;
+    }
+    Handle = BUS_HANDLE_NONE;
+    InsertCount = 0;
+    MixerAddBus(Mixer, 2, NULL, InstrumentCreate(Type), &Handle);
+  }
+  BufferFree(&Source);
+  // NOTE(lucas): There is no audio thread when rendering, so we apply the commands ourselves
+  MixerProcessCommands(Mixer);
+  MixerUpdate(Mixer);
+  if (Result == NoError && MixerBusCount(Mixer) - 1 < Count) {
+    fprintf(stderr, "%s: Could only add %i out of %i instruments\n", Path, MixerBusCount(Mixer) - 1, Count);
+  }
+  return Result;
+}
+
+i32 RenderRun(render_args* Args) {
+  i32 Result = NoError;
+  audio_engine* Engine = &AudioEngine;
+  mixer* Mixer = &Engine->Mixer;
+  i32 SampleRate = G_SampleRate;
+  i32 FramesPerBuffer = Args->FramesPerBuffer > 0 ? Args->FramesPerBuffer : G_FramesPerBuffer;
+
+  MixerInit(Mixer, SampleRate, FramesPerBuffer);
+  InstrumentHandlerInit();
+  AudioEngineOfflineInit(SampleRate, FramesPerBuffer);
+
+  if ((Result = LoadSession(Mixer, Args->SessionPath)) == NoError) {
+    wave_writer Writer;
+    if ((Result = WaveWriterOpen(&Writer, Args->OutputPath, SampleRate, MASTER_CHANNEL_COUNT, WaveInt16)) == NoError) {
+      MixerWaitInstruments(Mixer);
+      f32* OutBuffer = M_Calloc(sizeof(f32), MASTER_CHANNEL_COUNT * FramesPerBuffer);
+      i64 FrameCount = (i64)(Args->Duration * SampleRate);
+      i64 FramesRendered = 0;
+      Mixer->Active = 1;
+
+      REAL_TIMER_START();
+      while (FramesRendered < FrameCount) {
+        i32 Frames = Min(FrameCount - FramesRendered, FramesPerBuffer);
+        AudioEngineProcessFrames(NULL, OutBuffer, Frames);
+        if ((Result = WaveWriterWrite(&Writer, OutBuffer, Frames * MASTER_CHANNEL_COUNT)) != NoError) {
+          break;
+        }
+        FramesRendered += Frames;
+      }
+      REAL_TIMER_END(
+        f64 AudioTime = (f64)FramesRendered / SampleRate;
+        fprintf(stdout, "Rendered %g s of audio to '%s' in %g s (%.2fx real time)\n", AudioTime, Args->OutputPath, _DeltaTime, _DeltaTime > 0 ? AudioTime / _DeltaTime : 0);
+      );
+
+      if (Args->PrintLoad) {
+        DspLoadPrint(&Engine->Load, stdout);
+      }
+      if (Args->PrintProfile) {
+        MixerPrintProfile(Mixer, stdout);
+      }
+      Mixer->Active = 0;
+      WaveWriterClose(&Writer);
+      M_Free(OutBuffer, sizeof(f32) * MASTER_CHANNEL_COUNT * FramesPerBuffer);
+    }
+  }
+  MixerFree(Mixer);
+  InstrumentHandlerFree();
+  return Result;
+}
+
+i32 Render(i32 argc, char** argv) {
+  i32 Result = NoError;
+
+  render_args Args = {
+    .SessionPath = NULL,
+    .OutputPath = "render.wav",
+    .Duration = 10.0f,
+    .FramesPerBuffer = 0,
+    .PrintLoad = 0,
+    .PrintProfile = 0,
+  };
+
+  parse_arg Arguments[] = {
+    {0, NULL, "path to session file", ArgString, 0, &Args.SessionPath},
+    {'o', "output-path", "path to output audio file (default: render.wav)", ArgString, 1, &Args.OutputPath},
+    {'t', "time", "duration to render in seconds (default: 10)", ArgFloat, 1, &Args.Duration},
+    {'f', "frames-per-buffer", "number of frames to process per buffer (default: frames_per_buffer from config)", ArgInt, 1, &Args.FramesPerBuffer},
+    {'l', "load", "print the dsp load (relative to the buffer period) and xruns when done", ArgInt, 0, &Args.PrintLoad},
+    {'p', "profile", "print the cpu load of every bus when done", ArgInt, 0, &Args.PrintProfile},
+  };
+  Result = ParseArgs(Arguments, ArraySize(Arguments), argc, argv);
+  if (Result == Error) {
+    return Result;
+  }
+  else if (Result == HelpStatus) {
+    return NoError;
+  }
+  if (!Args.SessionPath) {
+    fprintf(stderr, "No session file was given\n");
+    return Error;
+  }
+  if (Args.Duration <= 0) {
+    fprintf(stderr, "Invalid render duration (%g s)\n", Args.Duration);
+    return Error;
+  }
+  return RenderRun(&Args);
+}
@@ -1,8 +1,15 @@
 // riff.c
 
 #include <limits.h>
+#include <sys/uio.h>
+
+#if __linux__
+#include <sys/syscall.h>
+#endif
 
 static char RiffId[] = {'R', 'I', 'F', 'F'};
+static char Rf64Id[] = {'R', 'F', '6', '4'};
+static char Ds64Id[] = {'d', 's', '6', '4'};
 static char WaveId[] = {'W', 'A', 'V', 'E'};
 static char DataChunkId[] = {'d', 'a', 't', 'a'};
 static char ChunkListId[] = {'L', 'I', 'S', 'T'};
@@ -53,7 +60,7 @@ static void PrintWaveChunk(wave_chunk* Header) {
 }
 
 static i32 ValidateWaveHeader(wave_header* Header) {
-  if (strncmp(Header->RiffId, RiffId, ArraySize(RiffId)) != 0) {
+  if (strncmp(Header->RiffId, RiffId, ArraySize(RiffId)) != 0 && strncmp(Header->RiffId, Rf64Id, ArraySize(Rf64Id)) != 0) {
     return Error;
   }
   if (strncmp(Header->WaveId, WaveId, ArraySize(WaveId)) != 0) {
@@ -67,10 +74,16 @@ static i32 ValidateWaveFormat(wave_format* Header) {
   if (strncmp(Header->FormatId, FormatId, ArraySize(FormatId)) != 0) {
     return Error;
   }
-  if (Header->Type != FORMAT_PCM) {
+  if (Header->ChannelCount <= 0) {
     return Error;
   }
-  return NoError;
+  if (Header->Type == FORMAT_PCM && (Header->BitsPerSample == 16 || Header->BitsPerSample == 24 || Header->BitsPerSample == 32)) {
+    return NoError;
+  }
+  if (Header->Type == FORMAT_IEEE_FLOAT && Header->BitsPerSample == 32) {
+    return NoError;
+  }
+  return Error;
 }
 
 static i32 ValidateWaveChunk(wave_chunk* Header, i32* HasListTag) {
@@ -111,7 +124,7 @@ static void InitWaveFormat(wave_format* Header, i32 SampleRate, i32 ChannelCount
   Header->ChannelCount = ChannelCount;
   Header->SampleRate = SampleRate;
   Header->DataRate = (SampleRate * ChannelCount * BitsPerSample) / 8;
-  Header->DataBlockSize = BitsPerSample / 8;
+  Header->DataBlockSize = (ChannelCount * BitsPerSample) / 8;
   Header->BitsPerSample = BitsPerSample;
 }
 
@@ -177,6 +190,297 @@ Done:
   return Result;
 }
 
+i32 WaveSampleSize(wave_sample_format Format) {
+  switch (Format) {
+    case WaveInt16:
+      return 2;
+    case WaveInt24:
+      return 3;
+    case WaveFloat32:
+      return 4;
+  }
+  return 0;
+}
+
+#define WAVE_WRITE_VECTORS 16
+
+// Convert SampleCount samples into the sample format of the file, float samples are left where they are
+static void* EncodeSamples(wave_sample_format Format, f32* Buffer, u32 SampleCount, u8* Dest) {
+  switch (Format) {
+    case WaveInt16: {
+      i16* Samples = (i16*)Dest;
+      for (u32 SampleIndex = 0; SampleIndex < SampleCount; ++SampleIndex) {
+        f32 Sample = Buffer[SampleIndex];
+        Samples[SampleIndex] = (i16)((Clamp(Sample, -1.0f, 1.0f)) * INT16_MAX);
+      }
+      return Dest;
+    }
+    case WaveInt24: {
+      u8* Samples = Dest;
+      for (u32 SampleIndex = 0; SampleIndex < SampleCount; ++SampleIndex) {
+        f32 Sample = Buffer[SampleIndex];
+        i32 Value = (i32)((Clamp(Sample, -1.0f, 1.0f)) * 8388607.0f);
+        *Samples++ = Value & 0xff;
+        *Samples++ = (Value >> 8) & 0xff;
+        *Samples++ = (Value >> 16) & 0xff;
+      }
+      return Dest;
+    }
+    case WaveFloat32:
+      break;
+  }
+  return Buffer;
+}
+
+// Write all of the vectors, picking up where a partial write left off
+static i32 WriteVectors(wave_writer* Writer, struct iovec* Vectors, i32 VectorCount) {
+  i32 Fd = fileno(Writer->File);
+  while (VectorCount > 0) {
+    ssize_t Written = writev(Fd, Vectors, VectorCount);
+    if (Written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      fprintf(stderr, "%s: Failed to write samples (%s)\n", __FUNCTION__, strerror(errno));
+      return Error;
+    }
+    while (VectorCount > 0 && (size_t)Written >= Vectors->iov_len) {
+      Written -= Vectors->iov_len;
+      ++Vectors;
+      --VectorCount;
+    }
+    if (VectorCount > 0) {
+      Vectors->iov_base = (u8*)Vectors->iov_base + Written;
+      Vectors->iov_len -= Written;
+    }
+  }
+  return NoError;
+}
+
+static i32 WriteAt(wave_writer* Writer, i64 Offset, const void* Data, i32 Size) {
+  if (pwrite(fileno(Writer->File), Data, Size, Offset) != Size) {
+    fprintf(stderr, "%s: Failed to update WAVE header\n", __FUNCTION__);
+    return Error;
+  }
+  return NoError;
+}
+
+// The header is written with zero sizes, and is patched as samples are written
+i32 WaveWriterOpen(wave_writer* Writer, const char* Path, i32 SampleRate, i32 ChannelCount, wave_sample_format Format) {
+  Writer->File = fopen(Path, "wb");
+  Writer->SampleRate = SampleRate;
+  Writer->ChannelCount = ChannelCount;
+  Writer->SampleCount = 0;
+  Writer->Format = Format;
+  Writer->Allocated = 0;
+  Writer->Rf64 = 0;
+  if (!Writer->File) {
+    fprintf(stderr, "Failed to open file '%s'\n", Path);
+    return Error;
+  }
+
+  wave_header WaveHeader;
+  InitWaveHeader(&WaveHeader, 0);
+
+  wave_chunk JunkChunk = { .ChunkId = {'J', 'U', 'N', 'K'}, .Size = WAVE_DS64_SIZE };
+  u8 Junk[WAVE_DS64_SIZE] = {0};
+
+  i16 BitsPerSample = 8 * WaveSampleSize(Format);
+  wave_format WaveFormat;
+  InitWaveFormat(&WaveFormat, SampleRate, ChannelCount, BitsPerSample);
+  i16 ExtensionSize = 0;
+  if (Format == WaveFloat32) {
+    WaveFormat.Type = FORMAT_IEEE_FLOAT;
+    WaveFormat.Size += sizeof(ExtensionSize);
+  }
+
+  wave_chunk WaveChunk;
+  InitWaveDataChunk(&WaveChunk, 0);
+
+  fwrite(&WaveHeader, 1, sizeof(wave_header), Writer->File);
+  fwrite(&JunkChunk, 1, sizeof(wave_chunk), Writer->File);
+  fwrite(Junk, 1, sizeof(Junk), Writer->File);
+  fwrite(&WaveFormat, 1, sizeof(wave_format), Writer->File);
+  if (Format == WaveFloat32) {
+    fwrite(&ExtensionSize, 1, sizeof(ExtensionSize), Writer->File);
+  }
+  Writer->DataSizeOffset = ftell(Writer->File) + 4;
+  fwrite(&WaveChunk, 1, sizeof(wave_chunk), Writer->File);
+  Writer->DataOffset = ftell(Writer->File);
+  return NoError;
+}
+
+i32 WaveWriterWrite(wave_writer* Writer, float* Buffer, u32 SampleCount) {
+  u8 Chunk[3 * MAX_BUFFER_SIZE];
+  if (!Writer->File) {
+    return Error;
+  }
+  i32 SampleSize = WaveSampleSize(Writer->Format);
+  while (SampleCount > 0) {
+    u32 Count = Min(SampleCount, MAX_BUFFER_SIZE);
+    void* Data = EncodeSamples(Writer->Format, Buffer, Count, Chunk);
+    if (fwrite(Data, SampleSize, Count, Writer->File) != Count) {
+      fprintf(stderr, "%s: Failed to write samples\n", __FUNCTION__);
+      return Error;
+    }
+    Writer->SampleCount += Count;
+    Buffer += Count;
+    SampleCount -= Count;
+  }
+  return NoError;
+}
+
+// NOTE(lucas): Goes around stdio, to gather the buffers into as few system calls as possible
+i32 WaveWriterWriteV(wave_writer* Writer, float** Buffers, u32* SampleCounts, i32 BufferCount) {
+  u8 Staging[WAVE_WRITE_VECTORS][3 * MAX_BUFFER_SIZE];
+  struct iovec Vectors[WAVE_WRITE_VECTORS];
+  if (!Writer->File) {
+    return Error;
+  }
+  fflush(Writer->File);
+  i32 SampleSize = WaveSampleSize(Writer->Format);
+  i32 VectorCount = 0;
+  i64 SampleCount = 0;  // Samples in the vectors
+  for (i32 BufferIndex = 0; BufferIndex < BufferCount; ++BufferIndex) {
+    f32* Buffer = Buffers[BufferIndex];
+    u32 Left = SampleCounts[BufferIndex];
+    while (Left > 0) {
+      u32 Count = Writer->Format == WaveFloat32 ? Left : Min(Left, MAX_BUFFER_SIZE);
+      void* Data = EncodeSamples(Writer->Format, Buffer, Count, Staging[VectorCount]);
+      Vectors[VectorCount++] = (struct iovec) { .iov_base = Data, .iov_len = (size_t)Count * SampleSize };
+      SampleCount += Count;
+      Buffer += Count;
+      Left -= Count;
+      if (VectorCount == WAVE_WRITE_VECTORS) {
+        if (WriteVectors(Writer, Vectors, VectorCount) != NoError) {
+          return Error;
+        }
+        Writer->SampleCount += SampleCount;
+        SampleCount = 0;
+        VectorCount = 0;
+      }
+    }
+  }
+  if (VectorCount > 0) {
+    if (WriteVectors(Writer, Vectors, VectorCount) != NoError) {
+      return Error;
+    }
+    Writer->SampleCount += SampleCount;
+  }
+  return NoError;
+}
+
+// NOTE(lucas): stdio is flushed first, so that the sizes never cover more than what is in the file
+i32 WaveWriterUpdateHeader(wave_writer* Writer) {
+  if (!Writer->File) {
+    return Error;
+  }
+  fflush(Writer->File);
+  u64 DataSize = (u64)Writer->SampleCount * WaveSampleSize(Writer->Format);
+  u64 RiffSize = Writer->DataOffset + DataSize + (DataSize & 1) - 8;
+  if (RiffSize > UINT32_MAX) {
+    Writer->Rf64 = 1;
+  }
+  i32 Result = NoError;
+  if (Writer->Rf64) {
+    u8 Header[8] = {'R', 'F', '6', '4', 0xff, 0xff, 0xff, 0xff};
+    u8 Ds64[sizeof(wave_chunk) + WAVE_DS64_SIZE] = {'d', 's', '6', '4', WAVE_DS64_SIZE, 0, 0, 0};
+    u64 FrameCount = Writer->SampleCount / Writer->ChannelCount;
+    memcpy(&Ds64[8], &RiffSize, sizeof(u64));
+    memcpy(&Ds64[16], &DataSize, sizeof(u64));
+    memcpy(&Ds64[24], &FrameCount, sizeof(u64));
+    u32 Unknown = UINT32_MAX;
+    Result |= WriteAt(Writer, sizeof(wave_header), Ds64, sizeof(Ds64));
+    Result |= WriteAt(Writer, Writer->DataSizeOffset, &Unknown, sizeof(u32));
+    Result |= WriteAt(Writer, 0, Header, sizeof(Header));
+  }
+  else {
+    u32 Size = (u32)RiffSize;
+    u32 DataChunkSize = (u32)DataSize;
+    Result |= WriteAt(Writer, Writer->DataSizeOffset, &DataChunkSize, sizeof(u32));
+    Result |= WriteAt(Writer, 4, &Size, sizeof(u32));
+  }
+  return Result ? Error : NoError;
+}
+
+i32 WaveWriterPreallocate(wave_writer* Writer, i64 Size) {
+  if (!Writer->File) {
+    return Error;
+  }
+  i64 Written = Writer->SampleCount * WaveSampleSize(Writer->Format);
+  if (Writer->Allocated - Written >= Size / 2) {
+    return NoError;
+  }
+#if __linux__
+  // NOTE(lucas): FALLOC_FL_KEEP_SIZE, the blocks are reserved but the file doesn't grow, so it stays a valid WAVE file
+  if (syscall(SYS_fallocate, fileno(Writer->File), 0x01, (i64)Writer->DataOffset + Written, Size) != 0) {
+    return Error;
+  }
+  Writer->Allocated = Written + Size;
+  return NoError;
+#else
+  return Error;
+#endif
+}
+
+i32 WaveWriterClose(wave_writer* Writer) {
+  if (!Writer->File) {
+    return Error;
+  }
+  // NOTE(lucas): The end of the file comes from the sample count, stdio doesn't know about WaveWriterWriteV
+  fflush(Writer->File);
+  i64 End = Writer->DataOffset + Writer->SampleCount * WaveSampleSize(Writer->Format);
+  i32 Result = NoError;
+  if (End & 1) {
+    u8 Pad = 0;
+    Result |= WriteAt(Writer, End++, &Pad, sizeof(Pad));
+  }
+  Result |= WaveWriterUpdateHeader(Writer);
+  if (Writer->Allocated > 0) {
+    // Hand back what we preallocated but didn't use
+    if (ftruncate(fileno(Writer->File), End) != 0) {
+      Result = Error;
+    }
+  }
+  fclose(Writer->File);
+  Writer->File = NULL;
+  return Result ? Error : NoError;
+}
+
+#define WAVE_READ_SIZE 4096 // Samples read from the file at a time
+
+// Convert SampleCount samples in the sample format of the file into floats
+static void DecodeSamples(wave_format* Format, u8* Data, f32* Dest, u32 SampleCount) {
+  if (Format->Type == FORMAT_IEEE_FLOAT) {
+    memcpy(Dest, Data, sizeof(f32) * SampleCount);
+    return;
+  }
+  switch (Format->BitsPerSample) {
+    case 16: {
+      ConvertToFloatBuffer(Dest, (i16*)Data, SampleCount);
+      break;
+    }
+    case 24: {
+      for (u32 SampleIndex = 0; SampleIndex < SampleCount; ++SampleIndex, Data += 3) {
+        i32 Value = (i32)((u32)Data[0] << 8 | (u32)Data[1] << 16 | (u32)Data[2] << 24) >> 8;
+        Dest[SampleIndex] = Value * (1.0f / 8388608.0f);
+      }
+      break;
+    }
+    case 32: {
+      i32 Value = 0;
+      for (u32 SampleIndex = 0; SampleIndex < SampleCount; ++SampleIndex, Data += 4) {
+        memcpy(&Value, Data, sizeof(i32));
+        Dest[SampleIndex] = Value * (1.0f / 2147483648.0f);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+// Reads 16, 24 and 32-bit PCM and 32-bit float, RF64 and extensible files included
 i32 LoadWAVE(const char* Path, audio_source* Source) {
   i32 Result = NoError;
   FILE* File = fopen(Path, "r");
@@ -187,11 +491,11 @@ i32 LoadWAVE(const char* Path, audio_source* Source) {
 
   Assert(WaveMinSize == 44);
 
-  fseek(File, 0, SEEK_END);
-  i32 FileSize = ftell(File);
-  fseek(File, 0, SEEK_SET);
-  (void)FileSize;
+  fseeko(File, 0, SEEK_END);
+  i64 FileSize = ftello(File);
+  fseeko(File, 0, SEEK_SET);
 
+  u8* Staging = NULL;
   if (FileSize < WaveMinSize) {
     fprintf(stderr, "Invalid WAVE file '%s'\n", Path);
     Result = Error;
@@ -205,62 +509,112 @@ i32 LoadWAVE(const char* Path, audio_source* Source) {
   }
 
   if ((Result = ValidateWaveHeader(&WaveHeader)) != NoError) {
+    fprintf(stderr, "Invalid WAVE file '%s'\n", Path);
     goto Done;
   }
+  u8 Rf64 = !strncmp(WaveHeader.RiffId, Rf64Id, ArraySize(Rf64Id));
+  u64 Rf64DataSize = 0;
 
+  // NOTE(lucas): The sizes of RF64 files are in the ds64 chunk, which comes before the format chunk
   wave_format WaveFormat;
-  if (IterateWaveFile(&WaveFormat, sizeof(wave_format), File, Path) != NoError) {
+  for (;;) {
+    if (IterateWaveFile(&WaveFormat, sizeof(wave_chunk), File, Path) != NoError) {
+      Result = Error;
+      goto Done;
+    }
+    if (!strncmp(WaveFormat.FormatId, FormatId, ArraySize(FormatId))) {
+      break;
+    }
+    u32 ChunkSize = (u32)WaveFormat.Size;
+    if (Rf64 && !strncmp(WaveFormat.FormatId, Ds64Id, ArraySize(Ds64Id)) && ChunkSize >= 2 * sizeof(u64)) {
+      u64 Sizes[2]; // Of the RIFF and data chunks
+      if (IterateWaveFile(Sizes, sizeof(Sizes), File, Path) != NoError) {
+        Result = Error;
+        goto Done;
+      }
+      Rf64DataSize = Sizes[1];
+      ChunkSize -= sizeof(Sizes);
+    }
+    fseeko(File, (i64)ChunkSize + (ChunkSize & 1), SEEK_CUR);
+  }
+  if (IterateWaveFile((u8*)&WaveFormat + sizeof(wave_chunk), sizeof(wave_format) - sizeof(wave_chunk), File, Path) != NoError) {
     Result = Error;
     goto Done;
   }
+  i32 FormatLeft = WaveFormat.Size - (sizeof(wave_format) - sizeof(wave_chunk));
+  if (WaveFormat.Type == (i16)FORMAT_EXTENSIBLE && FormatLeft >= 24) {
+    // NOTE(lucas): The first two bytes of the sub format are the actual format type
+    u8 Extension[10];
+    if (IterateWaveFile(Extension, sizeof(Extension), File, Path) != NoError) {
+      Result = Error;
+      goto Done;
+    }
+    memcpy(&WaveFormat.Type, &Extension[8], sizeof(i16));
+    FormatLeft -= sizeof(Extension);
+  }
+  fseeko(File, FormatLeft + (WaveFormat.Size & 1), SEEK_CUR);
 
   if ((Result = ValidateWaveFormat(&WaveFormat)) != NoError) {
+    fprintf(stderr, "Unsupported sample format in WAVE file '%s' (type 0x%x, %i bits)\n", Path, (u16)WaveFormat.Type, WaveFormat.BitsPerSample);
     goto Done;
   }
 
+  // Skip everything that isn't sample data (LIST, fact, cue and so on)
   wave_chunk WaveChunk;
-  i32 ListTag = 0;
-  do {
+  for (;;) {
     if (IterateWaveFile(&WaveChunk, sizeof(wave_chunk), File, Path) != NoError) {
       Result = Error;
       goto Done;
     }
-
-    ListTag = 0;
-    if ((Result = ValidateWaveChunk(&WaveChunk, &ListTag)) != NoError) {
-      goto Done;
+    if (!strncmp(WaveChunk.ChunkId, DataChunkId, ArraySize(DataChunkId))) {
+      break;
     }
-    // NOTE(lucas): If there is a list tag in this chunk, skip it for now. Might want to use the contents of the list metadata later on.
-    if (ListTag) {
-      i32 ListTagSize = WaveChunk.Size;
-      fseek(File, ListTagSize, SEEK_CUR);
-    }
-  } while (ListTag);
+    u32 ChunkSize = (u32)WaveChunk.Size;
+    fseeko(File, (i64)ChunkSize + (ChunkSize & 1), SEEK_CUR);
+  }
 
-  i32 SampleCount = WaveFormat.ChannelCount * (WaveChunk.Size / WaveFormat.DataBlockSize);
-  i32 BufferSize = WaveChunk.Size;
-  void* Buffer = M_Malloc(BufferSize);
-  if (!Buffer) {
-    fprintf(stderr, "Failed to allocate sample buffer\n");
+  u64 DataSize = (u32)WaveChunk.Size;
+  if (Rf64 && (u32)WaveChunk.Size == UINT32_MAX) {
+    DataSize = Rf64DataSize;
+  }
+  DataSize = Min(DataSize, (u64)(FileSize - ftello(File)));
+  i32 SampleSize = WaveFormat.BitsPerSample / 8;
+  u64 FrameCount = DataSize / (SampleSize * WaveFormat.ChannelCount);
+  u64 SampleCount = FrameCount * WaveFormat.ChannelCount;
+  if (SampleCount > INT32_MAX / sizeof(float)) {
+    fprintf(stderr, "WAVE file '%s' is too large to be loaded\n", Path);
     Result = Error;
     goto Done;
   }
 
-  if ((Result = IterateWaveFile(Buffer, WaveChunk.Size, File, Path)) != NoError) {
-    fprintf(stderr, "Failed to read sample buffer\n");
+  Source->Buffer = M_Malloc(sizeof(float) * SampleCount);
+  Staging = M_Malloc(SampleSize * WAVE_READ_SIZE);
+  if (!Source->Buffer || !Staging) {
+    fprintf(stderr, "Failed to allocate sample buffer\n");
+    if (Source->Buffer) {
+      M_Free(Source->Buffer, sizeof(float) * SampleCount);
+      Source->Buffer = NULL;
+    }
+    Result = Error;
     goto Done;
   }
-
-  Source->Buffer = M_Malloc(sizeof(float) * SampleCount);
-  Source->SampleCount = SampleCount;
+  Source->SampleCount = (i32)SampleCount;
   Source->ChannelCount = WaveFormat.ChannelCount;
-  ConvertToFloatBuffer(Source->Buffer, (i16*)Buffer, Source->SampleCount);
-  M_Free(Buffer, BufferSize);
+
+  for (i32 SampleIndex = 0; SampleIndex < Source->SampleCount; SampleIndex += WAVE_READ_SIZE) {
+    i32 Count = Min(Source->SampleCount - SampleIndex, WAVE_READ_SIZE);
+    if ((Result = IterateWaveFile(Staging, Count * SampleSize, File, Path)) != NoError) {
+      fprintf(stderr, "Failed to read sample buffer\n");
+      UnloadAudioSource(Source);
+      goto Done;
+    }
+    DecodeSamples(&WaveFormat, Staging, &Source->Buffer[SampleIndex], Count);
+  }
 
 #if 0
   printf("Loaded WAVE file '%s':\n", Path);
   printf("===\n");
-  printf("SampleCount: %i\n", SampleCount);
+  printf("SampleCount: %i\n", Source->SampleCount);
   printf("===\n");
   PrintWaveHeader(&WaveHeader);
   printf("===\n");
@@ -273,6 +627,9 @@ i32 LoadWAVE(const char* Path, audio_source* Source) {
   (void)PrintWaveChunk;
 #endif
 Done:
+  if (Staging) {
+    M_Free(Staging, SampleSize * WAVE_READ_SIZE);
+  }
   fclose(File);
   return Result;
 }
@@ -0,0 +1,64 @@
+// rt_debug.c
+
+#if RT_DEBUG
+
+#define MAX_RT_REPORT 256
+#define MAX_RT_BACKTRACE 32
+
+// NOTE(lucas): Every offending call stack is only reported once, or the log would be flooded once per callback
+static _Atomic u32 RtReported[MAX_RT_REPORT];
+static _Atomic i32 RtReportCount = 0;
+
+static u32 RtHashFrames(void** Frames, i32 Count);
+static u8 RtAlreadyReported(u32 Hash);
+
+u32 RtHashFrames(void** Frames, i32 Count) {
+  u32 Hash = 2166136261u;
+  for (i32 Index = 0; Index < Count; ++Index) {
+    uintptr_t Address = (uintptr_t)Frames[Index];
+    Hash = (Hash ^ (u32)Address) * 16777619u;
+    Hash = (Hash ^ (u32)(Address >> 32)) * 16777619u;
+  }
+  return Hash ? Hash : 1;
+}
+
+u8 RtAlreadyReported(u32 Hash) {
+  i32 Count = Min(atomic_load(&RtReportCount), MAX_RT_REPORT);
+  for (i32 Index = 0; Index < Count; ++Index) {
+    if (atomic_load_explicit(&RtReported[Index], memory_order_relaxed) == Hash) {
+      return 1;
+    }
+  }
+  i32 Index = atomic_fetch_add(&RtReportCount, 1);
+  if (Index < MAX_RT_REPORT) {
+    atomic_store_explicit(&RtReported[Index], Hash, memory_order_relaxed);
+  }
+  return 0;
+}
+
+// NOTE(lucas): The first call to backtrace loads the unwinder, which allocates, so we get that out of the way up front
+void RtDebugInit() {
+  void* Frames[1];
+  backtrace(Frames, 1);
+}
+
+// NOTE(lucas): Reports are written straight to stderr with write, since stdio is one of the things we are looking for
+void RtViolation(const char* Name, const char* File, i32 Line) {
+  void* Frames[MAX_RT_BACKTRACE];
+  i32 FrameCount = backtrace(Frames, MAX_RT_BACKTRACE);
+  if (RtAlreadyReported(RtHashFrames(Frames, FrameCount))) {
+    return;
+  }
+  char Message[512];
+  i32 Length = snprintf(Message, sizeof(Message), "[rt_debug] %s called on the audio thread (%s:%i)\n", Name, File, Line);
+  if (Length > 0) {
+    write(STDERR_FILENO, Message, Min(Length, (i32)sizeof(Message) - 1));
+  }
+  // Skip ourselves
+  backtrace_symbols_fd(&Frames[1], FrameCount - 1, STDERR_FILENO);
+  if (G_RtDebugTrap) {
+    abort();
+  }
+}
+
+#endif
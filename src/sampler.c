@@ -4,12 +4,67 @@ typedef struct sampler_instrument_data {
   f32 TimeStamp;
   i32 Index;
   u8 Reverse;
-  u8 Distort;
-  u8 Weird;
   u8 Step;
   audio_source Source;
 } sampler_instrument_data;
 
+#define MAX_SHARED_SOURCE 64
+
+// NOTE(lucas): Samplers playing the same file share its audio, and are loaded on threads of their own, hence the lock
+typedef struct shared_source {
+  char Path[MAX_PATH_SIZE];
+  audio_source Source;
+  i32 RefCount;
+} shared_source;
+
+static shared_source SharedSources[MAX_SHARED_SOURCE];
+static i32 SharedSourceCount = 0;
+static pthread_mutex_t SharedSourceLock = PTHREAD_MUTEX_INITIALIZER;
+
+static i32 AcquireSource(const char* Path, audio_source* Source);
+static void ReleaseSource(audio_source* Source);
+
+i32 AcquireSource(const char* Path, audio_source* Source) {
+  i32 Result = NoError;
+  pthread_mutex_lock(&SharedSourceLock);
+  for (i32 Index = 0; Index < SharedSourceCount; ++Index) {
+    shared_source* Shared = &SharedSources[Index];
+    if (!strncmp(Shared->Path, Path, MAX_PATH_SIZE)) {
+      ++Shared->RefCount;
+      *Source = Shared->Source;
+      pthread_mutex_unlock(&SharedSourceLock);
+      return NoError;
+    }
+  }
+  // Once the table is full, samplers get a copy of their own
+  if ((Result = LoadAudioSourceFromDataPath(Path, Source)) == NoError && SharedSourceCount < MAX_SHARED_SOURCE) {
+    shared_source* Shared = &SharedSources[SharedSourceCount++];
+    snprintf(Shared->Path, MAX_PATH_SIZE, "%s", Path);
+    Shared->Source = *Source;
+    Shared->RefCount = 1;
+  }
+  pthread_mutex_unlock(&SharedSourceLock);
+  return Result;
+}
+
+void ReleaseSource(audio_source* Source) {
+  pthread_mutex_lock(&SharedSourceLock);
+  for (i32 Index = 0; Index < SharedSourceCount; ++Index) {
+    shared_source* Shared = &SharedSources[Index];
+    if (Source->Buffer && Shared->Source.Buffer == Source->Buffer) {
+      if (--Shared->RefCount == 0) {
+        UnloadAudioSource(&Shared->Source);
+        *Shared = SharedSources[--SharedSourceCount];
+      }
+      memset(Source, 0, sizeof(audio_source));
+      pthread_mutex_unlock(&SharedSourceLock);
+      return;
+    }
+  }
+  pthread_mutex_unlock(&SharedSourceLock);
+  UnloadAudioSource(Source);
+}
+
 i32 SamplerInit(instrument* Ins) {
   i32 Result = NoError;
   if ((Result = InstrumentAllocUserData(Ins, sizeof(sampler_instrument_data))) == NoError) {
@@ -17,10 +72,9 @@ i32 SamplerInit(instrument* Ins) {
     Sampler->TimeStamp = 0;
     Sampler->Index = 0;
     Sampler->Reverse = 0;
-    Sampler->Distort = 0;
     Sampler->Step = 0;
     // Result = LoadAudioSourceFromDataPath("data/audio/basic_kick.ogg", &Sampler->Source);
-    Result = LoadAudioSourceFromDataPath("data/audio/dark_wind.ogg", &Sampler->Source);
+    Result = AcquireSource("data/audio/dark_wind.ogg", &Sampler->Source);
   }
   return Result;
 }
@@ -28,7 +82,8 @@ i32 SamplerInit(instrument* Ins) {
 i32 SamplerProcess(instrument* Ins, bus* Bus, i32 FramesPerBuffer, i32 SampleRate) {
   sampler_instrument_data* Sampler = (sampler_instrument_data*)Ins->UserData.Data;
   audio_source* Source = &Sampler->Source;
-  f32* Iter = Bus->Buffer;
+  f32* Left = &Bus->Buffer[0];
+  f32* Right = &Bus->Buffer[Bus->Stride];
   f32 Time = AudioEngine.Time;
 
   if (!Sampler->Step) {
@@ -71,19 +126,13 @@ i32 SamplerProcess(instrument* Ins, bus* Bus, i32 FramesPerBuffer, i32 SampleRat
       }
     }
     if (Bus->ChannelCount == 2) {
-      *Iter++ = Frame0;
-      *Iter++ = Frame1;
+      Left[FrameIndex] = Frame0;
+      Right[FrameIndex] = Frame1;
     }
     else {
-      *Iter++ = 0.5f * Frame0 + 0.5f * Frame1;
+      Left[FrameIndex] = 0.5f * Frame0 + 0.5f * Frame1;
     }
   }
-  if (Sampler->Distort) {
-    Distortion(Bus->Buffer, Bus->ChannelCount, FramesPerBuffer, 0.25f, 120.0f);
-  }
-  if (Sampler->Weird) {
-    WeirdEffect(Bus->Buffer, Bus->ChannelCount, FramesPerBuffer, 0.25f, 1000.0f);
-  }
   return NoError;
 }
 
@@ -91,8 +140,6 @@ i32 SamplerDraw(instrument* Ins) {
   sampler_instrument_data* Sampler = (sampler_instrument_data*)Ins->UserData.Data;
   Assert(Sampler);
 
-  UI_DoTextToggle(UI_ID, "Distort", &Sampler->Distort);
-  UI_DoTextToggle(UI_ID, "Weird", &Sampler->Weird);
   UI_DoTextToggle(UI_ID, "Reverse", &Sampler->Reverse);
   UI_DoTextToggle(UI_ID, "Step", &Sampler->Step);
   return NoError;
@@ -101,6 +148,6 @@ i32 SamplerDraw(instrument* Ins) {
 i32 SamplerFree(instrument* Ins) {
   sampler_instrument_data* Sampler = (sampler_instrument_data*)Ins->UserData.Data;
   Assert(Sampler);
-  UnloadAudioSource(&Sampler->Source);
+  ReleaseSource(&Sampler->Source);
   return NoError;
 }
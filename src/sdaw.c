@@ -9,9 +9,12 @@
 #include "config.c"
 #include "lut.c"
 #include "debug.c"
+#include "rt_debug.c"
 #include "list.c"
+#include "spsc_queue.c"
 #include "str.c"
 #include "math_util.c"
+#include "fft.c"
 #include "arg_parser.c"
 #include "image.c"
 #include "audio.c"
@@ -22,12 +25,15 @@
 #include "image_interp.c"
 #include "audio_effect.c"
 #include "audio_convert.c"
+#include "fft_bench.c"
 
 #ifndef NO_ENGINE
   #include "engine.c"
 #else
   #define EngineInit() NoError
   #define EngineFree()
+  #define Render(ARGC, ARGV) NoError
+  #define BenchEngine(ARGC, ARGV) NoError
 #endif
 
 typedef struct options {
@@ -36,6 +42,9 @@ typedef struct options {
   i32 ImageInterpolation;
   i32 AudioEffect;
   i32 AudioConvert;
+  i32 Render;
+  i32 BenchEngine;
+  i32 BenchFft;
 } options;
 
 i32 SdawStart(i32 argc, char** argv) {
@@ -44,6 +53,7 @@ i32 SdawStart(i32 argc, char** argv) {
 
   ConfigParserInit();
   ConfigRead();
+  RtDebugInit();
 
 #if INSTALL_APPLE && __APPLE__
   Result = EngineInit();
@@ -55,6 +65,9 @@ i32 SdawStart(i32 argc, char** argv) {
     .ImageInterpolation = 0,
     .AudioEffect = 0,
     .AudioConvert = 0,
+    .Render = 0,
+    .BenchEngine = 0,
+    .BenchFft = 0,
   };
   parse_arg Arguments[] = {
     {'a', "audio-gen", "image to audio generator", ArgInt, 0, &Options.ImageToAudioGen},
@@ -62,6 +75,9 @@ i32 SdawStart(i32 argc, char** argv) {
     {'I', "image-interpolate", "image interpolation", ArgInt, 0, &Options.ImageInterpolation},
     {'e', "effect", "apply audio effects on audio files", ArgInt, 0, &Options.AudioEffect},
     {'c', "audio-convert", "convert audio from one format to the other", ArgInt, 0, &Options.AudioConvert},
+    {'r', "render", "render a session offline (headless) to an audio file", ArgInt, 0, &Options.Render},
+    {'b', "bench-engine", "benchmark how many buses of every instrument the audio engine can process in real time", ArgInt, 0, &Options.BenchEngine},
+    {'F', "bench-fft", "benchmark the FFT against a naive DFT and check its accuracy", ArgInt, 0, &Options.BenchFft},
   };
 
   if (argc <= 1) {
@@ -88,6 +104,15 @@ i32 SdawStart(i32 argc, char** argv) {
     else if (Options.AudioConvert) {
      Result = AudioConvert(argc - 1, &argv[1]);
     }
+    else if (Options.Render) {
+     Result = Render(argc - 1, &argv[1]);
+    }
+    else if (Options.BenchEngine) {
+     Result = BenchEngine(argc - 1, &argv[1]);
+    }
+    else if (Options.BenchFft) {
+     Result = BenchFft(argc - 1, &argv[1]);
+    }
   }
 #endif
   ConfigParserFree();
@@ -0,0 +1,93 @@
+// spsc_queue.c
+
+i32 SpscQueueInit(spsc_queue* Queue, u32 ElementSize, u32 Capacity) {
+  Assert(Capacity > 0 && !(Capacity & (Capacity - 1)));
+  Queue->Data = M_Calloc(ElementSize, Capacity);
+  if (!Queue->Data) {
+    fprintf(stderr, "Failed to allocate queue\n");
+    return Error;
+  }
+  Queue->ElementSize = ElementSize;
+  Queue->Capacity = Capacity;
+  atomic_init(&Queue->Head, 0);
+  atomic_init(&Queue->Tail, 0);
+  return NoError;
+}
+
+u8 SpscQueuePush(spsc_queue* Queue, const void* Element) {
+  u32 Tail = atomic_load_explicit(&Queue->Tail, memory_order_relaxed);
+  u32 Head = atomic_load_explicit(&Queue->Head, memory_order_acquire);
+  if (Tail - Head >= Queue->Capacity) {
+    return 0;
+  }
+  memcpy(&Queue->Data[(Tail & (Queue->Capacity - 1)) * Queue->ElementSize], Element, Queue->ElementSize);
+  atomic_store_explicit(&Queue->Tail, Tail + 1, memory_order_release);
+  return 1;
+}
+
+u8 SpscQueuePop(spsc_queue* Queue, void* Element) {
+  u32 Head = atomic_load_explicit(&Queue->Head, memory_order_relaxed);
+  u32 Tail = atomic_load_explicit(&Queue->Tail, memory_order_acquire);
+  if (Head == Tail) {
+    return 0;
+  }
+  memcpy(Element, &Queue->Data[(Head & (Queue->Capacity - 1)) * Queue->ElementSize], Queue->ElementSize);
+  atomic_store_explicit(&Queue->Head, Head + 1, memory_order_release);
+  return 1;
+}
+
+u8 SpscQueuePushMany(spsc_queue* Queue, const void* Elements, u32 Count) {
+  u32 Tail = atomic_load_explicit(&Queue->Tail, memory_order_relaxed);
+  u32 Head = atomic_load_explicit(&Queue->Head, memory_order_acquire);
+  if (Queue->Capacity - (Tail - Head) < Count) {
+    return 0;
+  }
+  u32 Index = Tail & (Queue->Capacity - 1);
+  u32 First = Min(Count, Queue->Capacity - Index);  // Elements that fit before we wrap around
+  memcpy(&Queue->Data[Index * Queue->ElementSize], Elements, First * Queue->ElementSize);
+  memcpy(&Queue->Data[0], (const u8*)Elements + First * Queue->ElementSize, (Count - First) * Queue->ElementSize);
+  atomic_store_explicit(&Queue->Tail, Tail + Count, memory_order_release);
+  return 1;
+}
+
+u32 SpscQueuePeek(spsc_queue* Queue, void** Elements) {
+  u32 Head = atomic_load_explicit(&Queue->Head, memory_order_relaxed);
+  u32 Tail = atomic_load_explicit(&Queue->Tail, memory_order_acquire);
+  u32 Index = Head & (Queue->Capacity - 1);
+  *Elements = &Queue->Data[Index * Queue->ElementSize];
+  return Min(Tail - Head, Queue->Capacity - Index);
+}
+
+u32 SpscQueuePeekAll(spsc_queue* Queue, void* Regions[2], u32 Counts[2]) {
+  u32 Head = atomic_load_explicit(&Queue->Head, memory_order_relaxed);
+  u32 Tail = atomic_load_explicit(&Queue->Tail, memory_order_acquire);
+  u32 Index = Head & (Queue->Capacity - 1);
+  u32 Count = Tail - Head;
+  Regions[0] = &Queue->Data[Index * Queue->ElementSize];
+  Counts[0] = Min(Count, Queue->Capacity - Index);
+  Regions[1] = Queue->Data;
+  Counts[1] = Count - Counts[0];
+  return Count;
+}
+
+void SpscQueueRelease(spsc_queue* Queue, u32 Count) {
+  u32 Head = atomic_load_explicit(&Queue->Head, memory_order_relaxed);
+  atomic_store_explicit(&Queue->Head, Head + Count, memory_order_release);
+}
+
+u32 SpscQueueCount(spsc_queue* Queue) {
+  u32 Tail = atomic_load_explicit(&Queue->Tail, memory_order_acquire);
+  u32 Head = atomic_load_explicit(&Queue->Head, memory_order_acquire);
+  return Tail - Head;
+}
+
+u32 SpscQueueSpace(spsc_queue* Queue) {
+  return Queue->Capacity - SpscQueueCount(Queue);
+}
+
+void SpscQueueFree(spsc_queue* Queue) {
+  if (Queue->Data) {
+    M_Free(Queue->Data, Queue->ElementSize * Queue->Capacity);
+    Queue->Data = NULL;
+  }
+}
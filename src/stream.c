@@ -1,152 +1,303 @@
 // stream.c
+// records the output of the audio engine (and optionally every bus and the audio input) to WAVE files, the audio
+// thread hands frames over to a single writer thread through a wait-free ring buffer per track
 
-#define STREAM_BUFFER_COUNT 3
+#define STREAM_WAIT_TIMEOUT_MS 100  // The writer flushes at least this often, even if the fill threshold wasn't reached
+#define STREAM_HEADER_INTERVAL 1.0  // Seconds between updates of the WAVE header while recording
 
-typedef struct stream_buffer {
-  f32* Data;
-  u32 Count;
-  u32 Size;
-} stream_buffer;
+typedef struct stream_track {
+  spsc_queue Ring;  // Frames of interleaved samples
+  wave_writer Writer; // Written to by the writer thread only
+  i32 ChannelCount;
+  char Path[MAX_PATH_SIZE];
+  _Alignas(CACHE_LINE_SIZE) u32 Frames; // Audio thread only, frames written to the track in the current buffer
+} stream_track;
 
 typedef struct stream_state {
-  u8 Recording;
-  u8 BufferTarget;
-  u8 ShouldExit;
-  u8 Done;
-  u8 DoneWritingBuffer;
-
-  stream_buffer StreamBuffer[STREAM_BUFFER_COUNT];
-  stream_buffer* Buffer;
-  stream_buffer* WriteBuffer;
+  _Atomic u8 Recording;
+  _Atomic u8 ShouldExit;
+  wait_word Signal; // Bumped to wake up the writer
+  _Atomic u64 DroppedFrames;  // Frames that didn't fit in the ring, since the stream was opened
+  u64 ReportedFrames; // Dropped frames that the writer has already complained about
+  u32 Capacity; // Frames in the ring of every track
+  u32 Threshold;  // Frames in the ring of the master track at which the writer is woken up
+  i32 SampleRate;
+  u8 Capturing; // Audio thread only, whether the buffer that is being processed is recorded
   pthread_t WriteThread;
-  pthread_mutex_t Mutex;
-
-  FILE* File;
+  u8 ThreadRunning;
+  stream_track* Tracks; // The master track comes first
+  i32 TrackCount; // Only changes before the files have been opened
+  _Atomic u8 WriterOpen;  // The files are opened by the UI thread when recording starts
+  i64 HeaderFrames; // Frames covered by the WAVE headers
+  f64 HeaderTime; // When the headers were last updated
 } stream_state;
 
 static stream_state S;
+static const f32 Silence[MAX_STREAM_CHANNEL * MAX_BUFFER_SIZE] = {0};
 
-static void StreamBufferInit(stream_buffer* Buffer, u32 Size);
-static void SwitchStreamBufferTarget();
+static void WriterSleep(stream_state* Stream, u32 Signal);
+static void WriterWake(stream_state* Stream);
+static wave_sample_format RecordFormat();
+static void WriteFrames(stream_state* Stream);
 static void* StreamWriteThread(void* StreamState);
+static void PushFrames(stream_track* Track, const f32* Frames, u32 FrameCount);
 
-void StreamBufferInit(stream_buffer* Buffer, u32 Size) {
-  Buffer->Data = M_Malloc(Size);
-  Buffer->Count = 0;  // Number of bytes that has been written to this buffer
-  Buffer->Size = Size;  // How much allocated memory in total
+void WriterSleep(stream_state* Stream, u32 Signal) {
+  if (SpscQueueCount(&Stream->Tracks[STREAM_MASTER_TRACK].Ring) < Stream->Threshold) {
+    WaitWordSleep(&Stream->Signal, Signal, STREAM_WAIT_TIMEOUT_MS);
+  }
 }
 
-void SwitchStreamBufferTarget() {
-  S.Buffer = &S.StreamBuffer[S.BufferTarget];
-  S.BufferTarget = (S.BufferTarget + 1) % STREAM_BUFFER_COUNT;
-  S.WriteBuffer = &S.StreamBuffer[S.BufferTarget];
+void WriterWake(stream_state* Stream) {
+  atomic_fetch_add(&Stream->Signal.Value, 1);
+  WaitWordWake(&Stream->Signal, 1);
 }
 
-void* StreamWriteThread(void* StreamState) {
-  stream_state* Stream = (stream_state*)StreamState;
-  Stream->Done = 0;
-
-  while (!Stream->ShouldExit && Stream->Recording) {
-    Stream->DoneWritingBuffer = 0;
-    if (pthread_mutex_trylock(&Stream->Mutex)) {
-      stream_buffer* Buffer = Stream->WriteBuffer;
-      if (Buffer && Buffer->Count > 0) {
-        if (Stream->File) {
-          fwrite(&Buffer->Data[0], sizeof(float), Buffer->Count, Stream->File);
-          Buffer->Count = 0;
-        }
+wave_sample_format RecordFormat() {
+  switch (G_RecordBitDepth) {
+    case 16:
+      return WaveInt16;
+    case 24:
+      return WaveInt24;
+    default:
+      return WaveFloat32;
+  }
+}
+
+// NOTE(lucas): The headers are updated about once a second, so that a crash only loses the last second of the take
+void WriteFrames(stream_state* Stream) {
+  u8 WriterOpen = atomic_load(&Stream->WriterOpen);
+  for (i32 TrackIndex = 0; TrackIndex < (WriterOpen ? Stream->TrackCount : 1); ++TrackIndex) {
+    stream_track* Track = &Stream->Tracks[TrackIndex];
+    f32* Regions[2];
+    u32 Counts[2];
+    u32 FrameCount = SpscQueuePeekAll(&Track->Ring, (void**)Regions, Counts);
+    if (FrameCount == 0) {
+      continue;
+    }
+    if (WriterOpen) {
+      if (G_RecordPreallocate > 0) {
+        i64 Size = Max((i64)G_RecordPreallocate * 1024 * 1024 / Stream->TrackCount, 1024 * 1024);
+        WaveWriterPreallocate(&Track->Writer, Size);
+      }
+      u32 SampleCounts[2] = { Counts[0] * Track->ChannelCount, Counts[1] * Track->ChannelCount };
+      WaveWriterWriteV(&Track->Writer, Regions, SampleCounts, Counts[1] > 0 ? 2 : 1);
+    }
+    SpscQueueRelease(&Track->Ring, FrameCount);
+  }
+  if (WriterOpen) {
+    stream_track* Master = &Stream->Tracks[STREAM_MASTER_TRACK];
+    i64 WrittenFrames = Master->Writer.SampleCount / Master->ChannelCount;
+    f64 Time = DspLoadTime() / 1000000000.0;
+    if (WrittenFrames != Stream->HeaderFrames && (Time - Stream->HeaderTime >= STREAM_HEADER_INTERVAL || !atomic_load(&Stream->Recording))) {
+      for (i32 TrackIndex = 0; TrackIndex < Stream->TrackCount; ++TrackIndex) {
+        WaveWriterUpdateHeader(&Stream->Tracks[TrackIndex].Writer);
       }
-      pthread_mutex_unlock(&Stream->Mutex);
+      Stream->HeaderFrames = WrittenFrames;
+      Stream->HeaderTime = Time;
     }
-    sleep(0);
   }
-  pthread_join(Stream->WriteThread, NULL);
-  Stream->Done = 1;
-  Stream->Recording = 0;
+  u64 DroppedFrames = atomic_load_explicit(&Stream->DroppedFrames, memory_order_relaxed);
+  if (DroppedFrames != Stream->ReportedFrames) {
+    // Uh, disk probably too slow...
+    fprintf(stderr, "%s: Stream buffer filled, dropped %lu frame(s) (%lu in total)\n", __FUNCTION__, (unsigned long)(DroppedFrames - Stream->ReportedFrames), (unsigned long)DroppedFrames);
+    Stream->ReportedFrames = DroppedFrames;
+  }
+}
+
+void* StreamWriteThread(void* StreamState) {
+  stream_state* Stream = (stream_state*)StreamState;
+  while (!atomic_load(&Stream->ShouldExit)) {
+    u32 Signal = atomic_load(&Stream->Signal.Value);
+    WriteFrames(Stream);
+    WriterSleep(Stream, Signal);
+  }
+  WriteFrames(Stream);
   return NULL;
 }
 
-i32 StreamInit(i32 FramesPerBuffer, i32 ChannelCount, const char* Path) {
-  S.Recording = 0;
-  S.BufferTarget = 0;
-  S.ShouldExit = 0;
-  S.Done = 1;
-  S.DoneWritingBuffer = 0;
+// NOTE(lucas): There is always room, StreamBeginBuffer makes sure of that
+void PushFrames(stream_track* Track, const f32* Frames, u32 FrameCount) {
+  SpscQueuePushMany(&Track->Ring, Frames, FrameCount);
+  Track->Frames += FrameCount;
+}
+
+i32 StreamInit(i32 SampleRate, i32 FramesPerBuffer, i32 ChannelCount, const char* Path) {
+  atomic_init(&S.Recording, 0);
+  atomic_init(&S.ShouldExit, 0);
+  WaitWordInit(&S.Signal, 0);
+  atomic_init(&S.DroppedFrames, 0);
+  S.ReportedFrames = 0;
+  S.SampleRate = SampleRate;
+  S.Capturing = 0;
+  S.ThreadRunning = 0;
+  S.TrackCount = 0;
+  atomic_init(&S.WriterOpen, 0);
+  S.HeaderFrames = 0;
+  S.HeaderTime = 0;
 
-  for (u32 BufferIndex = 0; BufferIndex < STREAM_BUFFER_COUNT; ++BufferIndex) {
-    StreamBufferInit(&S.StreamBuffer[BufferIndex], FramesPerBuffer * ChannelCount * G_StreamBufferSizeMultiple * sizeof(float));
+  S.Capacity = 1;
+  while (S.Capacity < (u32)(FramesPerBuffer * Max(G_StreamBufferSizeMultiple, 2))) {
+    S.Capacity <<= 1;
+  }
+  S.Threshold = S.Capacity / Max(G_StreamBufferDenom, 1);
+  S.Tracks = M_AlignedCalloc(CACHE_LINE_SIZE, sizeof(stream_track), MAX_STREAM_TRACK);
+  if (!S.Tracks || StreamAddTrack(ChannelCount, Path) != STREAM_MASTER_TRACK) {
+    return Error;
   }
-  S.Buffer = NULL;
-  S.WriteBuffer = NULL;
-  S.Mutex = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
+  if (pthread_create(&S.WriteThread, NULL, StreamWriteThread, (void*)&S) != 0) {
+    fprintf(stderr, "Failed to create stream writer thread\n");
+    return Error;
+  }
+  S.ThreadRunning = 1;
+  return NoError;
+}
 
-  S.File = fopen(Path, "wb");
+i32 StreamAddTrack(i32 ChannelCount, const char* Path) {
+  Assert(ChannelCount > 0 && ChannelCount <= MAX_STREAM_CHANNEL);
+  if (!S.Tracks || atomic_load(&S.WriterOpen)) {
+    return -1;
+  }
+  if (S.TrackCount >= MAX_STREAM_TRACK) {
+    fprintf(stderr, "Maximum amount of recorded tracks reached (%i), '%s' will not be recorded\n", MAX_STREAM_TRACK, Path);
+    return -1;
+  }
+  stream_track* Track = &S.Tracks[S.TrackCount];
+  if (SpscQueueInit(&Track->Ring, sizeof(f32) * ChannelCount, S.Capacity) != NoError) {
+    return -1;
+  }
+  Track->Writer.File = NULL;
+  Track->ChannelCount = ChannelCount;
+  snprintf(Track->Path, MAX_PATH_SIZE, "%s", Path);
+  Track->Frames = 0;
+  return S.TrackCount++;
+}
 
-  SwitchStreamBufferTarget();
-  return NoError;
+i32 StreamTrackCount() {
+  return S.TrackCount;
 }
 
+// Files are opened when recording first starts, later takes are appended. Tracks that fail are left out.
 i32 StreamStartRecording() {
-  S.Recording = 1;
-  pthread_create(&S.WriteThread, NULL, StreamWriteThread, (void*)&S);
+  if (!S.Tracks) {
+    return Error;
+  }
+  if (!atomic_load(&S.WriterOpen)) {
+    for (i32 TrackIndex = 0; TrackIndex < S.TrackCount; ++TrackIndex) {
+      stream_track* Track = &S.Tracks[TrackIndex];
+      WaveWriterOpen(&Track->Writer, Track->Path, S.SampleRate, Track->ChannelCount, RecordFormat());
+    }
+    if (!S.Tracks[STREAM_MASTER_TRACK].Writer.File) {
+      return Error;
+    }
+    atomic_store(&S.WriterOpen, 1);
+  }
+  atomic_store(&S.Recording, 1);
   return NoError;
 }
 
 i32 StreamStopRecording() {
-  S.Recording = 0;
+  atomic_store(&S.Recording, 0);
+  WriterWake(&S);
   return NoError;
 }
 
 u8 StreamIsRecording() {
-  return S.Recording;
+  return atomic_load(&S.Recording);
 }
 
-i32 StreamWriteBuffer(float* InBuffer, u32 BufferSize) {
-  if (!S.Recording || InBuffer == NULL) {
-    return NoError;
+u64 StreamDroppedFrames() {
+  return atomic_load(&S.DroppedFrames);
+}
+
+// NOTE(lucas): Every track gets the whole buffer or none does, so they stay aligned when the writer falls behind
+u8 StreamBeginBuffer(i32 FrameCount) {
+  S.Capturing = 0;
+  if (!atomic_load_explicit(&S.Recording, memory_order_acquire) || !S.ThreadRunning) {
+    return 0;
   }
-  if (S.Buffer->Count * sizeof(float) + BufferSize < S.Buffer->Size) {
-    stream_buffer* Buffer = S.Buffer;
-    if (Buffer) {
-      CopyFloatBuffer(&Buffer->Data[Buffer->Count], InBuffer, BufferSize);
-      Buffer->Count += BufferSize / sizeof(float);
+  for (i32 TrackIndex = 0; TrackIndex < S.TrackCount; ++TrackIndex) {
+    stream_track* Track = &S.Tracks[TrackIndex];
+    if (SpscQueueSpace(&Track->Ring) < (u32)FrameCount) {
+      atomic_fetch_add_explicit(&S.DroppedFrames, FrameCount, memory_order_relaxed);
+      return 0;
     }
+    Track->Frames = 0;
   }
-  else {
-    // Uh, disk probably too slow...
-    fprintf(stderr, "%s: Buffer (%i) filled\n", __FUNCTION__, S.BufferTarget);
+  S.Capturing = 1;
+  return 1;
+}
+
+void StreamWriteTrack(i32 Track, f32* Buffer, i32 FrameCount) {
+  if (!S.Capturing || Track < 0 || Track >= S.TrackCount) {
+    return;
+  }
+  PushFrames(&S.Tracks[Track], Buffer, FrameCount);
+}
+
+// Channels missing from the buffer get its last channel, like the mixer does for mono buses
+void StreamWritePlanar(i32 Track, f32* Buffer, i32 ChannelCount, i32 Stride, i32 FrameCount) {
+  f32 Frames[MAX_STREAM_CHANNEL * MAX_BUFFER_SIZE];
+  if (!S.Capturing || Track < 0 || Track >= S.TrackCount) {
+    return;
   }
-  if (S.Buffer->Count * sizeof(float) > (S.Buffer->Size / G_StreamBufferDenom)) {
-    if (pthread_mutex_trylock(&S.Mutex)) {
-      SwitchStreamBufferTarget();
-      pthread_mutex_unlock(&S.Mutex);
+  stream_track* Dest = &S.Tracks[Track];
+  for (i32 Offset = 0; Offset < FrameCount; Offset += MAX_BUFFER_SIZE) {
+    i32 Count = Min(FrameCount - Offset, MAX_BUFFER_SIZE);
+    for (i32 Channel = 0; Channel < Dest->ChannelCount; ++Channel) {
+      f32* Source = &Buffer[Min(Channel, ChannelCount - 1) * Stride + Offset];
+      for (i32 FrameIndex = 0; FrameIndex < Count; ++FrameIndex) {
+        Frames[FrameIndex * Dest->ChannelCount + Channel] = Source[FrameIndex];
+      }
     }
+    PushFrames(Dest, Frames, Count);
   }
-  return NoError;
 }
 
-void StreamFree() {
-  for (u32 BufferIndex = 0; BufferIndex < STREAM_BUFFER_COUNT; ++BufferIndex) {
-    M_Free(S.StreamBuffer[BufferIndex].Data, S.StreamBuffer[BufferIndex].Size);
+// Tracks which didn't get anything are padded with silence up to Frames
+void StreamEndBlock(i32 Frames) {
+  if (!S.Capturing) {
+    return;
   }
-  if (S.File) {
-    fclose(S.File);
+  for (i32 TrackIndex = 0; TrackIndex < S.TrackCount; ++TrackIndex) {
+    stream_track* Track = &S.Tracks[TrackIndex];
+    while (Track->Frames < (u32)Frames) {
+      PushFrames(Track, Silence, Min((u32)Frames - Track->Frames, MAX_BUFFER_SIZE));
+    }
   }
+}
 
-#if 1
-  buffer AudioFileContents;
-  if (ReadFile("record.data", &AudioFileContents) == NoError) {
-    audio_source Source = (audio_source) {
-      .Buffer = (float*)&AudioFileContents.Data[0],
-      .SampleCount = AudioFileContents.Count / sizeof(float),
-      .ChannelCount = 2,
-    };
-    StoreAudioSource("record.wav", &Source);
-    BufferFree(&AudioFileContents);
+void StreamEndBuffer() {
+  if (!S.Capturing) {
+    return;
+  }
+  if (SpscQueueCount(&S.Tracks[STREAM_MASTER_TRACK].Ring) >= S.Threshold) {
+    WriterWake(&S);
   }
-#endif
-  S.ShouldExit = 1;
-  while (!S.Done) {
-    sleep(0);
+  S.Capturing = 0;
+}
+
+void StreamFree() {
+  atomic_store(&S.Recording, 0);
+  if (S.ThreadRunning) {
+    atomic_store(&S.ShouldExit, 1);
+    WriterWake(&S);
+    pthread_join(S.WriteThread, NULL);
+    S.ThreadRunning = 0;
+  }
+  WaitWordFree(&S.Signal);
+  if (!S.Tracks) {
+    return;
+  }
+  for (i32 TrackIndex = 0; TrackIndex < S.TrackCount; ++TrackIndex) {
+    stream_track* Track = &S.Tracks[TrackIndex];
+    if (Track->Writer.File) {
+      WaveWriterClose(&Track->Writer);
+    }
+    SpscQueueFree(&Track->Ring);
   }
+  atomic_store(&S.WriterOpen, 0);
+  M_Free(S.Tracks, sizeof(stream_track) * MAX_STREAM_TRACK);
+  S.Tracks = NULL;
+  S.TrackCount = 0;
 }
@@ -16,6 +16,7 @@ static void UI_AlignElement(ui_element* E);
 static ui_element* UI_InitInteractable(u32 ID, i32* Prev);
 static ui_element* UI_PushElement();
 static void UI_FreeElement(ui_element* E);
+static void UI_RenderPlot(ui_element* E);
 
 // NOTE(lucas): Get container size based on the container size mode
 v2 UI_GetContainerSize(ui_element* E) {
@@ -444,6 +445,21 @@ i32 UI_DoTextToggle(u32 ID, const char* Text, u8* Value) {
   return E->Released;
 }
 
+i32 UI_DoPlot(u32 ID, v2 Size, const f32* Values, i32 Count, v3 Color, u8 Fill) {
+  i32 Prev = 0;
+  ui_element* E = UI_InitInteractable(ID, &Prev);
+  if (!Prev) {
+    UI_InitElement(E, ID, Size, ELEMENT_PLOT);
+    E->Color = UIColorContainerBright;
+  }
+  E->Data.PlotValues = Values;
+  E->Data.PlotCount = Count;
+  E->Data.PlotColor = Color;
+  E->Data.PlotFill = Fill;
+  UI_Interaction(E);
+  return E->Released;
+}
+
 void UI_SetPlacement(element_placement_mode Mode) {
   UI.PlacementMode = Mode;
 }
@@ -451,6 +467,26 @@ void UI_SetPlacement(element_placement_mode Mode) {
 void UI_WindowResizeCallback(i32 Width, i32 Height) {
 }
 
+// NOTE(lucas): Lines are drawn as columns from the previous value, so that steep slopes stay connected
+void UI_RenderPlot(ui_element* E) {
+  const f32* Values = E->Data.PlotValues;
+  i32 Count = E->Data.PlotCount;
+  if (!Values || Count <= 0) {
+    return;
+  }
+  f32 Width = E->Size.W / Count;
+  f32 Height = E->Size.H;
+  f32 Prev = Clamp(Values[0], 0.0f, 1.0f);
+  for (i32 Index = 0; Index < Count; ++Index) {
+    f32 Value = Clamp(Values[Index], 0.0f, 1.0f);
+    f32 Top = E->Data.PlotFill ? Value : Max(Value, Prev);
+    f32 Bottom = E->Data.PlotFill ? 0.0f : Min(Value, Prev);
+    v3 P = V3(E->P.X + Index * Width, E->P.Y + (1.0f - Top) * Height, E->P.Z + 0.01f);
+    DrawRect(P, V2(Max(Width, 1.0f), Max((Top - Bottom) * Height, 1.0f)), E->Data.PlotColor);
+    Prev = Value;
+  }
+}
+
 // TODO(lucas): Implement "scissoring"/clipping of 2d elements
 void UI_Render() {
   v4 DefaultClipping = Clip;
@@ -492,6 +528,9 @@ void UI_Render() {
       }
       v3 P = E->P;
       DrawRectangle(P, E->Size, Color, BorderColor, E->BorderThickness, 0);
+      if (E->Type == ELEMENT_PLOT) {
+        UI_RenderPlot(E);
+      }
       if (E->DrawText) {
         v3 TextP = P;
         TextP.Y += E->Size.H / 2.0f - UITextSize / 2.0f;
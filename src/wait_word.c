@@ -0,0 +1,69 @@
+// wait_word.c
+
+#if __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+void WaitWordInit(wait_word* Word, u32 Value) {
+  atomic_init(&Word->Value, Value);
+  atomic_init(&Word->Sleepers, 0);
+#if !__linux__
+  pthread_mutex_init(&Word->Lock, NULL);
+  pthread_cond_init(&Word->Changed, NULL);
+#endif
+}
+
+// NOTE(lucas): The sleeper is counted before the value is checked, so a waker either sees it or it sees the new value
+void WaitWordSleep(wait_word* Word, u32 Expected, i32 TimeoutMs) {
+  atomic_fetch_add(&Word->Sleepers, 1);
+#if __linux__
+  struct timespec Timeout = { .tv_sec = TimeoutMs / 1000, .tv_nsec = (TimeoutMs % 1000) * 1000000L };
+  if (atomic_load(&Word->Value) == Expected) {
+    syscall(SYS_futex, &Word->Value, FUTEX_WAIT_PRIVATE, Expected, TimeoutMs > 0 ? &Timeout : NULL, NULL, 0);
+  }
+#else
+  pthread_mutex_lock(&Word->Lock);
+  if (atomic_load(&Word->Value) == Expected) {
+    if (TimeoutMs > 0) {
+      struct timeval Now;
+      gettimeofday(&Now, NULL);
+      i64 Nanoseconds = (i64)Now.tv_usec * 1000 + (i64)TimeoutMs * 1000000;
+      struct timespec Deadline = { .tv_sec = Now.tv_sec + Nanoseconds / 1000000000, .tv_nsec = Nanoseconds % 1000000000 };
+      pthread_cond_timedwait(&Word->Changed, &Word->Lock, &Deadline);
+    }
+    else {
+      pthread_cond_wait(&Word->Changed, &Word->Lock);
+    }
+  }
+  pthread_mutex_unlock(&Word->Lock);
+#endif
+  atomic_fetch_sub(&Word->Sleepers, 1);
+}
+
+void WaitWordWake(wait_word* Word, i32 Count) {
+  if (atomic_load(&Word->Sleepers) == 0) {
+    return;
+  }
+#if __linux__
+  syscall(SYS_futex, &Word->Value, FUTEX_WAKE_PRIVATE, Count, NULL, NULL, 0);
+#else
+  pthread_mutex_lock(&Word->Lock);
+  if (Count == 1) {
+    pthread_cond_signal(&Word->Changed);
+  }
+  else {
+    pthread_cond_broadcast(&Word->Changed);
+  }
+  pthread_mutex_unlock(&Word->Lock);
+#endif
+}
+
+void WaitWordFree(wait_word* Word) {
+#if !__linux__
+  pthread_mutex_destroy(&Word->Lock);
+  pthread_cond_destroy(&Word->Changed);
+#else
+  (void)Word;
+#endif
+}
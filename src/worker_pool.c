@@ -0,0 +1,131 @@
+// worker_pool.c
+// persistent pool of worker threads, used to process independent jobs in parallel on the audio thread
+
+// NOTE(lucas): Jobs come once per callback, spinning through the whole buffer period would only burn cpu time
+#define WORKER_SPIN_COUNT (1 << 14)
+
+static void CpuRelax();
+static void WorkerSleep(worker_pool* Pool, u32 Generation);
+static void WorkerWake(worker_pool* Pool);
+static void ProcessJobs(worker_pool* Pool, u32 Generation);
+static void* WorkerThread(void* PoolData);
+
+void CpuRelax() {
+#if USE_SSE
+  _mm_pause();
+#endif
+}
+
+void WorkerSleep(worker_pool* Pool, u32 Generation) {
+  WaitWordSleep(&Pool->Signal, Generation, 0);
+}
+
+void WorkerWake(worker_pool* Pool) {
+  WaitWordWake(&Pool->Signal, INT32_MAX);
+}
+
+// NOTE(lucas): The generation in the high half keeps a late worker from claiming jobs of a batch that is done
+void ProcessJobs(worker_pool* Pool, u32 Generation) {
+  for (;;) {
+    u64 Work = atomic_load_explicit(&Pool->Work, memory_order_acquire);
+    if ((u32)(Work >> 32) != Generation) {
+      break;
+    }
+    i32 JobIndex = (i32)(Work & 0xffffffff);
+    if (JobIndex >= atomic_load_explicit(&Pool->JobCount, memory_order_relaxed)) {
+      break;
+    }
+    if (atomic_compare_exchange_weak_explicit(&Pool->Work, &Work, Work + 1, memory_order_acquire, memory_order_relaxed)) {
+      Pool->Job(Pool->Data, JobIndex);
+      atomic_fetch_add_explicit(&Pool->JobsDone, 1, memory_order_release);
+    }
+  }
+}
+
+void* WorkerThread(void* PoolData) {
+  worker_pool* Pool = (worker_pool*)PoolData;
+  u32 Generation = atomic_load(&Pool->Signal.Value);
+  AudioThreadSetupWorker(atomic_fetch_add(&Pool->Started, 1));
+
+  while (!atomic_load_explicit(&Pool->ShouldExit, memory_order_relaxed)) {
+    u32 Spin = 0;
+    u32 Next = Generation;
+    while ((Next = atomic_load_explicit(&Pool->Signal.Value, memory_order_acquire)) == Generation) {
+      if (++Spin < WORKER_SPIN_COUNT) {
+        CpuRelax();
+      }
+      else {
+        WorkerSleep(Pool, Generation);
+        Spin = 0;
+      }
+      if (atomic_load_explicit(&Pool->ShouldExit, memory_order_relaxed)) {
+        return NULL;
+      }
+    }
+    Generation = Next;
+    RtEnterAudioThread();
+    ProcessJobs(Pool, Generation);
+    RtLeaveAudioThread();
+  }
+  return NULL;
+}
+
+i32 WorkerPoolInit(worker_pool* Pool, i32 WorkerCount) {
+  if (WorkerCount < 0) {
+    WorkerCount = sysconf(_SC_NPROCESSORS_ONLN) - 1;
+  }
+  if (WorkerCount > MAX_WORKER_THREAD) {
+    WorkerCount = MAX_WORKER_THREAD;
+  }
+  Pool->WorkerCount = 0;
+  Pool->Job = NULL;
+  Pool->Data = NULL;
+  atomic_init(&Pool->JobCount, 0);
+  atomic_init(&Pool->JobsDone, 0);
+  atomic_init(&Pool->Work, 0);
+  WaitWordInit(&Pool->Signal, 0);
+  atomic_init(&Pool->Started, 0);
+  atomic_init(&Pool->ShouldExit, 0);
+
+  for (i32 WorkerIndex = 0; WorkerIndex < WorkerCount; ++WorkerIndex) {
+    pthread_t* Thread = &Pool->Threads[Pool->WorkerCount];
+    if (pthread_create(Thread, NULL, WorkerThread, (void*)Pool) != 0) {
+      fprintf(stderr, "Failed to create worker thread (%i)\n", WorkerIndex);
+      break;
+    }
+    Pool->WorkerCount++;
+  }
+  return NoError;
+}
+
+void WorkerPoolRun(worker_pool* Pool, worker_job_cb Job, void* Data, i32 JobCount) {
+  if (JobCount <= 0) {
+    return;
+  }
+  u32 Generation = atomic_load_explicit(&Pool->Signal.Value, memory_order_relaxed) + 1;
+  Pool->Job = Job;
+  Pool->Data = Data;
+  atomic_store_explicit(&Pool->JobCount, JobCount, memory_order_relaxed);
+  atomic_store_explicit(&Pool->JobsDone, 0, memory_order_relaxed);
+  atomic_store_explicit(&Pool->Work, (u64)Generation << 32, memory_order_release);
+  atomic_store(&Pool->Signal.Value, Generation);
+  WorkerWake(Pool);
+
+  ProcessJobs(Pool, Generation);
+
+  // Barrier, every job has been claimed at this point so we only wait for the ones that are still in flight
+  while (atomic_load_explicit(&Pool->JobsDone, memory_order_acquire) < JobCount) {
+    CpuRelax();
+  }
+}
+
+void WorkerPoolFree(worker_pool* Pool) {
+  atomic_store(&Pool->ShouldExit, 1);
+  atomic_fetch_add(&Pool->Signal.Value, 1);
+  for (i32 WorkerIndex = 0; WorkerIndex < Pool->WorkerCount; ++WorkerIndex) {
+    WorkerWake(Pool);
+    pthread_join(Pool->Threads[WorkerIndex], NULL);
+  }
+  Pool->WorkerCount = 0;
+  WaitWordFree(&Pool->Signal);
+}